@@ -38,6 +38,7 @@ and get deterministic behaviour.
 #include "Dither.h"
 
 #include "Internat.h"
+#include "MixKernels.h"
 #include "Prefs.h"
 
 // Erik de Castro Lopo's header file that
@@ -45,6 +46,7 @@ and get deterministic behaviour.
 // (Note: this file should be included first)
 #include "float_cast.h"
 
+#include <algorithm>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
@@ -179,6 +181,43 @@ static inline void DITHER( Ditherer dither, State &state,
 }
 
 
+// Convert float samples to 16 or 24 bits, with noise of a dither that
+// doesn't depend on the converted samples
+static void DitherFloats(DitherType ditherType, State &state,
+   const float *src, samplePtr dst, sampleFormat dstFormat,
+   size_t len, size_t dstStride)
+{
+    constexpr size_t ChunkSize = 256;
+    float noise[ChunkSize];
+    for (size_t done = 0; done < len;) {
+        const auto count = std::min(ChunkSize, len - done);
+        const float *pNoise = nullptr;
+        if (ditherType == DitherType::rectangle) {
+            for (size_t ii = 0; ii < count; ++ii)
+                noise[ii] = -DITHER_NOISE();
+            pNoise = noise;
+        }
+        else if (ditherType == DitherType::triangle) {
+            // High pass filtered, as in TriangleDither
+            for (size_t ii = 0; ii < count; ++ii) {
+                const float r = DITHER_NOISE();
+                noise[ii] = r - state.mTriangleState;
+                state.mTriangleState = r;
+            }
+            pNoise = noise;
+        }
+
+        if (dstFormat == int16Sample)
+            FloatsToInt16(reinterpret_cast<short*>(dst) + done * dstStride,
+                dstStride, src + done, pNoise, count);
+        else if (dstFormat == int24Sample)
+            FloatsToInt24(reinterpret_cast<int*>(dst) + done * dstStride,
+                dstStride, src + done, pNoise, count);
+        else { wxASSERT(false); }
+        done += count;
+    }
+}
+
 static inline float NoDither(State &, float sample);
 static inline float RectangleDither(State &, float sample);
 static inline float TriangleDither(State &state, float sample);
@@ -301,6 +340,17 @@ void Dither::Apply(enum DitherType ditherType,
         for (i = 0; i < len; i++, d += destStride, s += sourceStride)
             *d = ((int)*s) << 8;
     } else
+    if (sourceFormat == floatSample && sourceStride == 1 &&
+        ditherType != DitherType::shaped)
+    {
+        // These dithers don't depend on the output, so the noise can be
+        // made first and the conversion vectorized
+        if (ditherType == DitherType::triangle)
+            Reset(); // reset dither filter for this NEW conversion
+        DitherFloats(ditherType, mState,
+            reinterpret_cast<const float*>(source), dest, destFormat,
+            len, destStride);
+    } else
     {
         // We must do dithering
         switch (ditherType)
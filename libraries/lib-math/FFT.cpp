@@ -50,6 +50,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <mutex>
 
 #include "RealFFTf.h"
 
@@ -141,8 +142,10 @@ void FFT(size_t NumSamples,
       exit(1);
    }
 
-   if (!gFFTBitTable)
-      InitFFT();
+   // Spectra may be computed in several threads at once; make the table
+   // only once, without locking in later calls
+   static std::once_flag initFlag;
+   std::call_once(initFlag, InitFFT);
 
    if (!InverseTransform)
       angle_numerator = -angle_numerator;
@@ -0,0 +1,397 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file MixKernels.cpp
+  @brief Vectorized loops for mixing float samples and converting them to
+  integer formats
+
+**********************************************************************/
+
+#include "MixKernels.h"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef AUDACITY_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Scales and bounds of the integer formats
+constexpr float Int16Scale = float(1 << 15);
+constexpr float Int16Min = -32768.0f, Int16Max = 32767.0f;
+constexpr float Int24Scale = float(1 << 23);
+constexpr float Int24Min = -8388608.0f, Int24Max = 8388607.0f;
+
+// Clamping before rounding gives the same as clamping the rounded integer,
+// because the bounds are integers.  NaN becomes the minimum, as lrintf and
+// clamping would make it.
+inline float ScaleSample(float sample, float scale, float noise,
+   float min, float max)
+{
+   sample = !(sample >= -1.0f) ? -1.0f : sample > 1.0f ? 1.0f : sample;
+   const auto value = sample * scale + noise;
+   return value < min ? min : value > max ? max : value;
+}
+
+void ScalarAccumulateScaled(
+   float *dest, const float *src, float gain, size_t len)
+{
+   for (size_t ii = 0; ii < len; ++ii)
+      dest[ii] += src[ii] * gain;
+}
+
+void ScalarInterleaveFloats(
+   float *dest, const float *const *srcs, size_t nChannels, size_t len)
+{
+   for (size_t c = 0; c < nChannels; ++c) {
+      const auto src = srcs[c];
+      auto d = dest + c;
+      for (size_t ii = 0; ii < len; ++ii, d += nChannels)
+         *d = src[ii];
+   }
+}
+
+template<typename Int>
+void ScalarFloatsToInt(Int *dest, size_t destStride,
+   const float *src, const float *noise, size_t len,
+   float scale, float min, float max)
+{
+   for (size_t ii = 0; ii < len; ++ii, dest += destStride)
+      *dest = static_cast<Int>(lrintf(ScaleSample(src[ii], scale,
+         noise ? noise[ii] : 0.0f, min, max)));
+}
+
+void ScalarFloatsToInt16(short *dest, size_t destStride,
+   const float *src, const float *noise, size_t len)
+{
+   ScalarFloatsToInt(dest, destStride, src, noise, len,
+      Int16Scale, Int16Min, Int16Max);
+}
+
+void ScalarFloatsToInt24(int *dest, size_t destStride,
+   const float *src, const float *noise, size_t len)
+{
+   ScalarFloatsToInt(dest, destStride, src, noise, len,
+      Int24Scale, Int24Min, Int24Max);
+}
+
+#ifdef AUDACITY_SIMD_X86
+
+AUDACITY_SIMD_TARGET("sse2")
+void SSE2AccumulateScaled(
+   float *dest, const float *src, float gain, size_t len)
+{
+   constexpr size_t Width = 8;
+   const size_t vectorLen = len - len % Width;
+   const __m128 vgain = _mm_set1_ps(gain);
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      const __m128 x0 = _mm_mul_ps(_mm_loadu_ps(src + ii), vgain);
+      const __m128 x1 = _mm_mul_ps(_mm_loadu_ps(src + ii + 4), vgain);
+      _mm_storeu_ps(dest + ii, _mm_add_ps(_mm_loadu_ps(dest + ii), x0));
+      _mm_storeu_ps(dest + ii + 4,
+         _mm_add_ps(_mm_loadu_ps(dest + ii + 4), x1));
+   }
+   ScalarAccumulateScaled(
+      dest + vectorLen, src + vectorLen, gain, len - vectorLen);
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+void AVX2AccumulateScaled(
+   float *dest, const float *src, float gain, size_t len)
+{
+   // Multiply and add separately, not fused, to round as the scalar loop
+   constexpr size_t Width = 16;
+   const size_t vectorLen = len - len % Width;
+   const __m256 vgain = _mm256_set1_ps(gain);
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      const __m256 x0 = _mm256_mul_ps(_mm256_loadu_ps(src + ii), vgain);
+      const __m256 x1 = _mm256_mul_ps(_mm256_loadu_ps(src + ii + 8), vgain);
+      _mm256_storeu_ps(dest + ii,
+         _mm256_add_ps(_mm256_loadu_ps(dest + ii), x0));
+      _mm256_storeu_ps(dest + ii + 8,
+         _mm256_add_ps(_mm256_loadu_ps(dest + ii + 8), x1));
+   }
+   ScalarAccumulateScaled(
+      dest + vectorLen, src + vectorLen, gain, len - vectorLen);
+}
+
+AUDACITY_SIMD_TARGET("sse2")
+void SSE2InterleaveFloats(
+   float *dest, const float *const *srcs, size_t nChannels, size_t len)
+{
+   if (nChannels != 2)
+      return ScalarInterleaveFloats(dest, srcs, nChannels, len);
+
+   constexpr size_t Width = 4;
+   const size_t vectorLen = len - len % Width;
+   const auto left = srcs[0], right = srcs[1];
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      const __m128 l = _mm_loadu_ps(left + ii);
+      const __m128 r = _mm_loadu_ps(right + ii);
+      _mm_storeu_ps(dest + 2 * ii, _mm_unpacklo_ps(l, r));
+      _mm_storeu_ps(dest + 2 * ii + 4, _mm_unpackhi_ps(l, r));
+   }
+   const float *const rest[]{ left + vectorLen, right + vectorLen };
+   ScalarInterleaveFloats(dest + 2 * vectorLen, rest, 2, len - vectorLen);
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+void AVX2InterleaveFloats(
+   float *dest, const float *const *srcs, size_t nChannels, size_t len)
+{
+   if (nChannels != 2)
+      return ScalarInterleaveFloats(dest, srcs, nChannels, len);
+
+   constexpr size_t Width = 8;
+   const size_t vectorLen = len - len % Width;
+   const auto left = srcs[0], right = srcs[1];
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      const __m256 l = _mm256_loadu_ps(left + ii);
+      const __m256 r = _mm256_loadu_ps(right + ii);
+      // Unpacking works within 128 bit lanes; then exchange the lanes
+      const __m256 lo = _mm256_unpacklo_ps(l, r);
+      const __m256 hi = _mm256_unpackhi_ps(l, r);
+      _mm256_storeu_ps(dest + 2 * ii, _mm256_permute2f128_ps(lo, hi, 0x20));
+      _mm256_storeu_ps(dest + 2 * ii + 8,
+         _mm256_permute2f128_ps(lo, hi, 0x31));
+   }
+   const float *const rest[]{ left + vectorLen, right + vectorLen };
+   ScalarInterleaveFloats(dest + 2 * vectorLen, rest, 2, len - vectorLen);
+}
+
+// Vector version of ScaleSample, then round with the current mode, as
+// lrintf does
+AUDACITY_SIMD_TARGET("sse2")
+inline __m128i SSE2ScaleSamples(const float *src, const float *noise,
+   __m128 scale, __m128 min, __m128 max)
+{
+   // _mm_max_ps gives the second operand, -1, for NaN
+   __m128 x = _mm_min_ps(
+      _mm_max_ps(_mm_loadu_ps(src), _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+   x = _mm_mul_ps(x, scale);
+   if (noise)
+      x = _mm_add_ps(x, _mm_loadu_ps(noise));
+   return _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(x, min), max));
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+inline __m256i AVX2ScaleSamples(const float *src, const float *noise,
+   __m256 scale, __m256 min, __m256 max)
+{
+   __m256 x = _mm256_min_ps(
+      _mm256_max_ps(_mm256_loadu_ps(src), _mm256_set1_ps(-1.0f)),
+      _mm256_set1_ps(1.0f));
+   x = _mm256_mul_ps(x, scale);
+   if (noise)
+      x = _mm256_add_ps(x, _mm256_loadu_ps(noise));
+   return _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(x, min), max));
+}
+
+template<typename Int>
+inline void Scatter(Int *dest, size_t destStride, const int *ints, size_t n)
+{
+   for (size_t ii = 0; ii < n; ++ii, dest += destStride)
+      *dest = static_cast<Int>(ints[ii]);
+}
+
+AUDACITY_SIMD_TARGET("sse2")
+void SSE2FloatsToInt16(short *dest, size_t destStride,
+   const float *src, const float *noise, size_t len)
+{
+   constexpr size_t Width = 8;
+   const size_t vectorLen = len - len % Width;
+   const __m128 scale = _mm_set1_ps(Int16Scale);
+   const __m128 min = _mm_set1_ps(Int16Min), max = _mm_set1_ps(Int16Max);
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      const auto n = noise ? noise + ii : nullptr;
+      const __m128i i0 = SSE2ScaleSamples(src + ii, n, scale, min, max);
+      const __m128i i1 = SSE2ScaleSamples(src + ii + 4,
+         n ? n + 4 : nullptr, scale, min, max);
+      if (destStride == 1)
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + ii),
+            _mm_packs_epi32(i0, i1));
+      else {
+         alignas(16) int ints[Width];
+         _mm_store_si128(reinterpret_cast<__m128i*>(ints), i0);
+         _mm_store_si128(reinterpret_cast<__m128i*>(ints + 4), i1);
+         Scatter(dest + ii * destStride, destStride, ints, Width);
+      }
+   }
+   ScalarFloatsToInt16(dest + vectorLen * destStride, destStride,
+      src + vectorLen, noise ? noise + vectorLen : nullptr, len - vectorLen);
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+void AVX2FloatsToInt16(short *dest, size_t destStride,
+   const float *src, const float *noise, size_t len)
+{
+   constexpr size_t Width = 16;
+   const size_t vectorLen = len - len % Width;
+   const __m256 scale = _mm256_set1_ps(Int16Scale);
+   const __m256 min = _mm256_set1_ps(Int16Min);
+   const __m256 max = _mm256_set1_ps(Int16Max);
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      const auto n = noise ? noise + ii : nullptr;
+      const __m256i i0 = AVX2ScaleSamples(src + ii, n, scale, min, max);
+      const __m256i i1 = AVX2ScaleSamples(src + ii + 8,
+         n ? n + 8 : nullptr, scale, min, max);
+      if (destStride == 1) {
+         // Packing works within 128 bit lanes; then put the quarters in order
+         const __m256i packed = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(i0, i1), 0xD8);
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + ii), packed);
+      }
+      else {
+         alignas(32) int ints[Width];
+         _mm256_store_si256(reinterpret_cast<__m256i*>(ints), i0);
+         _mm256_store_si256(reinterpret_cast<__m256i*>(ints + 8), i1);
+         Scatter(dest + ii * destStride, destStride, ints, Width);
+      }
+   }
+   ScalarFloatsToInt16(dest + vectorLen * destStride, destStride,
+      src + vectorLen, noise ? noise + vectorLen : nullptr, len - vectorLen);
+}
+
+AUDACITY_SIMD_TARGET("sse2")
+void SSE2FloatsToInt24(int *dest, size_t destStride,
+   const float *src, const float *noise, size_t len)
+{
+   constexpr size_t Width = 4;
+   const size_t vectorLen = len - len % Width;
+   const __m128 scale = _mm_set1_ps(Int24Scale);
+   const __m128 min = _mm_set1_ps(Int24Min), max = _mm_set1_ps(Int24Max);
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      const __m128i ints = SSE2ScaleSamples(src + ii,
+         noise ? noise + ii : nullptr, scale, min, max);
+      if (destStride == 1)
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + ii), ints);
+      else {
+         alignas(16) int buffer[Width];
+         _mm_store_si128(reinterpret_cast<__m128i*>(buffer), ints);
+         Scatter(dest + ii * destStride, destStride, buffer, Width);
+      }
+   }
+   ScalarFloatsToInt24(dest + vectorLen * destStride, destStride,
+      src + vectorLen, noise ? noise + vectorLen : nullptr, len - vectorLen);
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+void AVX2FloatsToInt24(int *dest, size_t destStride,
+   const float *src, const float *noise, size_t len)
+{
+   constexpr size_t Width = 8;
+   const size_t vectorLen = len - len % Width;
+   const __m256 scale = _mm256_set1_ps(Int24Scale);
+   const __m256 min = _mm256_set1_ps(Int24Min);
+   const __m256 max = _mm256_set1_ps(Int24Max);
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      const __m256i ints = AVX2ScaleSamples(src + ii,
+         noise ? noise + ii : nullptr, scale, min, max);
+      if (destStride == 1)
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + ii), ints);
+      else {
+         alignas(32) int buffer[Width];
+         _mm256_store_si256(reinterpret_cast<__m256i*>(buffer), ints);
+         Scatter(dest + ii * destStride, destStride, buffer, Width);
+      }
+   }
+   ScalarFloatsToInt24(dest + vectorLen * destStride, destStride,
+      src + vectorLen, noise ? noise + vectorLen : nullptr, len - vectorLen);
+}
+
+#endif
+
+// Choose among the versions of a kernel
+template<typename Kernel>
+Kernel Choose(SimdLevel level, Kernel scalar, Kernel sse2, Kernel avx2)
+{
+   switch (level) {
+   case SimdLevel::AVX2:
+      return avx2;
+   case SimdLevel::SSE2:
+      return sse2;
+   default:
+      return scalar;
+   }
+}
+
+#ifdef AUDACITY_SIMD_X86
+#define KERNELS(name) Scalar ## name, SSE2 ## name, AVX2 ## name
+#else
+#define KERNELS(name) Scalar ## name, Scalar ## name, Scalar ## name
+#endif
+
+auto GetAccumulateScaled(SimdLevel level)
+{
+   return Choose(level, KERNELS(AccumulateScaled));
+}
+
+auto GetInterleaveFloats(SimdLevel level)
+{
+   return Choose(level, KERNELS(InterleaveFloats));
+}
+
+auto GetFloatsToInt16(SimdLevel level)
+{
+   return Choose(level, KERNELS(FloatsToInt16));
+}
+
+auto GetFloatsToInt24(SimdLevel level)
+{
+   return Choose(level, KERNELS(FloatsToInt24));
+}
+}
+
+void AccumulateScaled(float *dest, const float *src, float gain, size_t len)
+{
+   static const auto kernel = GetAccumulateScaled(GetSimdLevel());
+   kernel(dest, src, gain, len);
+}
+
+void AccumulateScaled(
+   float *dest, const float *src, float gain, size_t len, SimdLevel level)
+{
+   GetAccumulateScaled(level)(dest, src, gain, len);
+}
+
+void InterleaveFloats(
+   float *dest, const float *const *srcs, size_t nChannels, size_t len)
+{
+   static const auto kernel = GetInterleaveFloats(GetSimdLevel());
+   kernel(dest, srcs, nChannels, len);
+}
+
+void InterleaveFloats(float *dest, const float *const *srcs,
+   size_t nChannels, size_t len, SimdLevel level)
+{
+   GetInterleaveFloats(level)(dest, srcs, nChannels, len);
+}
+
+void FloatsToInt16(short *dest, size_t destStride,
+   const float *src, const float *noise, size_t len)
+{
+   static const auto kernel = GetFloatsToInt16(GetSimdLevel());
+   kernel(dest, destStride, src, noise, len);
+}
+
+void FloatsToInt16(short *dest, size_t destStride,
+   const float *src, const float *noise, size_t len, SimdLevel level)
+{
+   GetFloatsToInt16(level)(dest, destStride, src, noise, len);
+}
+
+void FloatsToInt24(int *dest, size_t destStride,
+   const float *src, const float *noise, size_t len)
+{
+   static const auto kernel = GetFloatsToInt24(GetSimdLevel());
+   kernel(dest, destStride, src, noise, len);
+}
+
+void FloatsToInt24(int *dest, size_t destStride,
+   const float *src, const float *noise, size_t len, SimdLevel level)
+{
+   GetFloatsToInt24(level)(dest, destStride, src, noise, len);
+}
@@ -0,0 +1,64 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file MixKernels.h
+  @brief Vectorized loops for mixing float samples and converting them to
+  integer formats
+
+**********************************************************************/
+
+#ifndef __AUDACITY_MIX_KERNELS__
+#define __AUDACITY_MIX_KERNELS__
+
+#include <cstddef>
+
+#include "Simd.h"
+
+//! dest[i] += gain * src[i], with the best instructions that GetSimdLevel()
+//! allows
+/*! Results are the same for all levels */
+MATH_API void AccumulateScaled(
+   float *dest, const float *src, float gain, size_t len);
+
+//! dest[i] += gain * src[i], with the given instructions
+/*! @pre level <= GetSimdLevel() */
+MATH_API void AccumulateScaled(
+   float *dest, const float *src, float gain, size_t len, SimdLevel level);
+
+//! dest[nChannels * i + c] = srcs[c][i], with the best instructions that
+//! GetSimdLevel() allows
+MATH_API void InterleaveFloats(
+   float *dest, const float *const *srcs, size_t nChannels, size_t len);
+
+//! Interleave with the given instructions
+/*! @pre level <= GetSimdLevel() */
+MATH_API void InterleaveFloats(float *dest, const float *const *srcs,
+   size_t nChannels, size_t len, SimdLevel level);
+
+//! Clip samples to [-1, 1], scale them to 16 bit integers, add noise in
+//! units of the least significant bit, and round, saturating
+/*!
+ @param noise may be null for no noise
+ @param destStride distance between destination samples, for interleaving
+ Results are the same for all levels, and the same as with Dither::Apply
+ without dither
+ */
+MATH_API void FloatsToInt16(short *dest, size_t destStride,
+   const float *src, const float *noise, size_t len);
+
+//! Convert to 16 bits with the given instructions
+/*! @pre level <= GetSimdLevel() */
+MATH_API void FloatsToInt16(short *dest, size_t destStride,
+   const float *src, const float *noise, size_t len, SimdLevel level);
+
+//! Like FloatsToInt16, but for 24 bit samples stored in int
+MATH_API void FloatsToInt24(int *dest, size_t destStride,
+   const float *src, const float *noise, size_t len);
+
+//! Convert to 24 bits with the given instructions
+/*! @pre level <= GetSimdLevel() */
+MATH_API void FloatsToInt24(int *dest, size_t destStride,
+   const float *src, const float *noise, size_t len, SimdLevel level);
+
+#endif
@@ -0,0 +1,193 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file RampKernels.cpp
+  @brief Vectorized loops filling linear and exponential ramps, as for
+  interpolation of envelopes
+
+**********************************************************************/
+
+#include "RampKernels.h"
+
+#include <algorithm>
+
+#ifdef AUDACITY_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+//! Number of interleaved chains of multiplications in exponential ramps,
+//! which is the width of the widest vector of doubles
+constexpr size_t Chains = 4;
+
+void ScalarFillLinearRamp(double *dest, double start, double step, size_t len)
+{
+   for (size_t ii = 0; ii < len; ++ii)
+      dest[ii] = start + static_cast<double>(ii) * step;
+}
+
+//! Fill the first Chains values, or fewer, and return ratio^Chains
+double StartExponentialRamp(
+   double *dest, double start, double ratio, size_t len)
+{
+   const auto n = std::min(len, Chains);
+   for (size_t ii = 0; ii < n; ++ii, start *= ratio)
+      dest[ii] = start;
+   const auto square = ratio * ratio;
+   return square * square;
+}
+
+//! Continue the chains from ii, each value a multiple of that Chains before
+void FinishExponentialRamp(double *dest, double factor, size_t ii, size_t len)
+{
+   for (; ii < len; ++ii)
+      dest[ii] = dest[ii - Chains] * factor;
+}
+
+void ScalarFillExponentialRamp(
+   double *dest, double start, double ratio, size_t len)
+{
+   const auto factor = StartExponentialRamp(dest, start, ratio, len);
+   FinishExponentialRamp(dest, factor, Chains, len);
+}
+
+#ifdef AUDACITY_SIMD_X86
+
+AUDACITY_SIMD_TARGET("sse2")
+void SSE2FillLinearRamp(double *dest, double start, double step, size_t len)
+{
+   constexpr size_t Width = 4;
+   const size_t vectorLen = len - len % Width;
+   const __m128d vstart = _mm_set1_pd(start);
+   const __m128d vstep = _mm_set1_pd(step);
+   const __m128d advance = _mm_set1_pd(static_cast<double>(Width));
+   // Indices are exact in doubles, so the values are as in the scalar loop
+   __m128d i0 = _mm_setr_pd(0, 1), i1 = _mm_setr_pd(2, 3);
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      _mm_storeu_pd(dest + ii, _mm_add_pd(vstart, _mm_mul_pd(i0, vstep)));
+      _mm_storeu_pd(dest + ii + 2, _mm_add_pd(vstart, _mm_mul_pd(i1, vstep)));
+      i0 = _mm_add_pd(i0, advance);
+      i1 = _mm_add_pd(i1, advance);
+   }
+   for (size_t ii = vectorLen; ii < len; ++ii)
+      dest[ii] = start + static_cast<double>(ii) * step;
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+void AVX2FillLinearRamp(double *dest, double start, double step, size_t len)
+{
+   // Multiply and add separately, not fused, to round as the scalar loop
+   constexpr size_t Width = 8;
+   const size_t vectorLen = len - len % Width;
+   const __m256d vstart = _mm256_set1_pd(start);
+   const __m256d vstep = _mm256_set1_pd(step);
+   const __m256d advance = _mm256_set1_pd(static_cast<double>(Width));
+   __m256d i0 = _mm256_setr_pd(0, 1, 2, 3), i1 = _mm256_setr_pd(4, 5, 6, 7);
+   for (size_t ii = 0; ii < vectorLen; ii += Width) {
+      _mm256_storeu_pd(dest + ii,
+         _mm256_add_pd(vstart, _mm256_mul_pd(i0, vstep)));
+      _mm256_storeu_pd(dest + ii + 4,
+         _mm256_add_pd(vstart, _mm256_mul_pd(i1, vstep)));
+      i0 = _mm256_add_pd(i0, advance);
+      i1 = _mm256_add_pd(i1, advance);
+   }
+   for (size_t ii = vectorLen; ii < len; ++ii)
+      dest[ii] = start + static_cast<double>(ii) * step;
+}
+
+AUDACITY_SIMD_TARGET("sse2")
+void SSE2FillExponentialRamp(
+   double *dest, double start, double ratio, size_t len)
+{
+   const auto factor = StartExponentialRamp(dest, start, ratio, len);
+   if (len <= Chains)
+      return;
+   // Two vectors hold the four chains
+   const size_t vectorLen = len - len % Chains;
+   const __m128d vfactor = _mm_set1_pd(factor);
+   __m128d v0 = _mm_loadu_pd(dest), v1 = _mm_loadu_pd(dest + 2);
+   for (size_t ii = Chains; ii < vectorLen; ii += Chains) {
+      v0 = _mm_mul_pd(v0, vfactor);
+      v1 = _mm_mul_pd(v1, vfactor);
+      _mm_storeu_pd(dest + ii, v0);
+      _mm_storeu_pd(dest + ii + 2, v1);
+   }
+   FinishExponentialRamp(dest, factor, vectorLen, len);
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+void AVX2FillExponentialRamp(
+   double *dest, double start, double ratio, size_t len)
+{
+   const auto factor = StartExponentialRamp(dest, start, ratio, len);
+   if (len <= Chains)
+      return;
+   // One vector holds the four chains
+   const size_t vectorLen = len - len % Chains;
+   const __m256d vfactor = _mm256_set1_pd(factor);
+   __m256d v = _mm256_loadu_pd(dest);
+   for (size_t ii = Chains; ii < vectorLen; ii += Chains) {
+      v = _mm256_mul_pd(v, vfactor);
+      _mm256_storeu_pd(dest + ii, v);
+   }
+   FinishExponentialRamp(dest, factor, vectorLen, len);
+}
+
+#endif
+
+// Choose among the versions of a kernel
+template<typename Kernel>
+Kernel Choose(SimdLevel level, Kernel scalar, Kernel sse2, Kernel avx2)
+{
+   switch (level) {
+   case SimdLevel::AVX2:
+      return avx2;
+   case SimdLevel::SSE2:
+      return sse2;
+   default:
+      return scalar;
+   }
+}
+
+#ifdef AUDACITY_SIMD_X86
+#define KERNELS(name) Scalar ## name, SSE2 ## name, AVX2 ## name
+#else
+#define KERNELS(name) Scalar ## name, Scalar ## name, Scalar ## name
+#endif
+
+auto GetFillLinearRamp(SimdLevel level)
+{
+   return Choose(level, KERNELS(FillLinearRamp));
+}
+
+auto GetFillExponentialRamp(SimdLevel level)
+{
+   return Choose(level, KERNELS(FillExponentialRamp));
+}
+}
+
+void FillLinearRamp(double *dest, double start, double step, size_t len)
+{
+   static const auto kernel = GetFillLinearRamp(GetSimdLevel());
+   kernel(dest, start, step, len);
+}
+
+void FillLinearRamp(
+   double *dest, double start, double step, size_t len, SimdLevel level)
+{
+   GetFillLinearRamp(level)(dest, start, step, len);
+}
+
+void FillExponentialRamp(double *dest, double start, double ratio, size_t len)
+{
+   static const auto kernel = GetFillExponentialRamp(GetSimdLevel());
+   kernel(dest, start, ratio, len);
+}
+
+void FillExponentialRamp(
+   double *dest, double start, double ratio, size_t len, SimdLevel level)
+{
+   GetFillExponentialRamp(level)(dest, start, ratio, len);
+}
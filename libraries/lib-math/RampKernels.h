@@ -0,0 +1,44 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file RampKernels.h
+  @brief Vectorized loops filling linear and exponential ramps, as for
+  interpolation of envelopes
+
+**********************************************************************/
+
+#ifndef __AUDACITY_RAMP_KERNELS__
+#define __AUDACITY_RAMP_KERNELS__
+
+#include <cstddef>
+
+#include "Simd.h"
+
+//! dest[i] = start + i * step, with the best instructions that GetSimdLevel()
+//! allows
+/*! Results are the same for all levels */
+MATH_API void FillLinearRamp(
+   double *dest, double start, double step, size_t len);
+
+//! Fill a linear ramp with the given instructions
+/*! @pre level <= GetSimdLevel() */
+MATH_API void FillLinearRamp(
+   double *dest, double start, double step, size_t len, SimdLevel level);
+
+//! dest[i] = start * ratio^i, with the best instructions that GetSimdLevel()
+//! allows
+/*!
+ Powers are made by multiplication in four interleaved chains, so that each
+ value has about i / 4 roundings, and no exp or log is needed.
+ Results are the same for all levels
+ */
+MATH_API void FillExponentialRamp(
+   double *dest, double start, double ratio, size_t len);
+
+//! Fill an exponential ramp with the given instructions
+/*! @pre level <= GetSimdLevel() */
+MATH_API void FillExponentialRamp(
+   double *dest, double start, double ratio, size_t len, SimdLevel level);
+
+#endif
@@ -0,0 +1,249 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SampleStatistics.cpp
+  @brief Vectorized reductions of runs of float samples
+
+**********************************************************************/
+
+#include "SampleStatistics.h"
+
+#include <algorithm>
+
+#ifdef AUDACITY_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+MinMaxSumSq ScalarMinMaxSumSq(const float *samples, size_t len)
+{
+   MinMaxSumSq result;
+   for (size_t ii = 0; ii < len; ++ii) {
+      const auto sample = samples[ii];
+      result.min = std::min(result.min, sample);
+      result.max = std::max(result.max, sample);
+      result.sumsq += sample * sample;
+   }
+   return result;
+}
+
+double ScalarSum(const float *samples, size_t len)
+{
+   double result = 0;
+   for (size_t ii = 0; ii < len; ++ii)
+      result += samples[ii];
+   return result;
+}
+
+#ifdef AUDACITY_SIMD_X86
+
+// Vector lanes accumulate squares in single precision for at most this many
+// samples before adding into the double precision total
+constexpr size_t ChunkSize = 1024;
+
+// Horizontal reductions of four lanes
+AUDACITY_SIMD_TARGET("sse2")
+inline float HorizontalMin(__m128 x)
+{
+   x = _mm_min_ps(x, _mm_movehl_ps(x, x));
+   x = _mm_min_ss(x, _mm_shuffle_ps(x, x, 1));
+   return _mm_cvtss_f32(x);
+}
+
+AUDACITY_SIMD_TARGET("sse2")
+inline float HorizontalMax(__m128 x)
+{
+   x = _mm_max_ps(x, _mm_movehl_ps(x, x));
+   x = _mm_max_ss(x, _mm_shuffle_ps(x, x, 1));
+   return _mm_cvtss_f32(x);
+}
+
+AUDACITY_SIMD_TARGET("sse2")
+inline double HorizontalSum(__m128 x)
+{
+   // Add pairs in double precision
+   const __m128d lo = _mm_cvtps_pd(x);
+   const __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+   const __m128d sum = _mm_add_pd(lo, hi);
+   return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+// Finish with the samples that don't fill a vector
+AUDACITY_SIMD_TARGET("sse2")
+inline MinMaxSumSq Finish(const float *samples, size_t len,
+   __m128 vmin, __m128 vmax, double sumsq)
+{
+   MinMaxSumSq result{ HorizontalMin(vmin), HorizontalMax(vmax), sumsq };
+   for (size_t ii = 0; ii < len; ++ii) {
+      const auto sample = samples[ii];
+      result.min = std::min(result.min, sample);
+      result.max = std::max(result.max, sample);
+      result.sumsq += sample * sample;
+   }
+   return result;
+}
+
+AUDACITY_SIMD_TARGET("sse2")
+MinMaxSumSq SSE2MinMaxSumSq(const float *samples, size_t len)
+{
+   constexpr size_t Width = 4;
+   const size_t vectorLen = len - len % Width;
+
+   __m128 vmin = _mm_set1_ps(FLT_MAX);
+   __m128 vmax = _mm_set1_ps(-FLT_MAX);
+   double sumsq = 0;
+   size_t ii = 0;
+   while (ii < vectorLen) {
+      const auto end = std::min(vectorLen, ii + ChunkSize);
+      __m128 vsum = _mm_setzero_ps();
+      for (; ii < end; ii += Width) {
+         const __m128 x = _mm_loadu_ps(samples + ii);
+         vmin = _mm_min_ps(vmin, x);
+         vmax = _mm_max_ps(vmax, x);
+         vsum = _mm_add_ps(vsum, _mm_mul_ps(x, x));
+      }
+      sumsq += HorizontalSum(vsum);
+   }
+
+   return Finish(samples + vectorLen, len - vectorLen, vmin, vmax, sumsq);
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+MinMaxSumSq AVX2MinMaxSumSq(const float *samples, size_t len)
+{
+   // Two independent accumulators of eight lanes each hide the latency of
+   // the additions
+   constexpr size_t Width = 16;
+   const size_t vectorLen = len - len % Width;
+
+   __m256 vmin0 = _mm256_set1_ps(FLT_MAX), vmin1 = vmin0;
+   __m256 vmax0 = _mm256_set1_ps(-FLT_MAX), vmax1 = vmax0;
+   double sumsq = 0;
+   size_t ii = 0;
+   while (ii < vectorLen) {
+      const auto end = std::min(vectorLen, ii + ChunkSize);
+      __m256 vsum0 = _mm256_setzero_ps(), vsum1 = vsum0;
+      for (; ii < end; ii += Width) {
+         const __m256 x0 = _mm256_loadu_ps(samples + ii);
+         const __m256 x1 = _mm256_loadu_ps(samples + ii + 8);
+         vmin0 = _mm256_min_ps(vmin0, x0);
+         vmin1 = _mm256_min_ps(vmin1, x1);
+         vmax0 = _mm256_max_ps(vmax0, x0);
+         vmax1 = _mm256_max_ps(vmax1, x1);
+         vsum0 = _mm256_add_ps(vsum0, _mm256_mul_ps(x0, x0));
+         vsum1 = _mm256_add_ps(vsum1, _mm256_mul_ps(x1, x1));
+      }
+      const __m256 vsum = _mm256_add_ps(vsum0, vsum1);
+      sumsq += HorizontalSum(_mm256_castps256_ps128(vsum)) +
+         HorizontalSum(_mm256_extractf128_ps(vsum, 1));
+   }
+
+   const __m256 vmin = _mm256_min_ps(vmin0, vmin1);
+   const __m256 vmax = _mm256_max_ps(vmax0, vmax1);
+   return Finish(samples + vectorLen, len - vectorLen,
+      _mm_min_ps(_mm256_castps256_ps128(vmin), _mm256_extractf128_ps(vmin, 1)),
+      _mm_max_ps(_mm256_castps256_ps128(vmax), _mm256_extractf128_ps(vmax, 1)),
+      sumsq);
+}
+
+AUDACITY_SIMD_TARGET("sse2")
+double SSE2Sum(const float *samples, size_t len)
+{
+   constexpr size_t Width = 4;
+   const size_t vectorLen = len - len % Width;
+
+   double sum = 0;
+   size_t ii = 0;
+   while (ii < vectorLen) {
+      const auto end = std::min(vectorLen, ii + ChunkSize);
+      __m128 vsum = _mm_setzero_ps();
+      for (; ii < end; ii += Width)
+         vsum = _mm_add_ps(vsum, _mm_loadu_ps(samples + ii));
+      sum += HorizontalSum(vsum);
+   }
+
+   return sum + ScalarSum(samples + vectorLen, len - vectorLen);
+}
+
+AUDACITY_SIMD_TARGET("avx2")
+double AVX2Sum(const float *samples, size_t len)
+{
+   constexpr size_t Width = 16;
+   const size_t vectorLen = len - len % Width;
+
+   double sum = 0;
+   size_t ii = 0;
+   while (ii < vectorLen) {
+      const auto end = std::min(vectorLen, ii + ChunkSize);
+      __m256 vsum0 = _mm256_setzero_ps(), vsum1 = vsum0;
+      for (; ii < end; ii += Width) {
+         vsum0 = _mm256_add_ps(vsum0, _mm256_loadu_ps(samples + ii));
+         vsum1 = _mm256_add_ps(vsum1, _mm256_loadu_ps(samples + ii + 8));
+      }
+      const __m256 vsum = _mm256_add_ps(vsum0, vsum1);
+      sum += HorizontalSum(_mm256_castps256_ps128(vsum)) +
+         HorizontalSum(_mm256_extractf128_ps(vsum, 1));
+   }
+
+   return sum + ScalarSum(samples + vectorLen, len - vectorLen);
+}
+
+#endif
+
+using Kernel = MinMaxSumSq (*)(const float *, size_t);
+
+Kernel GetKernel(SimdLevel level)
+{
+   switch (level) {
+#ifdef AUDACITY_SIMD_X86
+   case SimdLevel::AVX2:
+      return AVX2MinMaxSumSq;
+   case SimdLevel::SSE2:
+      return SSE2MinMaxSumSq;
+#endif
+   default:
+      return ScalarMinMaxSumSq;
+   }
+}
+
+using SumKernel = double (*)(const float *, size_t);
+
+SumKernel GetSumKernel(SimdLevel level)
+{
+   switch (level) {
+#ifdef AUDACITY_SIMD_X86
+   case SimdLevel::AVX2:
+      return AVX2Sum;
+   case SimdLevel::SSE2:
+      return SSE2Sum;
+#endif
+   default:
+      return ScalarSum;
+   }
+}
+}
+
+MinMaxSumSq ComputeMinMaxSumSq(const float *samples, size_t len)
+{
+   static const auto kernel = GetKernel(GetSimdLevel());
+   return kernel(samples, len);
+}
+
+MinMaxSumSq ComputeMinMaxSumSq(
+   const float *samples, size_t len, SimdLevel level)
+{
+   return GetKernel(level)(samples, len);
+}
+
+double ComputeSum(const float *samples, size_t len)
+{
+   static const auto kernel = GetSumKernel(GetSimdLevel());
+   return kernel(samples, len);
+}
+
+double ComputeSum(const float *samples, size_t len, SimdLevel level)
+{
+   return GetSumKernel(level)(samples, len);
+}
@@ -0,0 +1,56 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SampleStatistics.h
+  @brief Vectorized reductions of runs of float samples
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SAMPLE_STATISTICS__
+#define __AUDACITY_SAMPLE_STATISTICS__
+
+#include <cfloat>
+#include <cstddef>
+
+#include "Simd.h"
+
+//! Extremes and sum of squares of a run of samples
+struct MinMaxSumSq
+{
+   //! Values for an empty run
+   float min = FLT_MAX;
+   float max = -FLT_MAX;
+   double sumsq = 0;
+};
+
+//! Statistics of the concatenation of two runs
+inline MinMaxSumSq Combine(const MinMaxSumSq &a, const MinMaxSumSq &b)
+{
+   return {
+      a.min < b.min ? a.min : b.min,
+      a.max > b.max ? a.max : b.max,
+      a.sumsq + b.sumsq
+   };
+}
+
+//! Calculate extremes and sum of squares with the best instructions
+//! that GetSimdLevel() allows
+MATH_API MinMaxSumSq ComputeMinMaxSumSq(const float *samples, size_t len);
+
+//! Calculate extremes and sum of squares with the given instructions
+/*! @pre level <= GetSimdLevel()
+ Results of different levels may differ in rounding of the sum of squares */
+MATH_API MinMaxSumSq ComputeMinMaxSumSq(
+   const float *samples, size_t len, SimdLevel level);
+
+//! Calculate the sum of samples, as for a DC offset, with the best
+//! instructions that GetSimdLevel() allows
+MATH_API double ComputeSum(const float *samples, size_t len);
+
+//! Calculate the sum of samples with the given instructions
+/*! @pre level <= GetSimdLevel()
+ Results of different levels may differ in rounding */
+MATH_API double ComputeSum(const float *samples, size_t len, SimdLevel level);
+
+#endif
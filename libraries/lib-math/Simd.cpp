@@ -0,0 +1,69 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file Simd.cpp
+  @brief Detection of vector instruction sets at run time
+
+**********************************************************************/
+
+#include "Simd.h"
+
+#if defined(AUDACITY_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+SimdLevel DetectSimdLevel()
+{
+#if !defined(AUDACITY_SIMD_X86)
+   return SimdLevel::Scalar;
+#elif defined(__GNUC__) || defined(__clang__)
+   // These builtins also check that the OS saves the AVX registers
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      return SimdLevel::AVX2;
+   if (__builtin_cpu_supports("sse2"))
+      return SimdLevel::SSE2;
+   return SimdLevel::Scalar;
+#else
+   int info[4];
+   __cpuid(info, 0);
+   const auto nIds = info[0];
+   if (nIds < 1)
+      return SimdLevel::Scalar;
+
+   __cpuid(info, 1);
+   const bool sse2 = (info[3] & (1 << 26)) != 0;
+   const bool osxsave = (info[2] & (1 << 27)) != 0;
+   const bool avx = (info[2] & (1 << 28)) != 0;
+   bool avx2 = false;
+   if (nIds >= 7 && osxsave && avx &&
+       // The OS must preserve the xmm and ymm registers
+       (_xgetbv(0) & 0x6) == 0x6) {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+   }
+   return avx2 ? SimdLevel::AVX2 : sse2 ? SimdLevel::SSE2 : SimdLevel::Scalar;
+#endif
+}
+}
+
+SimdLevel GetSimdLevel()
+{
+   static const auto level = DetectSimdLevel();
+   return level;
+}
+
+const char *GetSimdLevelName(SimdLevel level)
+{
+   switch (level) {
+   case SimdLevel::AVX2:
+      return "AVX2";
+   case SimdLevel::SSE2:
+      return "SSE2";
+   case SimdLevel::Scalar:
+   default:
+      return "scalar";
+   }
+}
@@ -0,0 +1,40 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file Simd.h
+  @brief Detection of vector instruction sets at run time
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SIMD__
+#define __AUDACITY_SIMD__
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+   //! Defined when x86 vector intrinsics may be compiled
+   #define AUDACITY_SIMD_X86 1
+   #if defined(__GNUC__) || defined(__clang__)
+      //! Allow use of the named instruction set in one function, without
+      //! compiling the whole file for it
+      #define AUDACITY_SIMD_TARGET(isa) __attribute__((target(isa)))
+   #else
+      // MSVC allows all intrinsics without special options
+      #define AUDACITY_SIMD_TARGET(isa)
+   #endif
+#endif
+
+//! Instruction sets for which some kernels have specialized versions
+/*! Ordered so that later values imply the earlier */
+enum class SimdLevel : unsigned char {
+   Scalar,
+   SSE2,
+   AVX2,
+};
+
+//! The best level that the processor and operating system support
+/*! Detected once; it is always Scalar on other architectures than x86 */
+MATH_API SimdLevel GetSimdLevel();
+
+MATH_API const char *GetSimdLevelName(SimdLevel level);
+
+#endif
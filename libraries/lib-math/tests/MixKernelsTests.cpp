@@ -0,0 +1,186 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file MixKernelsTests.cpp
+ @brief Tests and benchmark of the vectorized mixing kernels
+
+ **********************************************************************/
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "MixKernels.h"
+
+namespace {
+std::vector<float> RandomSamples(size_t len, unsigned seed = 0)
+{
+   std::mt19937 engine{ seed };
+   // Exceed the range of integer formats, to exercise clipping
+   std::uniform_real_distribution<float> distribution{ -1.5f, 1.5f };
+   std::vector<float> result(len);
+   for (auto &sample : result)
+      sample = distribution(engine);
+   return result;
+}
+
+std::vector<SimdLevel> SupportedLevels()
+{
+   std::vector<SimdLevel> result;
+   for (auto level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2 })
+      if (level <= GetSimdLevel())
+         result.push_back(level);
+   return result;
+}
+
+// Lengths and offsets exercise the vector remainders and unaligned loads
+const std::initializer_list<size_t> Lengths{
+   0, 1, 3, 4, 7, 8, 15, 16, 17, 33, 1000 };
+const std::initializer_list<size_t> Offsets{ 0, 1, 3 };
+}
+
+TEST_CASE("AccumulateScaled agrees with the scalar path", "[MixKernels]")
+{
+   const auto src = RandomSamples(1100, 1);
+   const auto initial = RandomSamples(1100, 2);
+   for (size_t len : Lengths)
+      for (size_t offset : Offsets) {
+         auto expected = initial;
+         AccumulateScaled(expected.data() + offset, src.data() + offset,
+            0.7f, len, SimdLevel::Scalar);
+         for (auto level : SupportedLevels()) {
+            auto actual = initial;
+            AccumulateScaled(actual.data() + offset, src.data() + offset,
+               0.7f, len, level);
+            REQUIRE(actual == expected);
+         }
+      }
+}
+
+TEST_CASE("InterleaveFloats agrees with the scalar path", "[MixKernels]")
+{
+   const auto left = RandomSamples(1100, 1);
+   const auto right = RandomSamples(1100, 2);
+   const auto center = RandomSamples(1100, 3);
+   for (size_t nChannels : { 1, 2, 3 })
+      for (size_t len : Lengths)
+         for (size_t offset : Offsets) {
+            const float *const srcs[]{
+               left.data() + offset, right.data() + offset,
+               center.data() + offset };
+            std::vector<float> expected(nChannels * len);
+            InterleaveFloats(expected.data(), srcs, nChannels, len,
+               SimdLevel::Scalar);
+            for (size_t ii = 0; ii < len; ++ii)
+               for (size_t c = 0; c < nChannels; ++c)
+                  REQUIRE(expected[nChannels * ii + c] == srcs[c][ii]);
+            for (auto level : SupportedLevels()) {
+               std::vector<float> actual(nChannels * len);
+               InterleaveFloats(actual.data(), srcs, nChannels, len, level);
+               REQUIRE(actual == expected);
+            }
+         }
+}
+
+TEST_CASE("FloatsToInt16 and FloatsToInt24 agree with the scalar path",
+   "[MixKernels]")
+{
+   auto src = RandomSamples(1100, 1);
+   // Values at the bounds, and values that round out of range with noise
+   src[5] = 1.0f;
+   src[6] = -1.0f;
+   src[7] = std::numeric_limits<float>::quiet_NaN();
+   src[8] = 0.5f / 32768;
+   const auto noise = RandomSamples(1100, 2);
+   for (const float *pNoise : { (const float *)nullptr, noise.data() })
+      for (size_t destStride : { 1, 2 })
+         for (size_t len : Lengths)
+            for (size_t offset : Offsets) {
+               const auto s = src.data() + offset;
+               const auto n = pNoise ? pNoise + offset : nullptr;
+               std::vector<short> expected16(len * destStride);
+               std::vector<int> expected24(len * destStride);
+               FloatsToInt16(expected16.data(), destStride, s, n, len,
+                  SimdLevel::Scalar);
+               FloatsToInt24(expected24.data(), destStride, s, n, len,
+                  SimdLevel::Scalar);
+               for (auto level : SupportedLevels()) {
+                  std::vector<short> actual16(len * destStride);
+                  std::vector<int> actual24(len * destStride);
+                  FloatsToInt16(actual16.data(), destStride, s, n, len,
+                     level);
+                  FloatsToInt24(actual24.data(), destStride, s, n, len,
+                     level);
+                  REQUIRE(actual16 == expected16);
+                  REQUIRE(actual24 == expected24);
+               }
+            }
+}
+
+TEST_CASE("FloatsToInt16 clips and rounds", "[MixKernels]")
+{
+   const std::vector<float> src{
+      2.0f, -2.0f, 1.0f, -1.0f, 0.0f, 1.5f / 32768, -1.5f / 32768,
+      std::numeric_limits<float>::quiet_NaN() };
+   const std::vector<short> expected{
+      32767, -32768, 32767, -32768, 0, 2, -2, -32768 };
+   for (auto level : SupportedLevels()) {
+      std::vector<short> actual(src.size());
+      FloatsToInt16(actual.data(), 1, src.data(), nullptr, src.size(), level);
+      REQUIRE(actual == expected);
+   }
+}
+
+// Hidden by default; run with the tag [.benchmark] on the command line
+TEST_CASE("Mixing 64 stereo tracks for 10 minutes", "[.benchmark]")
+{
+   // Each track supplies the same buffer, so that memory traffic is like
+   // that of the Mixer, which reuses its input buffers
+   constexpr size_t BufferLen = 4096;
+   constexpr size_t nTracks = 64;
+   constexpr size_t Rate = 44100;
+   constexpr size_t TotalLen = 10 * 60 * Rate;
+   constexpr auto nBuffers = (TotalLen + BufferLen - 1) / BufferLen;
+   const auto left = RandomSamples(BufferLen, 1);
+   const auto right = RandomSamples(BufferLen, 2);
+   const auto noise = RandomSamples(BufferLen, 3);
+
+   for (auto level : SupportedLevels()) {
+      std::vector<float> mixLeft(BufferLen), mixRight(BufferLen);
+      std::vector<float> interleaved(2 * BufferLen);
+      std::vector<short> output(2 * BufferLen);
+      long long checksum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t buffer = 0; buffer < nBuffers; ++buffer) {
+         std::fill(mixLeft.begin(), mixLeft.end(), 0);
+         std::fill(mixRight.begin(), mixRight.end(), 0);
+         for (size_t track = 0; track < nTracks; ++track) {
+            const auto gain = 1.0f / (nTracks + track);
+            AccumulateScaled(
+               mixLeft.data(), left.data(), gain, BufferLen, level);
+            AccumulateScaled(
+               mixRight.data(), right.data(), gain, BufferLen, level);
+         }
+         // Float output is interleaved; integer output is converted with
+         // noise from a precomputed dither
+         const float *const channels[]{ mixLeft.data(), mixRight.data() };
+         InterleaveFloats(interleaved.data(), channels, 2, BufferLen, level);
+         for (size_t c = 0; c < 2; ++c)
+            FloatsToInt16(output.data() + c, 2, channels[c], noise.data(),
+               BufferLen, level);
+         checksum += output[buffer % output.size()];
+      }
+      const std::chrono::duration<double> elapsed =
+         std::chrono::steady_clock::now() - start;
+      std::cout << GetSimdLevelName(level) << ": "
+         << elapsed.count() * 1000 << " ms, "
+         << TotalLen / elapsed.count() / Rate << "x real time"
+         << " (checksum " << checksum << ")\n";
+   }
+}
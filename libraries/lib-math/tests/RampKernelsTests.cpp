@@ -0,0 +1,82 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file RampKernelsTests.cpp
+ @brief Tests of the vectorized ramps for envelopes
+
+ **********************************************************************/
+
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <vector>
+
+#include "RampKernels.h"
+
+namespace {
+std::vector<SimdLevel> SupportedLevels()
+{
+   std::vector<SimdLevel> result;
+   for (auto level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2 })
+      if (level <= GetSimdLevel())
+         result.push_back(level);
+   return result;
+}
+
+// Lengths and offsets exercise the vector remainders and unaligned stores
+const std::initializer_list<size_t> Lengths{
+   0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33, 1000 };
+const std::initializer_list<size_t> Offsets{ 0, 1, 3 };
+}
+
+TEST_CASE("FillLinearRamp agrees with the scalar path", "[RampKernels]")
+{
+   for (size_t len : Lengths)
+      for (size_t offset : Offsets) {
+         std::vector<double> expected(offset + len, -1);
+         FillLinearRamp(expected.data() + offset, 0.25, -1.0 / 3, len,
+            SimdLevel::Scalar);
+         for (auto level : SupportedLevels()) {
+            std::vector<double> actual(offset + len, -1);
+            FillLinearRamp(actual.data() + offset, 0.25, -1.0 / 3, len, level);
+            REQUIRE(actual == expected);
+         }
+      }
+}
+
+TEST_CASE("FillLinearRamp computes each value from its index", "[RampKernels]")
+{
+   std::vector<double> values(1000);
+   FillLinearRamp(values.data(), 1.0, 0.001, values.size());
+   for (size_t ii = 0; ii < values.size(); ++ii)
+      REQUIRE(values[ii] == 1.0 + static_cast<double>(ii) * 0.001);
+}
+
+TEST_CASE("FillExponentialRamp agrees with the scalar path", "[RampKernels]")
+{
+   for (size_t len : Lengths)
+      for (size_t offset : Offsets) {
+         std::vector<double> expected(offset + len, -1);
+         FillExponentialRamp(expected.data() + offset, 0.5, 1.0001, len,
+            SimdLevel::Scalar);
+         for (auto level : SupportedLevels()) {
+            std::vector<double> actual(offset + len, -1);
+            FillExponentialRamp(
+               actual.data() + offset, 0.5, 1.0001, len, level);
+            REQUIRE(actual == expected);
+         }
+      }
+}
+
+TEST_CASE("FillExponentialRamp is close to powers", "[RampKernels]")
+{
+   // As for a fade of 60 dB over a second at 44100 Hz
+   constexpr size_t len = 44100;
+   const auto ratio = std::pow(10.0, -3.0 / len);
+   std::vector<double> values(len);
+   FillExponentialRamp(values.data(), 1.0, ratio, len);
+   for (size_t ii = 0; ii < len; ++ii)
+      REQUIRE(values[ii] ==
+         Approx(std::pow(10.0, -3.0 * ii / len)).epsilon(1e-9));
+}
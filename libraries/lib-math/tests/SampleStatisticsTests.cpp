@@ -0,0 +1,133 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file SampleStatisticsTests.cpp
+ @brief Tests and benchmark of the vectorized sample reductions
+
+ **********************************************************************/
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "SampleStatistics.h"
+
+namespace {
+std::vector<float> RandomSamples(size_t len, unsigned seed = 0)
+{
+   std::mt19937 engine{ seed };
+   std::uniform_real_distribution<float> distribution{ -1.0f, 1.0f };
+   std::vector<float> result(len);
+   for (auto &sample : result)
+      sample = distribution(engine);
+   return result;
+}
+
+std::vector<SimdLevel> SupportedLevels()
+{
+   std::vector<SimdLevel> result;
+   for (auto level : { SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2 })
+      if (level <= GetSimdLevel())
+         result.push_back(level);
+   return result;
+}
+}
+
+TEST_CASE("ComputeMinMaxSumSq of an empty run", "[SampleStatistics]")
+{
+   for (auto level : SupportedLevels()) {
+      const auto result = ComputeMinMaxSumSq(nullptr, 0, level);
+      REQUIRE(result.min == FLT_MAX);
+      REQUIRE(result.max == -FLT_MAX);
+      REQUIRE(result.sumsq == 0);
+   }
+}
+
+TEST_CASE("ComputeMinMaxSumSq agrees with the scalar path", "[SampleStatistics]")
+{
+   const auto samples = RandomSamples(70000);
+   // Lengths and offsets exercise the vector remainders and unaligned loads
+   for (size_t len : { 1, 3, 4, 7, 15, 16, 17, 256, 1023, 1025, 65536 })
+      for (size_t offset : { 0, 1, 3 }) {
+         const auto expected =
+            ComputeMinMaxSumSq(samples.data() + offset, len, SimdLevel::Scalar);
+         for (auto level : SupportedLevels()) {
+            const auto actual =
+               ComputeMinMaxSumSq(samples.data() + offset, len, level);
+            REQUIRE(actual.min == expected.min);
+            REQUIRE(actual.max == expected.max);
+            REQUIRE(actual.sumsq == Approx(expected.sumsq).epsilon(1e-5));
+         }
+      }
+}
+
+TEST_CASE("ComputeMinMaxSumSq finds extremes in any lane", "[SampleStatistics]")
+{
+   constexpr size_t Len = 100;
+   for (size_t position = 0; position < Len; ++position) {
+      std::vector<float> samples(Len, 0.0f);
+      samples[position] = 2.0f;
+      samples[(position + 37) % Len] = -3.0f;
+      for (auto level : SupportedLevels()) {
+         const auto result = ComputeMinMaxSumSq(samples.data(), Len, level);
+         REQUIRE(result.min == -3.0f);
+         REQUIRE(result.max == 2.0f);
+         REQUIRE(result.sumsq == 13.0);
+      }
+   }
+}
+
+TEST_CASE("ComputeSum agrees with the scalar path", "[SampleStatistics]")
+{
+   const auto samples = RandomSamples(70000);
+   for (size_t len : { 0, 1, 3, 4, 7, 15, 16, 17, 256, 1023, 1025, 65536 })
+      for (size_t offset : { 0, 1, 3 }) {
+         const auto expected =
+            ComputeSum(samples.data() + offset, len, SimdLevel::Scalar);
+         for (auto level : SupportedLevels()) {
+            const auto actual =
+               ComputeSum(samples.data() + offset, len, level);
+            // The sum of random samples is near zero, so compare with a
+            // margin relative to the count, not to the result
+            REQUIRE(actual == Approx(expected).margin(1e-5 * len));
+         }
+      }
+}
+
+TEST_CASE("ComputeSum of a constant offset", "[SampleStatistics]")
+{
+   constexpr size_t Len = 100003;
+   const std::vector<float> samples(Len, 0.25f);
+   for (auto level : SupportedLevels())
+      REQUIRE(ComputeSum(samples.data(), Len, level) == 0.25 * Len);
+}
+
+// Hidden by default; run with the tag [.benchmark] on the command line
+TEST_CASE("ComputeMinMaxSumSq throughput on 1 GB", "[.benchmark]")
+{
+   // Reuse one buffer to bound memory use
+   constexpr size_t BufferLen = 16 * 1024 * 1024;
+   constexpr size_t TotalBytes = size_t(1) << 30;
+   constexpr auto nPasses = TotalBytes / (BufferLen * sizeof(float));
+   const auto samples = RandomSamples(BufferLen);
+
+   for (auto level : SupportedLevels()) {
+      double checksum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t pass = 0; pass < nPasses; ++pass)
+         // Summarize in 256-sample frames, as sample blocks do
+         for (size_t ii = 0; ii < BufferLen; ii += 256)
+            checksum +=
+               ComputeMinMaxSumSq(samples.data() + ii, 256, level).sumsq;
+      const std::chrono::duration<double> elapsed =
+         std::chrono::steady_clock::now() - start;
+      std::cout << GetSimdLevelName(level) << ": "
+         << elapsed.count() * 1000 << " ms, "
+         << TotalBytes / elapsed.count() / (1 << 20) << " MB/s"
+         << " (checksum " << checksum << ")\n";
+   }
+}
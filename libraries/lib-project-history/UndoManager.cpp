@@ -50,6 +50,23 @@ namespace {
             result.emplace_back(saver(project));
       return result;
    }
+
+   //! Duplicate the tracks, and measure the time taken
+   std::shared_ptr<TrackList> CopyTracks(
+      const TrackList &l, std::chrono::microseconds &copyTime)
+   {
+      using namespace std::chrono;
+      const auto start = steady_clock::now();
+      auto tracksCopy = TrackList::Create( nullptr );
+      for (auto t : l) {
+         if ( t->GetId() == TrackId{} )
+            // Don't copy a pending added track
+            continue;
+         tracksCopy->Add(t->Duplicate());
+      }
+      copyTime = duration_cast<microseconds>(steady_clock::now() - start);
+      return tracksCopy;
+   }
 }
 
 UndoRedoExtensionRegistry::Entry::Entry(const Saver &saver)
@@ -187,13 +204,7 @@ void UndoManager::ModifyState(const TrackList &l,
    stack[current]->state.tracks.reset();
 
    // Duplicate
-   auto tracksCopy = TrackList::Create( nullptr );
-   for (auto t : l) {
-      if ( t->GetId() == TrackId{} )
-         // Don't copy a pending added track
-         continue;
-      tracksCopy->Add(t->Duplicate());
-   }
+   auto tracksCopy = CopyTracks(l, stack[current]->copyTime);
 
    // Replace
    stack[current]->state.extensions = GetExtensions(mProject);
@@ -237,13 +248,8 @@ void UndoManager::PushState(const TrackList &l,
       return;
    }
 
-   auto tracksCopy = TrackList::Create( nullptr );
-   for (auto t : l) {
-      if ( t->GetId() == TrackId{} )
-         // Don't copy a pending added track
-         continue;
-      tracksCopy->Add(t->Duplicate());
-   }
+   std::chrono::microseconds copyTime;
+   auto tracksCopy = CopyTracks(l, copyTime);
 
    mayConsolidate = true;
 
@@ -254,6 +260,7 @@ void UndoManager::PushState(const TrackList &l,
          (GetExtensions(mProject), std::move(tracksCopy),
             longDescription, shortDescription, selectedRegion)
    );
+   stack.back()->copyTime = copyTime;
 
    current++;
 
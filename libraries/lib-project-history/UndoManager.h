@@ -49,6 +49,7 @@
 #ifndef __AUDACITY_UNDOMANAGER__
 #define __AUDACITY_UNDOMANAGER__
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -140,6 +141,9 @@ struct UndoStackElem {
    UndoState state;
    TranslatableString description;
    TranslatableString shortDescription;
+   //! Time taken to copy the tracks, when the state was last pushed or
+   //! modified
+   std::chrono::microseconds copyTime{ 0 };
 };
 
 using UndoStack = std::vector <std::unique_ptr<UndoStackElem>>;
@@ -21,7 +21,9 @@
 #include "EffectStage.h"
 #include "SampleTrack.h"
 #include "SampleTrackCache.h"
+#include "MixKernels.h"
 #include "Resample.h"
+#include "ThreadPool.h"
 #include "float_cast.h"
 #include <numeric>
 
@@ -81,6 +83,7 @@ Mixer::Mixer(Inputs inputs,
    , mHighQuality{ highQuality }
    , mFormat{ outFormat }
    , mInterleaved{ outInterleaved }
+   , mWarped{ warpOptions.envelope != nullptr }
 
    , mTimesAndSpeed{ std::make_shared<TimesAndSpeed>( TimesAndSpeed{
       startTime, stopTime, warpOptions.initialSpeed, startTime
@@ -162,10 +165,8 @@ static void MixBuffers(unsigned numChannels,
    for (unsigned int c = 0; c < numChannels; c++) {
       if (!channelFlags[c])
          continue;
-      float *dest = dests[c].data();
-      float gain = gains[c];
-      for (int j = 0; j < len; ++j)
-         *dest++ += pSrc[j] * gain;   // the actual mixing process
+      // the actual mixing process
+      AccumulateScaled(dests[c].data(), pSrc, gains[c], len);
    }
 }
 
@@ -221,18 +222,51 @@ size_t Mixer::Process(const size_t maxToProcess)
    // TODO: more-than-two-channels
    auto maxChannels = mFloatBuffers.Channels();
 
-   for (auto &[ upstream, downstream ] : mDecoratedSources) {
-      auto oResult = downstream.Acquire(mFloatBuffers, maxToProcess);
-      if (!oResult)
+   const auto nSources = mDecoratedSources.size();
+   // Envelope caches a search position, so don't share one among threads
+   const bool concurrent = mpPool && !mWarped && nSources > 1;
+   if (concurrent)
+      // Sources are independent until summation
+      mpPool->ParallelFor(nSources, [&](size_t ii){
+         mSourceResults[ii] = mDecoratedSources[ii].downstream
+            .Acquire(mSourceBuffers[ii], maxToProcess);
+      });
+
+   // Done with what a source acquired
+   const auto release = [&](size_t ii, AudioGraph::Buffers &buffers,
+      size_t result){
+      mDecoratedSources[ii].downstream.Release();
+      buffers.Advance(result);
+      buffers.Rotate();
+   };
+
+   for (size_t ii = 0; ii < nSources; ++ii) {
+      auto &[ upstream, downstream ] = mDecoratedSources[ii];
+      auto &buffers = concurrent ? mSourceBuffers[ii] : mFloatBuffers;
+      auto oResult = concurrent
+         ? mSourceResults[ii]
+         : downstream.Acquire(buffers, maxToProcess);
+      if (!oResult) {
+         if (concurrent)
+            // Later sources were acquired too
+            for (auto jj = ii + 1; jj < nSources; ++jj)
+               if (const auto &oLater = mSourceResults[jj])
+                  release(jj, mSourceBuffers[jj], *oLater);
          return 0;
+      }
       auto result = *oResult;
       maxOut = std::max(maxOut, result);
 
+      // Each source reports its own time; combine them in the shared time
+      if (const auto time = upstream.TakeLastTime())
+         mTime = backwards
+            ? std::min(mTime, *time) : std::max(mTime, *time);
+
       // Insert effect stages here!  Passing them all channels of the track
 
       const auto limit = std::min<size_t>(upstream.Channels(), maxChannels);
       for (size_t j = 0; j < limit; ++j) {
-         const auto pFloat = (const float *)mFloatBuffers.GetReadPosition(j);
+         const auto pFloat = (const float *)buffers.GetReadPosition(j);
          const auto track = upstream.GetChannel(j);
          if (mApplyTrackGains)
             for (size_t c = 0; c < mNumChannels; ++c)
@@ -242,9 +276,7 @@ size_t Mixer::Process(const size_t maxToProcess)
          MixBuffers(mNumChannels, flags, gains, *pFloat, mTemp, result);
       }
 
-      downstream.Release();
-      mFloatBuffers.Advance(result);
-      mFloatBuffers.Rotate();
+      release(ii, buffers, result);
    }
 
    if (backwards)
@@ -252,16 +284,26 @@ size_t Mixer::Process(const size_t maxToProcess)
    else
       mTime = std::clamp(mTime, oldTime, mT1);
 
-   const auto dstStride = (mInterleaved ? mNumChannels : 1);
-   for (size_t c = 0; c < mNumChannels; ++c)
-      CopySamples((constSamplePtr)mTemp[c].data(), floatSample,
-         (mInterleaved
-            ? mBuffer[0].ptr() + (c * SAMPLE_SIZE(mFormat))
-            : mBuffer[c].ptr()
-         ),
-         mFormat, maxOut,
-         mHighQuality ? gHighQualityDither : gLowQualityDither,
-         1, dstStride);
+   if (mInterleaved && mFormat == floatSample) {
+      // No dithering, so just interleave
+      const auto channels = stackAllocate(const float *, mNumChannels);
+      for (size_t c = 0; c < mNumChannels; ++c)
+         channels[c] = mTemp[c].data();
+      InterleaveFloats(reinterpret_cast<float*>(mBuffer[0].ptr()),
+         channels, mNumChannels, maxOut);
+   }
+   else {
+      const auto dstStride = (mInterleaved ? mNumChannels : 1);
+      for (size_t c = 0; c < mNumChannels; ++c)
+         CopySamples((constSamplePtr)mTemp[c].data(), floatSample,
+            (mInterleaved
+               ? mBuffer[0].ptr() + (c * SAMPLE_SIZE(mFormat))
+               : mBuffer[c].ptr()
+            ),
+            mFormat, maxOut,
+            mHighQuality ? gHighQualityDither : gLowQualityDither,
+            1, dstStride);
+   }
 
    // MB: this doesn't take warping into account, replaced with code based on mSamplePos
    //mT += (maxOut / mRate);
@@ -331,6 +373,20 @@ void Mixer::SetTimesAndSpeed(double t0, double t1, double speed, bool bSkipping)
    Reposition(t0, bSkipping);
 }
 
+void Mixer::SetThreadPool(ThreadPool *pPool)
+{
+   mpPool = pPool;
+   if (mpPool && !mWarped && mSourceBuffers.empty()) {
+      // TODO: more-than-two-channels
+      // Like mFloatBuffers
+      const auto nSources = mDecoratedSources.size();
+      mSourceBuffers.reserve(nSources);
+      for (size_t ii = 0; ii < nSources; ++ii)
+         mSourceBuffers.emplace_back(2, mBufferSize, 1, 1);
+      mSourceResults.resize(nSources);
+   }
+}
+
 void Mixer::SetSpeedForKeyboardScrubbing(double speed, double startTime)
 {
    wxASSERT(std::isfinite(speed));
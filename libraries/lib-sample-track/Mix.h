@@ -15,6 +15,7 @@
 #include "AudioGraphBuffers.h"
 #include "MixerOptions.h"
 #include "SampleFormat.h"
+#include <optional>
 
 class sampleCount;
 class BoundedEnvelope;
@@ -22,6 +23,7 @@ namespace AudioGraph{ class EffectStage; class Source; }
 class MixerSource;
 class TrackList;
 class SampleTrack;
+class ThreadPool;
 
 class SAMPLE_TRACK_API Mixer {
  public:
@@ -101,6 +103,16 @@ class SAMPLE_TRACK_API Mixer {
       double t0, double t1, double speed, bool bSkipping = false);
    void SetSpeedForKeyboardScrubbing(double speed, double startTime);
 
+   //! Fetch, resample, and apply effect stages to the inputs concurrently in
+   //! the given pool, or one after another if it is null
+   /*!
+    Only the summation is serial, in the order of the inputs, so the output
+    is the same either way.  Sources are still evaluated one after another
+    when time is warped, because they share the envelope.
+    @pre the pool outlives this, or this is called again to change it
+    */
+   void SetThreadPool(ThreadPool *pPool);
+
    /// Current time in seconds (unwarped, i.e. always between startTime and stopTime)
    /// This value is not accurate, it's useful for progress bars and indicators, but nothing else.
    double MixGetCurrentTime();
@@ -129,6 +141,8 @@ class SAMPLE_TRACK_API Mixer {
    const bool       mHighQuality; // dithering
    const sampleFormat mFormat; // output format also influences dithering
    const bool       mInterleaved;
+   //! Whether a time warp envelope is shared by all sources
+   const bool       mWarped;
 
    // INPUT
 
@@ -154,5 +168,10 @@ class SAMPLE_TRACK_API Mixer {
 
    struct Source { MixerSource &upstream; AudioGraph::Source &downstream; };
    std::vector<Source> mDecoratedSources;
+
+   ThreadPool *mpPool{};
+   //! When evaluating concurrently, each source has its own buffers and result
+   std::vector<AudioGraph::Buffers> mSourceBuffers;
+   std::vector<std::optional<size_t>> mSourceResults;
 };
 #endif
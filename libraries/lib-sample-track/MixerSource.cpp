@@ -20,6 +20,8 @@
 #include "Resample.h"
 #include "float_cast.h"
 
+#include <utility>
+
 namespace {
 template<typename T, typename F> std::vector<T>
 initVector(size_t dim1, const F &f)
@@ -343,7 +345,7 @@ std::optional<size_t> MixerSource::Acquire(Buffers &data, size_t bound)
    assert(bound <= data.BlockSize());
    assert(data.BlockSize() <= data.Remaining());
 
-   auto &[mT0, mT1, _, mTime] = *mTimesAndSpeed;
+   const auto &[mT0, mT1, _, __] = *mTimesAndSpeed;
    const bool backwards = (mT1 < mT0);
    // TODO: more-than-two-channels
    const auto maxChannels = mMaxChannels = data.Channels();
@@ -360,10 +362,12 @@ std::optional<size_t> MixerSource::Acquire(Buffers &data, size_t bound)
          : MixSameRate(j, bound, *pFloat);
       maxTrack = std::max(maxTrack, result);
       auto newT = mSamplePos[j].as_double() / track->GetRate();
-      if (backwards)
-         mTime = std::min(mTime, newT);
+      if (!mLastTime)
+         mLastTime = newT;
+      else if (backwards)
+         mLastTime = std::min(*mLastTime, newT);
       else
-         mTime = std::max(mTime, newT);
+         mLastTime = std::max(*mLastTime, newT);
    }
    // Another pass in case channels of a track did not produce equal numbers
    for (size_t j = 0; j < limit; ++j) {
@@ -395,6 +399,11 @@ bool MixerSource::Release()
    return true;
 }
 
+std::optional<double> MixerSource::TakeLastTime()
+{
+   return std::exchange(mLastTime, std::nullopt);
+}
+
 bool MixerSource::Terminates() const
 {
    // Not always terminating
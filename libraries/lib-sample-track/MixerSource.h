@@ -58,6 +58,14 @@ public:
    bool Terminates() const override;
    void Reposition(double time, bool skipping);
 
+   //! The time reached by Acquire() since the last call, furthest in the
+   //! direction of play, if it was called
+   /*!
+    Acquire() does not update the shared current time itself, so that sources
+    may be evaluated concurrently
+    */
+   std::optional<double> TakeLastTime();
+
 private:
    void MakeResamplers();
 
@@ -132,5 +140,6 @@ private:
    //! Remember how many channels were passed to Acquire()
    unsigned mMaxChannels{};
    size_t mLastProduced{};
+   std::optional<double> mLastTime;
 };
 #endif
@@ -31,6 +31,8 @@ a draggable point type.
 
 #include <math.h>
 
+#include "RampKernels.h"
+
 #include <wx/wxcrtvararg.h>
 #include <wx/brush.h>
 #include <wx/pen.h>
@@ -844,25 +846,21 @@ void Envelope::BinarySearchForTime( int &Lo, int &Hi, double t ) const
 {
    // Optimizations for the usual pattern of repeated calls with
    // small increases of t.
+   // Load the hint once, so that other readers storing it concurrently
+   // can make this search slower but not wrong.
    {
-      if (mSearchGuess >= 0 && mSearchGuess < (int)mEnv.size()) {
-         if (t >= mEnv[mSearchGuess].GetT() &&
-             (1 + mSearchGuess == (int)mEnv.size() ||
-              t < mEnv[1 + mSearchGuess].GetT())) {
-            Lo = mSearchGuess;
-            Hi = 1 + mSearchGuess;
-            return;
-         }
-      }
-
-      ++mSearchGuess;
-      if (mSearchGuess >= 0 && mSearchGuess < (int)mEnv.size()) {
-         if (t >= mEnv[mSearchGuess].GetT() &&
-             (1 + mSearchGuess == (int)mEnv.size() ||
-              t < mEnv[1 + mSearchGuess].GetT())) {
-            Lo = mSearchGuess;
-            Hi = 1 + mSearchGuess;
-            return;
+      auto guess = mSearchGuess.load(std::memory_order_relaxed);
+      for (auto next : { guess, guess + 1 }) {
+         if (next >= 0 && next < (int)mEnv.size()) {
+            if (t >= mEnv[next].GetT() &&
+                (1 + next == (int)mEnv.size() ||
+                 t < mEnv[1 + next].GetT())) {
+               Lo = next;
+               Hi = 1 + next;
+               if (next != guess)
+                  mSearchGuess.store(next, std::memory_order_relaxed);
+               return;
+            }
          }
       }
    }
@@ -881,7 +879,7 @@ void Envelope::BinarySearchForTime( int &Lo, int &Hi, double t ) const
    }
    wxASSERT( Hi == ( Lo+1 ));
 
-   mSearchGuess = Lo;
+   mSearchGuess.store(Lo, std::memory_order_relaxed);
 }
 
 // relative time
@@ -903,7 +901,7 @@ void Envelope::BinarySearchForTime_LeftLimit( int &Lo, int &Hi, double t ) const
    }
    wxASSERT( Hi == ( Lo+1 ));
 
-   mSearchGuess = Lo;
+   mSearchGuess.store(Lo, std::memory_order_relaxed);
 }
 
 /// GetInterpolationStartValueAtPoint() is used to select either the
@@ -938,109 +936,118 @@ void Envelope::GetValuesRelative
    const auto epsilon = tstep / 2;
    int len = mEnv.size();
 
-   double t = t0;
-   double increment = 0;
-   if ( len > 1 && t <= mEnv[0].GetT() && mEnv[0].GetT() == mEnv[1].GetT() )
-      increment = leftLimit ? -epsilon : epsilon;
+   // Get easiest cases out the way first...
+   // IF empty envelope THEN default value
+   if (len <= 0) {
+      std::fill(buffer, buffer + std::max(0, bufferLen), mDefaultValue);
+      return;
+   }
 
-   double tprev, vprev, tnext = 0, vnext, vstep = 0;
+   // Times are computed from the index, not accumulated, so that each run of
+   // samples within one segment can be filled at once
+   const auto timeAt = [&](int b){ return t0 + b * tstep; };
 
-   for (int b = 0; b < bufferLen; b++) {
+   double increment = 0;
+   if ( len > 1 && t0 <= mEnv[0].GetT() && mEnv[0].GetT() == mEnv[1].GetT() )
+      increment = leftLimit ? -epsilon : epsilon;
 
-      // Get easiest cases out the way first...
-      // IF empty envelope THEN default value
-      if (len <= 0) {
-         buffer[b] = mDefaultValue;
-         t += tstep;
-         continue;
-      }
+   const auto before = [&](double tplus){
+      return leftLimit ? tplus <= mEnv[0].GetT() : tplus < mEnv[0].GetT(); };
+   const auto after = [&](double tplus){
+      return leftLimit
+         ? tplus > mEnv[len - 1].GetT() : tplus >= mEnv[len - 1].GetT(); };
 
-      auto tplus = t + increment;
+   for (int b = 0; b < bufferLen;) {
+      auto tplus = timeAt(b) + increment;
 
       // IF before envelope THEN first value
-      if ( leftLimit ? tplus <= mEnv[0].GetT() : tplus < mEnv[0].GetT() ) {
-         buffer[b] = mEnv[0].GetVal();
-         t += tstep;
+      if ( before(tplus) ) {
+         buffer[b++] = mEnv[0].GetVal();
          continue;
       }
       // IF after envelope THEN last value
-      if ( leftLimit
-            ? tplus > mEnv[len - 1].GetT() : tplus >= mEnv[len - 1].GetT() ) {
-         buffer[b] = mEnv[len - 1].GetVal();
-         t += tstep;
+      if ( after(tplus) ) {
+         buffer[b++] = mEnv[len - 1].GetVal();
          continue;
       }
 
-      // be careful to get the correct limit even in case epsilon == 0
-      if ( b == 0 ||
-           ( leftLimit ? tplus > tnext : tplus >= tnext ) ) {
-
-         // We're beyond our tnext, so find the next one.
-         // Don't just increment lo or hi because we might
-         // be zoomed far out and that could be a large number of
-         // points to move over.  That's why we binary search.
-
-         int lo,hi;
-         if ( leftLimit )
-            BinarySearchForTime_LeftLimit( lo, hi, tplus );
-         else
-            BinarySearchForTime( lo, hi, tplus );
-
-         // mEnv[0] is before tplus because of eliminations above, therefore lo >= 0
-         // mEnv[len - 1] is after tplus, therefore hi <= len - 1
-         wxASSERT( lo >= 0 && hi <= len - 1 );
-
-         tprev = mEnv[lo].GetT();
-         tnext = mEnv[hi].GetT();
-
-         if ( hi + 1 < len && tnext == mEnv[ hi + 1 ].GetT() )
-            // There is a discontinuity after this point-to-point interval.
-            // Usually will stop evaluating in this interval when time is slightly
-            // before tNext, then use the right limit.
-            // This is the right intent
-            // in case small roundoff errors cause a sample time to be a little
-            // before the envelope point time.
-            // Less commonly we want a left limit, so we continue evaluating in
-            // this interval until shortly after the discontinuity.
-            increment = leftLimit ? -epsilon : epsilon;
-         else
-            increment = 0;
-
-         vprev = GetInterpolationStartValueAtPoint( lo );
-         vnext = GetInterpolationStartValueAtPoint( hi );
-
-         // Interpolate, either linear or log depending on mDB.
-         double dt = (tnext - tprev);
-         double to = t - tprev;
-         double v;
-         if (dt > 0.0)
-         {
-            v = (vprev * (dt - to) + vnext * to) / dt;
-            vstep = (vnext - vprev) * tstep / dt;
-         }
-         else
-         {
-            v = vnext;
-            vstep = 0.0;
-         }
+      // Find the segment containing the time.  The search tries the
+      // segment found last, and the next one, before bisecting, so it is
+      // usually quick for playback which moves forward in small steps; but
+      // we might be zoomed far out and skip over many points.
+      int lo,hi;
+      if ( leftLimit )
+         BinarySearchForTime_LeftLimit( lo, hi, tplus );
+      else
+         BinarySearchForTime( lo, hi, tplus );
+
+      // mEnv[0] is before tplus because of eliminations above, therefore lo >= 0
+      // mEnv[len - 1] is after tplus, therefore hi <= len - 1
+      wxASSERT( lo >= 0 && hi <= len - 1 );
+
+      const auto tprev = mEnv[lo].GetT();
+      const auto tnext = mEnv[hi].GetT();
+
+      if ( hi + 1 < len && tnext == mEnv[ hi + 1 ].GetT() )
+         // There is a discontinuity after this point-to-point interval.
+         // Usually will stop evaluating in this interval when time is slightly
+         // before tNext, then use the right limit.
+         // This is the right intent
+         // in case small roundoff errors cause a sample time to be a little
+         // before the envelope point time.
+         // Less commonly we want a left limit, so we continue evaluating in
+         // this interval until shortly after the discontinuity.
+         increment = leftLimit ? -epsilon : epsilon;
+      else
+         increment = 0;
+
+      // Find the end of the run of samples in this interval; be careful to
+      // get the correct limit even in case epsilon == 0
+      const auto within = [&](int bb){
+         const auto tp = timeAt(bb) + increment;
+         return !before(tp) && !after(tp) &&
+            (leftLimit ? tp <= tnext : tp < tnext);
+      };
+      int end = b + 1;
+      if (tstep == 0)
+         // All times are the same
+         end = bufferLen;
+      else if (tstep > 0) {
+         // Estimate, then correct for rounding
+         const auto estimate = ceil((tnext - increment - t0) / tstep);
+         end = static_cast<int>(std::clamp<double>(estimate, b + 1, bufferLen));
+         while (end > b + 1 && !within(end - 1))
+            --end;
+         while (end < bufferLen && within(end))
+            ++end;
+      }
 
-         // An adjustment if logarithmic scale.
-         if( mDB )
-         {
-            v = pow(10.0, v);
-            vstep = pow( 10.0, vstep );
-         }
+      auto vprev = GetInterpolationStartValueAtPoint( lo );
+      auto vnext = GetInterpolationStartValueAtPoint( hi );
 
-         buffer[b] = v;
-      } else {
-         if (mDB){
-            buffer[b] = buffer[b - 1] * vstep;
-         }else{
-            buffer[b] = buffer[b - 1] + vstep;
-         }
+      // Interpolate, either linear or log depending on mDB.
+      double dt = (tnext - tprev);
+      double to = timeAt(b) - tprev;
+      double v, vstep;
+      if (dt > 0.0)
+      {
+         v = (vprev * (dt - to) + vnext * to) / dt;
+         vstep = (vnext - vprev) * tstep / dt;
       }
+      else
+      {
+         v = vnext;
+         vstep = 0.0;
+      }
+
+      // An adjustment if logarithmic scale.
+      if( mDB )
+         FillExponentialRamp(
+            buffer + b, pow(10.0, v), pow(10.0, vstep), end - b);
+      else
+         FillLinearRamp(buffer + b, v, vstep, end - b);
 
-      t += tstep;
+      b = end;
    }
 }
 
@@ -13,6 +13,7 @@
 
 #include <stdlib.h>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 
 #include "XMLTagHandler.h"
@@ -252,7 +253,14 @@ private:
    bool mDragPointValid { false };
    int mDragPoint { -1 };
 
-   mutable int mSearchGuess { -2 };
+   //! A hint for BinarySearchForTime, which may be called concurrently by
+   //! threads that only read the envelope, as when exporting several files
+   struct SearchGuess : std::atomic<int> {
+      SearchGuess() : std::atomic<int>{ -2 } {}
+      SearchGuess(const SearchGuess &) : SearchGuess{} {}
+      SearchGuess &operator= (const SearchGuess &) { return *this; }
+   };
+   mutable SearchGuess mSearchGuess;
 };
 
 inline void EnvPoint::SetVal( Envelope *pEnvelope, double val )
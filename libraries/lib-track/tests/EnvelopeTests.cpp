@@ -0,0 +1,133 @@
+/*!********************************************************************
+
+ Audacity: A Digital Audio Editor
+
+ @file EnvelopeTests.cpp
+ @brief Tests and benchmark of the evaluation of envelopes
+
+ **********************************************************************/
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "Envelope.h"
+
+namespace {
+//! Envelope with the range of clip gain, and points at random times
+std::unique_ptr<Envelope> MakeEnvelope(
+   bool exponential, size_t nPoints, double length, unsigned seed)
+{
+   auto result = std::make_unique<Envelope>(exponential, 1e-7, 2.0, 1.0);
+   result->SetTrackLen(length);
+   std::mt19937 engine{ seed };
+   std::uniform_real_distribution<double> time{ 0, length };
+   std::uniform_real_distribution<double> value{ 0.01, 2.0 };
+   for (size_t ii = 0; ii < nPoints; ++ii)
+      result->InsertOrReplace(time(engine), value(engine));
+   return result;
+}
+
+//! Interpolate between the points about the time, found by linear search
+double Interpolate(const Envelope &envelope, double t)
+{
+   const int nPoints = envelope.GetNumberOfPoints();
+   if (t < envelope[0].GetT())
+      return envelope[0].GetVal();
+   if (t >= envelope[nPoints - 1].GetT())
+      return envelope[nPoints - 1].GetVal();
+   int hi = 1;
+   while (envelope[hi].GetT() <= t)
+      ++hi;
+   const auto &prev = envelope[hi - 1], &next = envelope[hi];
+   const auto fraction = (t - prev.GetT()) / (next.GetT() - prev.GetT());
+   if (!envelope.GetExponential())
+      return prev.GetVal() + (next.GetVal() - prev.GetVal()) * fraction;
+   const auto logPrev = std::log10(prev.GetVal());
+   const auto logNext = std::log10(next.GetVal());
+   return std::pow(10.0, logPrev + (logNext - logPrev) * fraction);
+}
+}
+
+TEST_CASE("Envelope::GetValues interpolates between points", "[Envelope]")
+{
+   for (bool exponential : { false, true }) {
+      const auto pEnvelope = MakeEnvelope(exponential, 1000, 10.0, 1);
+      constexpr size_t len = 100000;
+      constexpr double tstep = 10.0 / len;
+      std::vector<double> values(len);
+      pEnvelope->GetValues(values.data(), len, 0.0, tstep);
+      for (size_t ii = 0; ii < len; ++ii)
+         REQUIRE(values[ii] ==
+            Approx(Interpolate(*pEnvelope, ii * tstep)).epsilon(1e-6));
+   }
+}
+
+TEST_CASE("Envelope::GetValues gives the same in successive buffers",
+   "[Envelope]")
+{
+   for (bool exponential : { false, true }) {
+      const auto pEnvelope = MakeEnvelope(exponential, 1000, 10.0, 2);
+      constexpr size_t len = 100000;
+      constexpr size_t bufferLen = 512;
+      constexpr double tstep = 10.0 / len;
+      std::vector<double> whole(len), pieces(len);
+      pEnvelope->GetValues(whole.data(), len, 0.0, tstep);
+      for (size_t start = 0; start < len; start += bufferLen)
+         pEnvelope->GetValues(pieces.data() + start,
+            std::min(bufferLen, len - start), start * tstep, tstep);
+      for (size_t ii = 0; ii < len; ++ii)
+         REQUIRE(pieces[ii] == Approx(whole[ii]).epsilon(1e-9));
+   }
+}
+
+TEST_CASE("Envelope::GetValues takes limits at discontinuities", "[Envelope]")
+{
+   Envelope envelope{ false, 0.0, 2.0, 1.0 };
+   envelope.SetTrackLen(2.0);
+   envelope.InsertOrReplace(0.0, 0.0);
+   envelope.InsertOrReplace(1.0, 1.0);
+   // A second point at the same time makes a jump
+   envelope.Insert(1.0, 2.0);
+   envelope.InsertOrReplace(2.0, 0.0);
+
+   double values[5];
+   envelope.GetValues(values, 5, 0.0, 0.5);
+   REQUIRE(values[0] == 0.0);
+   REQUIRE(values[1] == 0.5);
+   REQUIRE(values[2] == 2.0);
+   REQUIRE(values[3] == 1.0);
+   REQUIRE(values[4] == 0.0);
+}
+
+// Hidden by default; run with the tag [.benchmark] on the command line
+TEST_CASE("Envelopes of 5000 points for 10 minutes", "[.benchmark]")
+{
+   constexpr size_t BufferLen = 4096;
+   constexpr size_t Rate = 44100;
+   constexpr size_t TotalLen = 10 * 60 * Rate;
+   constexpr double Length = double(TotalLen) / Rate;
+   std::vector<double> buffer(BufferLen);
+
+   for (bool exponential : { false, true }) {
+      const auto pEnvelope = MakeEnvelope(exponential, 5000, Length, 3);
+      double checksum = 0;
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t pos = 0; pos < TotalLen; pos += BufferLen) {
+         pEnvelope->GetValues(buffer.data(), BufferLen,
+            double(pos) / Rate, 1.0 / Rate);
+         checksum += buffer[pos % BufferLen];
+      }
+      const std::chrono::duration<double> elapsed =
+         std::chrono::steady_clock::now() - start;
+      std::cout << (exponential ? "exponential" : "linear") << ": "
+         << elapsed.count() * 1000 << " ms, "
+         << TotalLen / elapsed.count() / Rate << "x real time"
+         << " (checksum " << checksum << ")\n";
+   }
+}
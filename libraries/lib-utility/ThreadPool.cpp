@@ -0,0 +1,128 @@
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file ThreadPool.cpp
+  @brief A fixed set of worker threads executing queued tasks
+
+**********************************************************************/
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+ThreadPool &ThreadPool::Get()
+{
+   static ThreadPool thePool{
+      std::max(2u, std::thread::hardware_concurrency()) - 1 };
+   return thePool;
+}
+
+ThreadPool::ThreadPool(size_t nThreads)
+{
+   mThreads.reserve(nThreads);
+   for (size_t ii = 0; ii < nThreads; ++ii)
+      mThreads.emplace_back([this]{ Run(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mStopping = true;
+   }
+   mCondition.notify_all();
+   for (auto &thread : mThreads)
+      thread.join();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+   if (mThreads.empty()) {
+      // A pool without workers runs tasks synchronously
+      task();
+      return;
+   }
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mQueue.push_back(move(task));
+   }
+   mCondition.notify_one();
+}
+
+void ThreadPool::Run()
+{
+   while (true) {
+      std::function<void()> task;
+      {
+         std::unique_lock<std::mutex> lock{ mMutex };
+         mCondition.wait(lock, [this]{ return mStopping || !mQueue.empty(); });
+         if (mQueue.empty())
+            // Stopping, and all work is done
+            return;
+         task = move(mQueue.front());
+         mQueue.pop_front();
+      }
+      // Tasks made by Submit() capture exceptions in their futures
+      task();
+   }
+}
+
+void ThreadPool::ParallelFor(
+   size_t count, const std::function<void(size_t)> &f)
+{
+   if (count == 0)
+      return;
+
+   // State shared with the helpers, which may start only after this
+   // function returns, if the workers are busy
+   struct State {
+      std::atomic<size_t> next{ 0 };
+      std::atomic<bool> failed{ false };
+      size_t finished{ 0 };
+      std::exception_ptr pException;
+      std::mutex mutex;
+      std::condition_variable condition;
+   };
+   const auto pState = std::make_shared<State>();
+
+   // Each call of work claims unclaimed indices until there are none.
+   // f is called only for claimed indices, and all of those finish before this
+   // function returns, so capture of f by reference is safe.
+   const auto work = [pState, count, &f]{
+      auto &state = *pState;
+      size_t ii;
+      while ((ii = state.next.fetch_add(1, std::memory_order_relaxed))
+         < count) {
+         if (!state.failed.load(std::memory_order_relaxed)) {
+            try {
+               f(ii);
+            }
+            catch (...) {
+               std::lock_guard<std::mutex> lock{ state.mutex };
+               if (!state.pException)
+                  state.pException = std::current_exception();
+               state.failed.store(true, std::memory_order_relaxed);
+            }
+         }
+         std::lock_guard<std::mutex> lock{ state.mutex };
+         if (++state.finished == count)
+            state.condition.notify_all();
+      }
+   };
+
+   // Don't make more helpers than there are calls to make
+   const auto nHelpers = std::min(mThreads.size(), count - 1);
+   for (size_t ii = 0; ii < nHelpers; ++ii)
+      Enqueue(work);
+
+   // This thread helps too, so there is progress even if all workers are
+   // busy, which also prevents deadlock when called from a worker
+   work();
+
+   std::unique_lock<std::mutex> lock{ pState->mutex };
+   pState->condition.wait(lock, [&]{ return pState->finished == count; });
+   if (pState->pException)
+      std::rethrow_exception(pState->pException);
+}
@@ -0,0 +1,80 @@
+/*!********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file ThreadPool.h
+  @brief A fixed set of worker threads executing queued tasks
+
+**********************************************************************/
+#ifndef __AUDACITY_THREAD_POOL__
+#define __AUDACITY_THREAD_POOL__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//! A fixed set of worker threads executing queued tasks in FIFO order
+/*!
+ Tasks should not block waiting for other tasks submitted to the same pool,
+ except by ParallelFor(), which lets the waiting thread help.
+ */
+class UTILITY_API ThreadPool
+{
+public:
+   //! The pool shared by all of the application
+   /*! It has one thread fewer than the hardware concurrency, but at least one,
+    leaving a core for the main thread */
+   static ThreadPool &Get();
+
+   //! @param nThreads if zero, then tasks run synchronously when submitted
+   explicit ThreadPool(size_t nThreads);
+   //! Runs remaining queued tasks, then joins the threads
+   ~ThreadPool();
+
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool &operator=(const ThreadPool&) = delete;
+
+   size_t GetNumThreads() const { return mThreads.size(); }
+
+   //! Queue a task
+   /*! @return a future for the result of the task, which also transmits any
+    exception it throws */
+   template<typename F>
+   auto Submit(F &&f) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+   {
+      using Result = std::invoke_result_t<std::decay_t<F>>;
+      // std::function requires copyable callables, so share the task
+      auto pTask = std::make_shared<std::packaged_task<Result()>>(
+         std::forward<F>(f));
+      auto result = pTask->get_future();
+      Enqueue([pTask]{ (*pTask)(); });
+      return result;
+   }
+
+   //! Call f(0), ..., f(count - 1), possibly concurrently and in any order,
+   //! and return when all are done
+   /*!
+    The calling thread also executes some of the calls.  If any call throws,
+    remaining calls not yet started are skipped, and the first exception is
+    rethrown after all started calls complete.
+    */
+   void ParallelFor(size_t count, const std::function<void(size_t)> &f);
+
+private:
+   void Enqueue(std::function<void()> task);
+   void Run();
+
+   std::vector<std::thread> mThreads;
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::deque<std::function<void()>> mQueue;
+   bool mStopping{ false };
+};
+
+#endif
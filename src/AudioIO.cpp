@@ -2473,6 +2473,13 @@ bool AudioIoCallback::FillOutputBuffers(
    // These are small structures.
    WaveTrack **chans = (WaveTrack **) alloca(numPlaybackChannels * sizeof(WaveTrack *));
    float **tempBufs = (float **) alloca(numPlaybackChannels * sizeof(float *));
+   // Where to read each channel:  the ring buffer itself, if possible
+   const float **readBufs =
+      (const float **) alloca(numPlaybackChannels * sizeof(float *));
+   // How much to commit to each channel's ring buffer after reading
+   RingBuffer **readers =
+      (RingBuffer **) alloca(numPlaybackChannels * sizeof(RingBuffer *));
+   size_t *readLens = (size_t *) alloca(numPlaybackChannels * sizeof(size_t));
 
    // And these are larger structures....
    for (unsigned int c = 0; c < numPlaybackChannels; c++)
@@ -2540,19 +2547,34 @@ bool AudioIoCallback::FillOutputBuffers(
       }
       else
       {
-         len = mPlaybackBuffers[t]->Get((samplePtr)tempBufs[chanCnt],
-                                                   floatSample,
-                                                   toGet);
+         // Read the samples in place, without copying, unless they wrap
+         // around the end of the ring buffer or need padding
+         auto &buffer = *mPlaybackBuffers[t];
+         const auto spans = buffer.AcquireForGet(toGet);
+         len = spans[0].size + spans[1].size;
          // wxASSERT( len == toGet );
-         if (len < framesPerBuffer)
-            // This used to happen normally at the end of non-looping
-            // plays, but it can also be an anomalous case where the
-            // supply from TrackBufferExchange fails to keep up with the
-            // real-time demand in this thread (see bug 1932).  We
-            // must supply something to the sound card, so pad it with
-            // zeroes and not random garbage.
-            memset((void*)&tempBufs[chanCnt][len], 0,
-               (framesPerBuffer - len) * sizeof(float));
+         if (spans[0].size == framesPerBuffer)
+            readBufs[chanCnt] = reinterpret_cast<const float*>(spans[0].ptr);
+         else {
+            auto dest = tempBufs[chanCnt];
+            for (const auto &[ptr, size] : spans) {
+               if (size)
+                  memcpy(dest, ptr, size * sizeof(float));
+               dest += size;
+            }
+            if (len < framesPerBuffer)
+               // This used to happen normally at the end of non-looping
+               // plays, but it can also be an anomalous case where the
+               // supply from TrackBufferExchange fails to keep up with the
+               // real-time demand in this thread (see bug 1932).  We
+               // must supply something to the sound card, so pad it with
+               // zeroes and not random garbage.
+               memset((void*)&tempBufs[chanCnt][len], 0,
+                  (framesPerBuffer - len) * sizeof(float));
+            readBufs[chanCnt] = tempBufs[chanCnt];
+         }
+         readers[chanCnt] = &buffer;
+         readLens[chanCnt] = len;
          chanCnt++;
       }
 
@@ -2595,14 +2617,18 @@ bool AudioIoCallback::FillOutputBuffers(
          if (vt->GetChannelIgnoringPan() == Track::LeftChannel ||
                vt->GetChannelIgnoringPan() == Track::MonoChannel )
             AddToOutputChannel( 0, outputMeterFloats, outputFloats,
-               tempBufs[c], drop, len, vt);
+               readBufs[c], drop, len, vt);
 
          if (vt->GetChannelIgnoringPan() == Track::RightChannel ||
                vt->GetChannelIgnoringPan() == Track::MonoChannel  )
             AddToOutputChannel( 1, outputMeterFloats, outputFloats,
-               tempBufs[c], drop, len, vt);
+               readBufs[c], drop, len, vt);
       }
 
+      // Only now may the producer reuse the space that was read in place
+      for (int c = 0; c < chanCnt; c++)
+         readers[c]->CommitGet(readLens[c]);
+
       CallbackCheckCompletion(mCallbackReturn, len);
       if (dropQuickly) // no samples to process, they've been discarded
          continue;
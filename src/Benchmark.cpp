@@ -18,7 +18,18 @@ of sample block storage.
 
 #include "Benchmark.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
 #include <wx/app.h>
+#include <wx/file.h>
+#include <wx/filename.h>
 #include <wx/log.h>
 #include <wx/textctrl.h>
 #include <wx/button.h>
@@ -33,20 +44,29 @@ of sample block storage.
 #include <wx/valtext.h>
 #include <wx/intl.h>
 
+#include "FileFormats.h"
 #include "SampleBlock.h"
+#include "SampleTrackCache.h"
 #include "ShuttleGui.h"
+#include "ThreadPool.h"
 #include "Project.h"
 #include "WaveClip.h"
 #include "WaveTrack.h"
 #include "Sequence.h"
 #include "Prefs.h"
 #include "ProjectRate.h"
+#include "RingBuffer.h"
+#include "Tags.h"
 #include "ViewInfo.h"
+#include "tracks/playabletrack/wavetrack/ui/SpectrumCache.h"
 
 #include "FileNames.h"
 #include "SelectFile.h"
 #include "widgets/AudacityMessageBox.h"
 #include "widgets/wxPanelWrapper.h"
+#include "import/Import.h"
+#include "effects/NoiseReduction.h"
+#include "effects/TruncSilence.h"
 
 // Change these to the desired format...should probably make the
 // choice available in the dialog
@@ -82,6 +102,7 @@ private:
    wxString  mDataSizeStr;
    wxString  mNumEditsStr;
    wxString  mRandSeedStr;
+   wxString  mImportSizeStr;
 
    bool      mBlockDetail;
    bool      mEditDetail;
@@ -127,7 +148,8 @@ enum {
    BlockSizeID,
    DataSizeID,
    NumEditsID,
-   RandSeedID
+   RandSeedID,
+   ImportSizeID
 };
 
 BEGIN_EVENT_TABLE(BenchmarkDialog, wxDialogWrapper)
@@ -154,6 +176,7 @@ BenchmarkDialog::BenchmarkDialog(
    mNumEditsStr = wxT("100");
    mDataSizeStr = wxT("32");
    mRandSeedStr = wxT("234657");
+   mImportSizeStr = wxT("0");
 
    mBlockDetail = false;
    mEditDetail = false;
@@ -212,6 +235,13 @@ void BenchmarkDialog::MakeBenchmarkDialog()
                                             wxT(""),
                                             12);
 
+         //
+         S.Id(ImportSizeID)
+            .Validator<wxTextValidator>(wxFILTER_NUMERIC, &mImportSizeStr)
+            .AddTextBox(XXO("Import Test Size (MB, 0 to skip):"),
+                                            wxT(""),
+                                            12);
+
       }
       S.EndMultiColumn();
 
@@ -329,12 +359,13 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
 
    // This code will become part of libaudacity,
    // and this class will be phased out.
-   long blockSize, numEdits, dataSize, randSeed;
+   long blockSize, numEdits, dataSize, randSeed, importSize;
 
    mBlockSizeStr.ToLong(&blockSize);
    mNumEditsStr.ToLong(&numEdits);
    mDataSizeStr.ToLong(&dataSize);
    mRandSeedStr.ToLong(&randSeed);
+   mImportSizeStr.ToLong(&importSize);
 
    if (blockSize < 1 || blockSize > 1024) {
       AudacityMessageBox(
@@ -354,6 +385,12 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
       return;
    }
 
+   if (importSize < 0 || importSize > 16384) {
+      AudacityMessageBox(
+         XO("Import test size should be in the range 0 - 16384 MB.") );
+      return;
+   }
+
    SettingScope scope;
    EditClipsCanMove.Write( false );
 
@@ -369,9 +406,9 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
 
    HoldPrint(true);
 
+   const auto pFactory = SampleBlockFactory::New( mProject );
    const auto t =
-      WaveTrackFactory{ mRate,
-                    SampleBlockFactory::New( mProject )  }
+      WaveTrackFactory{ mRate, pFactory }
          .Create(SampleFormat, mRate.GetRate());
 
    t->SetRate(1);
@@ -413,15 +450,50 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
    wxString tempStr;
    wxStopWatch timer;
 
-   for (uint64_t i = 0; i < nChunks; i++) {
-      v = SampleType(rand());
-      small1[i] = v;
-      for (uint64_t b = 0; b < chunkSize; b++)
-         block[b] = v;
+   for (uint64_t i = 0; i < nChunks; i++)
+      small1[i] = SampleType(rand());
 
-      t->Append((samplePtr)block.get(), SampleFormat, chunkSize);
+   const auto fill = [&](WaveTrack &track){
+      for (uint64_t i = 0; i < nChunks; i++) {
+         std::fill(block.get(), block.get() + chunkSize, small1[i]);
+         track.Append((samplePtr)block.get(), SampleFormat, chunkSize);
+      }
+      track.Flush();
+   };
+   {
+      // Measure storage of as many blocks as the track will have, one at a
+      // time, then in a batch.  Create the blocks directly, because
+      // Sequence::Append makes batches of its own.
+      const auto blockSize = t->GetMaxBlockSize();
+      const auto nBlocks = (nChunks * chunkSize + blockSize - 1) / blockSize;
+      SampleBuffer samples{ blockSize, SampleFormat };
+      std::fill((SampleType*)samples.ptr(),
+         (SampleType*)samples.ptr() + blockSize, small1[0]);
+      const auto store = [&](bool batched){
+         // Destroy the blocks, deleting their rows, after the measurement
+         std::vector<SampleBlockPtr> blocks;
+         blocks.reserve(nBlocks);
+         timer.Start();
+         {
+            std::optional<SampleBlockFactory::BatchScope> batch;
+            if (batched)
+               batch.emplace(*pFactory);
+            for (uint64_t i = 0; i < nBlocks; ++i)
+               blocks.push_back(
+                  pFactory->Create(samples.ptr(), blockSize, SampleFormat));
+         }
+         return timer.Time();
+      };
+      const auto report = [&](const TranslatableString &how, long ms){
+         Printf( XO("Stored %lld sample blocks %s in %ld ms (%.0f blocks per second)\n")
+            .Format( (long long) nBlocks, how, ms,
+               nBlocks * 1000.0 / std::max(1L, ms) ) );
+      };
+      report(XO("one at a time"), store(false));
+      report(XO("in batches"), store(true));
    }
-   t->Flush();
+
+   fill(*t);
 
    // This forces the WaveTrack to flush all of the appends (which is
    // only necessary if you want to access the Sequence class directly,
@@ -568,6 +640,616 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
    Printf( XO("At 44100 Hz, %d bytes per sample, the estimated number of\n simultaneous tracks that could be played at once: %.1f\n" )
       .Format( SAMPLE_SIZE(SampleFormat), (nChunks*chunkSize/44100.0)/(elapsed/1000.0) ) );
 
+   {
+      // Compare calculation of spectrogram columns in one thread and in the
+      // shared pool, whose results must be the same
+      Printf( XO("Computing spectrograms...\n") );
+      wxTheApp->Yield();
+      FlushPrint();
+
+      const auto &settings = t->GetSpectrogramSettings();
+      const auto numSamples =
+         t->GetClipByIndex(0)->GetSequence()->GetNumSamples();
+      const size_t numPixels = 2000;
+      const double rate = t->GetRate();
+      const double pixelsPerSecond =
+         numPixels * rate / numSamples.as_double();
+      const auto compute = [&](SpecCache &cache, ThreadPool &pool){
+         cache.Grow(numPixels, settings, pixelsPerSecond, 0);
+         for (size_t ii = 0; ii <= numPixels; ++ii)
+            cache.where[ii] = sampleCount(
+               ii * numSamples.as_double() / numPixels);
+         SampleTrackCache trackCache{ t };
+         timer.Start();
+         // Empty copied range, so all columns are computed
+         cache.Populate(settings, trackCache, 0, 0, numPixels, numSamples,
+            0, rate, pixelsPerSecond, pool);
+         return timer.Time();
+      };
+      const auto columnsReport = [&](const TranslatableString &how, long ms){
+         Printf( XO("Computed %lld spectrogram columns %s in %ld ms (%.0f columns per second)\n")
+            .Format( (long long) numPixels, how, ms,
+               numPixels * 1000.0 / std::max(1L, ms) ) );
+      };
+
+      SpecCache serial, parallel;
+      ThreadPool synchronous{ 0 };
+      auto &pool = ThreadPool::Get();
+      columnsReport(XO("in one thread"), compute(serial, synchronous));
+      columnsReport(XO("in %lld threads")
+            .Format( (long long) pool.GetNumThreads() + 1 ),
+         compute(parallel, pool));
+
+      if (serial.freq != parallel.freq) {
+         Printf( XO("Spectrogram columns differ between one and several threads.\n") );
+         goto fail;
+      }
+   }
+
+   {
+      Printf( XO("Streaming samples through a ring buffer...\n") );
+
+      // A producer thread writes in place, as the audio thread does, and the
+      // consumer reads in place, as the PortAudio callback does, either as
+      // fast as it can or waking at regular periods
+      using Clock = std::chrono::steady_clock;
+      constexpr size_t ringSize = 16384, callbackSize = 512;
+      // Counting values that floats represent exactly
+      constexpr size_t modulus = 1 << 20;
+      const auto stream = [&](size_t total, Clock::duration period,
+         double &maxLateMs, double &meanLateMs) {
+         RingBuffer ring{ floatSample, ringSize };
+         std::thread producer{ [&]{
+            for (size_t next = 0; next < total;) {
+               size_t put = 0;
+               for (const auto &[ptr, size] : ring.AcquireForPut(total - next)) {
+                  const auto floats = reinterpret_cast<float*>(ptr);
+                  for (size_t ii = 0; ii < size; ++ii)
+                     floats[ii] = (next++) % modulus;
+                  put += size;
+               }
+               if (put) {
+                  ring.CommitPut(put);
+                  ring.Flush();
+               }
+               else
+                  std::this_thread::yield();
+            }
+         } };
+
+         bool ok = true;
+         size_t expected = 0;
+         size_t wakeups = 0;
+         double sumLateMs = 0;
+         maxLateMs = 0;
+         auto deadline = Clock::now();
+         const auto start = deadline;
+         while (expected < total) {
+            if (period.count() > 0) {
+               deadline += period;
+               std::this_thread::sleep_until(deadline);
+               const double lateMs = std::chrono::duration<double, std::milli>(
+                  Clock::now() - deadline).count();
+               maxLateMs = std::max(maxLateMs, lateMs);
+               sumLateMs += lateMs;
+               ++wakeups;
+            }
+            size_t got = 0;
+            for (const auto &[ptr, size] :
+               ring.AcquireForGet(std::min(callbackSize, total - expected))) {
+               const auto floats = reinterpret_cast<const float*>(ptr);
+               for (size_t ii = 0; ii < size; ++ii)
+                  ok = ok && floats[ii] == (expected++) % modulus;
+               got += size;
+            }
+            ring.CommitGet(got);
+         }
+         const auto elapsed = Clock::now() - start;
+         producer.join();
+         meanLateMs = wakeups ? sumLateMs / wakeups : 0;
+         return ok ? std::chrono::duration<double>(elapsed).count() : -1.0;
+      };
+
+      double maxLateMs, meanLateMs;
+      constexpr size_t fastTotal = size_t(1) << 26;
+      const auto seconds = stream(fastTotal, {}, maxLateMs, meanLateMs);
+      // Pace the consumer like a callback of 512 frames at 44100 Hz,
+      // for about two seconds
+      constexpr size_t pacedTotal = 172 * callbackSize;
+      const auto pacedSeconds = stream(pacedTotal,
+         std::chrono::microseconds{ 11610 }, maxLateMs, meanLateMs);
+      if (seconds < 0 || pacedSeconds < 0) {
+         Printf( XO("Samples were lost or reordered in the ring buffer.\n") );
+         goto fail;
+      }
+      Printf( XO("Streamed %lld samples in %ld ms (%.1f million samples per second)\n")
+         .Format( (long long) fastTotal, long(seconds * 1000),
+            fastTotal / std::max(seconds, 1e-6) / 1e6 ) );
+      Printf( XO("Consumer woke %.3f ms late on average, %.3f ms at most\n")
+         .Format( meanLateMs, maxLateMs ) );
+   }
+
+   {
+      // Find silences with the analysis of Truncate Silence, reading every
+      // sample or skipping buffers that summaries show to be quiet; the
+      // regions, and the input lengths for previews, must be the same
+      Printf( XO("Finding silences...\n") );
+      wxTheApp->Yield();
+      FlushPrint();
+
+      constexpr double silenceRate = 44100;
+      const auto st = WaveTrackFactory{ mRate, pFactory }
+         .Create(floatSample, silenceRate);
+      const auto maxBlock = st->GetMaxBlockSize();
+
+      // Runs of quiet noise and of loud sound, some at the threshold, of
+      // lengths from one sample to several blocks, in two clips with a gap
+      std::mt19937 engine{ unsigned(randSeed) };
+      const auto appendRuns = [&](size_t total){
+         std::vector<float> samples;
+         for (size_t appended = 0; appended < total;
+              appended += samples.size()) {
+            const bool quiet = engine() % 4 != 0;
+            const size_t len = (engine() % 2)
+               ? 1 + engine() % 300
+               : 1 + engine() % (3 * maxBlock);
+            std::uniform_real_distribution<float> distribution{
+               quiet ? -0.0999f : 0.1f, quiet ? 0.0999f : 0.9f };
+            samples.resize(len);
+            for (auto &sample : samples)
+               sample = distribution(engine) * ((engine() % 2) ? 1 : -1);
+            if (!quiet && engine() % 8 == 0)
+               samples[engine() % len] = 0.1f;
+            st->Append((samplePtr)samples.data(), floatSample, len);
+         }
+         st->Flush();
+      };
+      appendRuns(40 * maxBlock);
+      st->CreateClip(st->GetEndTime() + 1000 / silenceRate);
+      appendRuns(20 * maxBlock);
+      const auto t1 = st->GetEndTime();
+
+      // Silent regions found in other tracks, as the analysis of each track
+      // is given after the first, so that it skips ahead between them
+      RegionList otherSilences;
+      {
+         std::uniform_real_distribution<double> time{ 0, t1 };
+         std::vector<double> times(40);
+         for (auto &t : times)
+            t = time(engine);
+         std::sort(times.begin(), times.end());
+         for (size_t ii = 0; ii < times.size(); ii += 2)
+            otherSilences.push_back({ times[ii], times[ii + 1] });
+      }
+
+      // The regions as FindSilences() makes them
+      const auto analyze = [&](
+         const EffectTruncSilence::AnalysisParameters &parameters,
+         RegionList silenceList){
+         RegionList trackSilences;
+         sampleCount silentFrame = 0;
+         auto index = st->TimeToLongSamples(parameters.t0);
+         EffectTruncSilence::Analyze(parameters, {},
+            silenceList, trackSilences, st.get(), &silentFrame, &index);
+         const auto minSilenceFrames = sampleCount(
+            parameters.initialAllowedSilence * st->GetRate());
+         if (silentFrame >= minSilenceFrames)
+            trackSilences.push_back({
+               st->LongSamplesToTime(index - silentFrame),
+               st->LongSamplesToTime(index) });
+         return trackSilences;
+      };
+      const auto same = [](const RegionList &a, const RegionList &b){
+         return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+            [](const WaveTrack::Region &x, const WaveTrack::Region &y){
+               return x.start == y.start && x.end == y.end; });
+      };
+
+      // The input length for a preview, as CalcPreviewInputLength() finds
+      const auto previewLength = [&](
+         const EffectTruncSilence::AnalysisParameters &parameters,
+         RegionList &trackSilences){
+         RegionList silenceList;
+         silenceList.push_back({ parameters.t0, parameters.t1 });
+         double inputLength = parameters.t1 - parameters.t0;
+         double minInputLength = inputLength;
+         sampleCount silentFrame = 0;
+         auto index = st->TimeToLongSamples(parameters.t0);
+         EffectTruncSilence::Analyze(parameters, {},
+            silenceList, trackSilences, st.get(), &silentFrame, &index,
+            &inputLength, &minInputLength);
+         return std::make_pair(inputLength, minInputLength);
+      };
+
+      long samplesMs = 0, summariesMs = 0;
+      size_t nSilences = 0, nBuffers = 0, nQuiet = 0;
+      for (const double level : { 0.1, 0.5, 0.01 })
+         for (const sampleCount start : { 0, 1, 12345 })
+            for (const double minimum : { 0.001, 0.05 })
+               for (const int action : { EffectTruncSilence::kTruncate,
+                                         EffectTruncSilence::kCompress }) {
+            EffectTruncSilence::AnalysisParameters parameters{
+               start.as_double() / silenceRate, t1, LINEAR_TO_DB(level),
+               action, minimum, 0.01, 50.0, false };
+            auto summaries = parameters;
+            summaries.useSummaries = true;
+
+            for (const bool others : { false, true }) {
+               RegionList silenceList;
+               if (others)
+                  silenceList = otherSilences;
+               else
+                  silenceList.push_back({ parameters.t0, parameters.t1 });
+
+               timer.Start();
+               const auto expected = analyze(parameters, silenceList);
+               samplesMs += timer.Time();
+               timer.Start();
+               const auto actual = analyze(summaries, silenceList);
+               summariesMs += timer.Time();
+               if (!same(actual, expected)) {
+                  Printf( XO("Silences found with summaries differ, at threshold %g, from sample %lld.\n")
+                     .Format( level, start.as_long_long() ) );
+                  goto fail;
+               }
+               nSilences += expected.size();
+            }
+
+            RegionList expected, actual;
+            if (previewLength(summaries, actual) !=
+                   previewLength(parameters, expected) ||
+                !same(actual, expected)) {
+               Printf( XO("Preview lengths found with summaries differ, at threshold %g, from sample %lld.\n")
+                  .Format( level, start.as_long_long() ) );
+               goto fail;
+            }
+
+            const auto end = st->TimeToLongSamples(t1);
+            const auto threshold = DB_TO_LINEAR(parameters.thresholdDB);
+            for (auto index = start; index < end; index += maxBlock) {
+               ++nBuffers;
+               if (st->IsQuieterThan(index,
+                  limitSampleBufferSize(maxBlock, end - index), threshold))
+                  ++nQuiet;
+            }
+         }
+      if (nQuiet == 0) {
+         Printf( XO("Summaries showed no buffer to be silent.\n") );
+         goto fail;
+      }
+      Printf( XO("Found %lld silences reading all samples in %ld ms, and with summaries, which showed %lld of %lld buffers to be silent, in %ld ms\n")
+         .Format( (long long) nSilences, samplesMs,
+            (long long) nQuiet, (long long) nBuffers, summariesMs ) );
+   }
+
+   {
+      // Make random edits of a long sequence of small blocks, which are
+      // all shared until edits make new ones; then check samples against
+      // runs that describe what they should be
+      constexpr size_t nBlocks = 100000;
+      constexpr int nSequenceEdits = 10000;
+      Printf( XO("Editing a sequence of %lld blocks...\n")
+         .Format( (long long) nBlocks ) );
+      wxTheApp->Yield();
+      FlushPrint();
+
+      Sequence::SetMaxDiskBlockSize(4096);
+      const auto restore = finally( [&] {
+         Sequence::SetMaxDiskBlockSize(blockSize * 1024);
+      } );
+      Sequence seq{ pFactory, floatSample };
+      const auto blockLen = seq.GetMaxBlockSize();
+      {
+         // Each sample of the block is its offset
+         std::vector<float> values(blockLen);
+         for (size_t ii = 0; ii < blockLen; ++ii)
+            values[ii] = ii;
+         const auto pBlock = seq.AppendNewBlock(
+            (constSamplePtr)values.data(), floatSample, blockLen);
+         for (size_t ii = 1; ii < nBlocks; ++ii)
+            seq.AppendSharedBlock(pBlock);
+      }
+
+      // Silence, or the block's values from some offset
+      struct Run { sampleCount len; long long offset; bool silent; };
+      std::vector<Run> runs{ { seq.GetNumSamples(), 0, false } };
+      // Split runs so one begins at the position, and return its index
+      const auto splitAt = [&](sampleCount pos){
+         size_t ii = 0;
+         for (; ii < runs.size() && pos >= runs[ii].len; ++ii)
+            pos -= runs[ii].len;
+         if (pos > 0) {
+            auto second = runs[ii];
+            second.len -= pos;
+            second.offset = (second.offset + pos.as_long_long()) % blockLen;
+            runs[ii].len = pos;
+            runs.insert(runs.begin() + ii + 1, second);
+            ++ii;
+         }
+         return ii;
+      };
+
+      // Choose the edits, and their effects, before timing them
+      enum EditType { Delete, InsertSilence, SetSilence, CopyPaste };
+      struct Edit { EditType type; sampleCount start, len, from; };
+      std::vector<Edit> edits;
+      std::mt19937 engine{ unsigned(randSeed) };
+      auto numSamples = seq.GetNumSamples();
+      for (int ii = 0; ii < nSequenceEdits; ++ii) {
+         const auto type = EditType(engine() % 4);
+         const sampleCount start = engine() % numSamples.as_long_long();
+         const sampleCount len = std::min<sampleCount>(
+            1 + engine() % (3 * blockLen), numSamples - start);
+         const sampleCount from = engine() % numSamples.as_long_long();
+         edits.push_back({ type, start, len, from });
+         switch (type) {
+         case Delete:
+         case SetSilence: {
+            const auto first = splitAt(start), last = splitAt(start + len);
+            runs.erase(runs.begin() + first, runs.begin() + last);
+            if (type == SetSilence)
+               runs.insert(runs.begin() + first, Run{ len, 0, true });
+            else
+               numSamples -= len;
+            break;
+         }
+         case InsertSilence:
+            runs.insert(runs.begin() + splitAt(start), Run{ len, 0, true });
+            numSamples += len;
+            break;
+         case CopyPaste: {
+            const auto copyLen = std::min(len, numSamples - from);
+            const auto first = splitAt(from),
+               last = splitAt(from + copyLen);
+            const std::vector<Run> copied{
+               runs.begin() + first, runs.begin() + last };
+            const auto at = splitAt(start);
+            runs.insert(runs.begin() + at, copied.begin(), copied.end());
+            numSamples += copyLen;
+            break;
+         }
+         }
+      }
+
+      timer.Start();
+      for (const auto &edit : edits)
+         switch (edit.type) {
+         case Delete:
+            seq.Delete(edit.start, edit.len);
+            break;
+         case InsertSilence:
+            seq.InsertSilence(edit.start, edit.len);
+            break;
+         case SetSilence:
+            seq.SetSilence(edit.start, edit.len);
+            break;
+         case CopyPaste: {
+            const auto copied = seq.Copy(pFactory, edit.from,
+               std::min(edit.from + edit.len, seq.GetNumSamples()));
+            seq.Paste(edit.start, copied.get());
+            break;
+         }
+         }
+      const auto editsMs = timer.Time();
+
+      if (seq.GetNumSamples() != numSamples) {
+         Printf( XO("Edited sequence has %lld samples, but should have %lld.\n")
+            .Format( seq.GetNumSamples().as_long_long(),
+               numSamples.as_long_long() ) );
+         goto fail;
+      }
+      for (int ii = 0; ii < 1000; ++ii) {
+         sampleCount pos = engine() % numSamples.as_long_long();
+         float value = -1;
+         seq.Get((samplePtr)&value, floatSample, pos, 1, true);
+         auto iRun = runs.begin();
+         while (pos >= iRun->len)
+            pos -= (iRun++)->len;
+         const float expected = iRun->silent ? 0
+            : (iRun->offset + pos.as_long_long()) % blockLen;
+         if (value != expected) {
+            Printf( XO("Edited sequence has wrong samples.\n") );
+            goto fail;
+         }
+      }
+
+      Printf( XO("Performed %d random edits of %lld blocks in %ld ms (%.1f edits per ms), leaving %lld blocks\n")
+         .Format( nSequenceEdits, (long long) nBlocks, editsMs,
+            nSequenceEdits / std::max(1.0, double(editsMs)),
+            (long long) seq.GetBlockArray().size() ) );
+   }
+
+   {
+      // Reduce noise in long mono and stereo sources, in one thread, and in
+      // concurrent segments; the samples must be the same
+      Printf( XO("Reducing noise...\n") );
+      wxTheApp->Yield();
+      FlushPrint();
+
+      constexpr double noiseRate = 44100;
+      constexpr double noiseSeconds = 180;
+      std::mt19937 engine{ unsigned(randSeed) };
+      std::normal_distribution<float> noiseDistribution{ 0.0f, 0.05f };
+      const auto makeTrack = [&](sampleCount len, double amplitude){
+         const auto result = WaveTrackFactory{ mRate, pFactory }
+            .Create(floatSample, noiseRate);
+         const auto bufferSize = result->GetMaxBlockSize();
+         Floats buffer{ bufferSize };
+         for (sampleCount done = 0; done < len;) {
+            const auto count = limitSampleBufferSize(bufferSize, len - done);
+            for (size_t ii = 0; ii < count; ++ii)
+               buffer[ii] = noiseDistribution(engine) + amplitude *
+                  sin(2 * M_PI * 440 * (done + ii).as_double() / noiseRate);
+            result->Append((samplePtr)buffer.get(), floatSample, count);
+            done += count;
+         }
+         result->Flush();
+         return result;
+      };
+      const auto noise = makeTrack(sampleCount(2 * noiseRate), 0);
+
+      ThreadPool synchronous{ 0 };
+      auto &pool = ThreadPool::Get();
+      for (const size_t nChannels : { 1, 2 }) {
+         std::vector<std::shared_ptr<WaveTrack>> serial, concurrent;
+         for (size_t iChannel = 0; iChannel < nChannels; ++iChannel) {
+            serial.push_back(makeTrack(
+               sampleCount(noiseSeconds * noiseRate), 0.5));
+            concurrent.push_back(serial.back()->EmptyCopy());
+            concurrent.back()->Paste(0, serial.back().get());
+         }
+         const auto reduce = [&](
+            std::vector<std::shared_ptr<WaveTrack>> &tracks,
+            ThreadPool &threads){
+            std::vector<WaveTrack*> channels;
+            for (const auto &pTrack : tracks)
+               channels.push_back(pTrack.get());
+            timer.Start();
+            const auto result =
+               EffectNoiseReduction{}.ReduceNoise(*noise, channels, threads);
+            return result ? timer.Time() : -1;
+         };
+         const auto serialMs = reduce(serial, synchronous);
+         const auto concurrentMs = reduce(concurrent, pool);
+         if (serialMs < 0 || concurrentMs < 0) {
+            Printf( XO("Noise reduction failed.\n") );
+            goto fail;
+         }
+
+         for (size_t iChannel = 0; iChannel < nChannels; ++iChannel) {
+            const auto &expected = *serial[iChannel];
+            const auto &actual = *concurrent[iChannel];
+            const auto len = expected.TimeToLongSamples(expected.GetEndTime());
+            if (len != actual.TimeToLongSamples(actual.GetEndTime())) {
+               Printf( XO("Noise reduction in segments changed the length.\n") );
+               goto fail;
+            }
+            const auto bufferSize = expected.GetMaxBlockSize();
+            Floats buffer1{ bufferSize }, buffer2{ bufferSize };
+            for (sampleCount done = 0; done < len;) {
+               const auto count = limitSampleBufferSize(bufferSize, len - done);
+               expected.GetFloats(buffer1.get(), done, count);
+               actual.GetFloats(buffer2.get(), done, count);
+               if (!std::equal(buffer1.get(), buffer1.get() + count,
+                  buffer2.get())) {
+                  Printf( XO("Noise reduction in segments differs, in channel %lld near sample %lld.\n")
+                     .Format( (long long) iChannel, done.as_long_long() ) );
+                  goto fail;
+               }
+               done += count;
+            }
+         }
+
+         Printf( XO("Reduced noise in %lld channels of %g s in one thread in %ld ms, and in %lld threads in %ld ms\n")
+            .Format( (long long) nChannels, noiseSeconds, serialMs,
+               (long long) pool.GetNumThreads() + 1, concurrentMs ) );
+      }
+   }
+
+   if (importSize > 0) {
+      // Write a multichannel float WAV file, then time the import of it,
+      // which makes sample blocks directly from the decoded samples
+      constexpr int importChannels = 8;
+      constexpr sf_count_t chunkFrames = 65536;
+      const auto totalFrames = sf_count_t(
+         importSize * 1048576ull / (importChannels * sizeof(float)));
+      const auto expected = [](sf_count_t frame, int channel){
+         // Values that floats represent exactly
+         return ((frame + 1000 * channel) % 32768) / 32768.0f;
+      };
+
+      Printf( XO("Writing a WAV file of %d channels, %ld MB...\n")
+         .Format( importChannels, importSize ) );
+      wxTheApp->Yield();
+      FlushPrint();
+
+      const auto placeholder =
+         wxFileName::CreateTempFileName(wxT("AudacityBenchmark"));
+      const auto path = placeholder + wxT(".wav");
+      const auto removeFiles = finally( [&] {
+         ::wxRemoveFile(placeholder);
+         ::wxRemoveFile(path);
+      } );
+
+      {
+         SF_INFO info{};
+         info.samplerate = 44100;
+         info.channels = importChannels;
+         // Plain WAV can't describe 4 GB of data or more
+         info.format = SF_FORMAT_FLOAT |
+            (importSize < 4000 ? SF_FORMAT_WAV : SF_FORMAT_RF64);
+         wxFile f;
+         SFFile file;
+         if (f.Create(path, true))
+            file.reset(
+               SFCall<SNDFILE*>(sf_open_fd, f.fd(), SFM_WRITE, &info, TRUE));
+         // The file descriptor is now owned by "file"
+         f.Detach();
+
+         bool written = !!file;
+         std::vector<float> interleaved(chunkFrames * importChannels);
+         for (sf_count_t done = 0; written && done < totalFrames;) {
+            const auto n = std::min(chunkFrames, totalFrames - done);
+            for (sf_count_t ii = 0; ii < n; ++ii)
+               for (int c = 0; c < importChannels; ++c)
+                  interleaved[ii * importChannels + c] = expected(done + ii, c);
+            written = SFCall<sf_count_t>(sf_writef_float,
+               file.get(), interleaved.data(), n) == n;
+            done += n;
+         }
+         if (!written || file.close() != 0) {
+            Printf( XO("Could not write %s.\n").Format( path ) );
+            goto fail;
+         }
+      }
+
+      Printf( XO("Importing...\n") );
+      wxTheApp->Yield();
+      FlushPrint();
+
+      TrackHolders tracks;
+      Tags tags;
+      TranslatableString errorMessage;
+      WaveTrackFactory importFactory{ mRate, pFactory };
+      timer.Start();
+      const bool imported = Importer::Get().Import(mProject, path,
+         &importFactory, tracks, &tags, errorMessage);
+      elapsed = timer.Time();
+
+      if (!imported || tracks.size() != 1 ||
+          tracks[0].size() != importChannels) {
+         Printf( XO("Import failed. %s\n").Format( errorMessage ) );
+         goto fail;
+      }
+      const size_t checkLen = 1000;
+      std::vector<float> check(checkLen);
+      for (int c = 0; c < importChannels; ++c) {
+         const auto &track = *tracks[0][c];
+         const auto numSamples =
+            track.GetClipByIndex(0)->GetSequence()->GetNumSamples();
+         if (numSamples != totalFrames) {
+            Printf( XO("Expected len %lld, imported len %lld.\n")
+               .Format( (long long) totalFrames,
+                  numSamples.as_long_long() ) );
+            goto fail;
+         }
+         const auto start = std::max<sf_count_t>(0, totalFrames - checkLen);
+         const auto len = size_t(totalFrames - start);
+         track.GetFloats(check.data(), start, len);
+         for (size_t ii = 0; ii < len; ++ii)
+            if (check[ii] != expected(start + ii, c)) {
+               Printf( XO("Imported samples differ from the file.\n") );
+               goto fail;
+            }
+      }
+
+      const double megabytes =
+         totalFrames * importChannels * sizeof(float) / 1048576.0;
+      Printf( XO("Imported %.1f MB in %ld ms (%.1f MB/s)\n")
+         .Format( megabytes, elapsed,
+            megabytes * 1000.0 / std::max(1L, elapsed) ) );
+   }
+
    goto success;
 
  fail:
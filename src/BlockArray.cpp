@@ -0,0 +1,330 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file BlockArray.cpp
+  @brief Persistent sequence of the sample blocks of a Sequence
+
+**********************************************************************/
+
+#include "BlockArray.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "SampleBlock.h"
+
+//! Immutable node of an AVL tree, with statistics of its subtree
+struct BlockArrayNode
+{
+   BlockArrayNode(BlockArray::NodePtr left_,
+      const SeqBlock::SampleBlockPtr &sb_, BlockArray::NodePtr right_);
+
+   const BlockArray::NodePtr left, right;
+   const SeqBlock::SampleBlockPtr sb;
+   //! Sample count of sb alone
+   const size_t length;
+
+   // Of the subtree:
+   const size_t count;
+   const sampleCount samples;
+   const size_t maxLength;
+   const bool hasNull;
+   const int height;
+};
+
+namespace {
+using NodePtr = BlockArray::NodePtr;
+using SampleBlockPtr = SeqBlock::SampleBlockPtr;
+
+int Height(const NodePtr &p) { return p ? p->height : 0; }
+size_t Count(const NodePtr &p) { return p ? p->count : 0; }
+sampleCount Samples(const NodePtr &p) { return p ? p->samples : 0; }
+size_t MaxLength(const NodePtr &p) { return p ? p->maxLength : 0; }
+bool HasNull(const NodePtr &p) { return p && p->hasNull; }
+
+NodePtr Make(const NodePtr &left, const SampleBlockPtr &sb,
+   const NodePtr &right)
+{
+   return std::make_shared<const BlockArrayNode>(left, sb, right);
+}
+
+NodePtr RotateLeft(const NodePtr &p)
+{
+   const auto &r = p->right;
+   return Make(Make(p->left, p->sb, r->left), r->sb, r->right);
+}
+
+NodePtr RotateRight(const NodePtr &p)
+{
+   const auto &l = p->left;
+   return Make(l->left, l->sb, Make(l->right, p->sb, p->right));
+}
+
+// Joins of trees with a block between them, as in "Just Join for Parallel
+// Ordered Sets" (Blelloch, Ferizovic, and Sun), specialized to AVL trees
+
+//! @pre `Height(left) > Height(right) + 1`
+NodePtr JoinRight(const NodePtr &left, const SampleBlockPtr &sb,
+   const NodePtr &right)
+{
+   const auto &middle = left->right;
+   if (Height(middle) <= Height(right) + 1) {
+      auto joined = Make(middle, sb, right);
+      if (Height(joined) <= Height(left->left) + 1)
+         return Make(left->left, left->sb, joined);
+      return RotateLeft(Make(left->left, left->sb, RotateRight(joined)));
+   }
+   auto joined = JoinRight(middle, sb, right);
+   auto result = Make(left->left, left->sb, joined);
+   if (Height(joined) <= Height(left->left) + 1)
+      return result;
+   return RotateLeft(result);
+}
+
+//! @pre `Height(right) > Height(left) + 1`
+NodePtr JoinLeft(const NodePtr &left, const SampleBlockPtr &sb,
+   const NodePtr &right)
+{
+   const auto &middle = right->left;
+   if (Height(middle) <= Height(left) + 1) {
+      auto joined = Make(left, sb, middle);
+      if (Height(joined) <= Height(right->right) + 1)
+         return Make(joined, right->sb, right->right);
+      return RotateRight(Make(RotateLeft(joined), right->sb, right->right));
+   }
+   auto joined = JoinLeft(left, sb, middle);
+   auto result = Make(joined, right->sb, right->right);
+   if (Height(joined) <= Height(right->right) + 1)
+      return result;
+   return RotateRight(result);
+}
+
+NodePtr Join(const NodePtr &left, const SampleBlockPtr &sb,
+   const NodePtr &right)
+{
+   if (Height(left) > Height(right) + 1)
+      return JoinRight(left, sb, right);
+   if (Height(right) > Height(left) + 1)
+      return JoinLeft(left, sb, right);
+   return Make(left, sb, right);
+}
+
+//! Trees of the first n blocks, and of the rest
+std::pair<NodePtr, NodePtr> Split(const NodePtr &p, size_t n)
+{
+   if (!p)
+      return {};
+   const auto leftCount = Count(p->left);
+   if (n <= leftCount) {
+      auto [left, right] = Split(p->left, n);
+      return { std::move(left), Join(right, p->sb, p->right) };
+   }
+   auto [left, right] = Split(p->right, n - leftCount - 1);
+   return { Join(p->left, p->sb, left), std::move(right) };
+}
+
+NodePtr Concat(const NodePtr &left, const NodePtr &right)
+{
+   if (!left)
+      return right;
+   if (!right)
+      return left;
+   // Remove the last block of the left, to join the trees about it
+   auto [rest, last] = Split(left, left->count - 1);
+   return Join(rest, last->sb, right);
+}
+
+NodePtr Replace(const NodePtr &p, size_t b, const SampleBlockPtr &sb)
+{
+   const auto leftCount = Count(p->left);
+   if (b < leftCount)
+      return Make(Replace(p->left, b, sb), p->sb, p->right);
+   if (b == leftCount)
+      return Make(p->left, sb, p->right);
+   return Make(p->left, p->sb, Replace(p->right, b - leftCount - 1, sb));
+}
+
+size_t MemoryUsage(const NodePtr &p, BlockArrayNodeSet &seen)
+{
+   if (!p || !seen.insert(p.get()).second)
+      return 0;
+   return sizeof(BlockArrayNode)
+      + MemoryUsage(p->left, seen) + MemoryUsage(p->right, seen);
+}
+}
+
+BlockArrayNode::BlockArrayNode(BlockArray::NodePtr left_,
+   const SeqBlock::SampleBlockPtr &sb_, BlockArray::NodePtr right_)
+   : left{ std::move(left_) }
+   , right{ std::move(right_) }
+   , sb{ sb_ }
+   , length{ sb ? sb->GetSampleCount() : 0 }
+   , count{ Count(left) + 1 + Count(right) }
+   , samples{ Samples(left) + length + Samples(right) }
+   , maxLength{ std::max({ MaxLength(left), length, MaxLength(right) }) }
+   , hasNull{ !sb || HasNull(left) || HasNull(right) }
+   , height{ 1 + std::max(Height(left), Height(right)) }
+{
+}
+
+BlockArray::BlockArray(NodePtr root, sampleCount origin)
+   : mRoot{ std::move(root) }
+   , mOrigin{ origin }
+{
+}
+
+size_t BlockArray::size() const
+{
+   return Count(mRoot);
+}
+
+sampleCount BlockArray::GetSampleCount() const
+{
+   return Samples(mRoot);
+}
+
+size_t BlockArray::GetMaxBlockSampleCount() const
+{
+   return MaxLength(mRoot);
+}
+
+bool BlockArray::HasNullBlocks() const
+{
+   return HasNull(mRoot);
+}
+
+SeqBlock BlockArray::operator [] (size_t b) const
+{
+   auto start = mOrigin;
+   auto p = mRoot.get();
+   while (p) {
+      const auto leftCount = Count(p->left);
+      if (b < leftCount)
+         p = p->left.get();
+      else {
+         start += Samples(p->left);
+         if (b == leftCount)
+            return { p->sb, start };
+         b -= leftCount + 1;
+         start += p->length;
+         p = p->right.get();
+      }
+   }
+   // Precondition violated
+   return {};
+}
+
+auto BlockArray::IteratorAt(size_t b) const -> const_iterator
+{
+   const_iterator result;
+   if (b >= size())
+      return result;
+   auto start = mOrigin;
+   auto p = mRoot.get();
+   while (true) {
+      const auto leftCount = Count(p->left);
+      if (b < leftCount) {
+         result.mPath.push_back(p);
+         p = p->left.get();
+      }
+      else {
+         start += Samples(p->left);
+         if (b == leftCount) {
+            result.mPath.push_back(p);
+            break;
+         }
+         b -= leftCount + 1;
+         start += p->length;
+         p = p->right.get();
+      }
+   }
+   result.mBlock.start = start;
+   result.Update();
+   return result;
+}
+
+auto BlockArray::const_iterator::operator ++ () -> const_iterator &
+{
+   const auto p = mPath.back();
+   mPath.pop_back();
+   mBlock.start += p->length;
+   for (auto q = p->right.get(); q; q = q->left.get())
+      mPath.push_back(q);
+   Update();
+   return *this;
+}
+
+void BlockArray::const_iterator::Update()
+{
+   if (mPath.empty())
+      mBlock = {};
+   else
+      mBlock.sb = mPath.back()->sb;
+}
+
+size_t BlockArray::FindBlock(sampleCount pos) const
+{
+   pos -= mOrigin;
+   size_t result = 0;
+   auto p = mRoot.get();
+   while (p) {
+      const auto leftSamples = Samples(p->left);
+      if (pos < leftSamples)
+         p = p->left.get();
+      else {
+         pos -= leftSamples;
+         result += Count(p->left);
+         // Past the end, contrary to the precondition, give the last block
+         if (pos < sampleCount(p->length) || !p->right)
+            break;
+         pos -= p->length;
+         ++result;
+         p = p->right.get();
+      }
+   }
+   return result;
+}
+
+void BlockArray::push_back(const SeqBlock &block)
+{
+   mRoot = Join(mRoot, block.sb, nullptr);
+}
+
+void BlockArray::pop_back()
+{
+   mRoot = Split(mRoot, size() - 1).first;
+}
+
+void BlockArray::clear()
+{
+   mRoot.reset();
+   mOrigin = 0;
+}
+
+void BlockArray::swap(BlockArray &other)
+{
+   mRoot.swap(other.mRoot);
+   std::swap(mOrigin, other.mOrigin);
+}
+
+void BlockArray::Set(size_t b, const SeqBlock::SampleBlockPtr &sb)
+{
+   mRoot = Replace(mRoot, b, sb);
+}
+
+BlockArray BlockArray::Slice(size_t b0, size_t b1) const
+{
+   auto [before, rest] = Split(mRoot, b0);
+   return { Split(rest, b1 - b0).first, mOrigin + Samples(before) };
+}
+
+void BlockArray::Append(const BlockArray &other)
+{
+   mRoot = Concat(mRoot, other.mRoot);
+}
+
+size_t BlockArray::AccumulateMemoryUsage(BlockArrayNodeSet &seen) const
+{
+   return MemoryUsage(mRoot, seen);
+}
@@ -0,0 +1,166 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file BlockArray.h
+  @brief Persistent sequence of the sample blocks of a Sequence
+
+**********************************************************************/
+
+#ifndef __AUDACITY_BLOCK_ARRAY__
+#define __AUDACITY_BLOCK_ARRAY__
+
+#include <iterator>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "SampleCount.h"
+
+class SampleBlock;
+
+// This is an internal data structure!  For advanced use only.
+class SeqBlock {
+ public:
+   using SampleBlockPtr = std::shared_ptr<SampleBlock>;
+   SampleBlockPtr sb;
+   ///the sample in the global wavetrack that this block starts at.
+   sampleCount start;
+
+   SeqBlock()
+      : sb{}, start(0)
+   {}
+
+   SeqBlock(const SampleBlockPtr &sb_, sampleCount start_)
+      : sb(sb_), start(start_)
+   {}
+
+   // Construct a SeqBlock with changed start, same file
+   SeqBlock Plus(sampleCount delta) const
+   {
+      return SeqBlock(sb, start + delta);
+   }
+};
+
+struct BlockArrayNode;
+using BlockArrayNodeSet = std::unordered_set<const BlockArrayNode *>;
+
+//! Sequence of SeqBlock, as a balanced tree of immutable nodes
+/*!
+ Copies share all nodes, and edits copy only the nodes on paths from the root,
+ so copying is constant time, and indexing, finding the block that contains a
+ sample, splitting, and concatenation are logarithmic in the number of blocks.
+
+ Starts of blocks are not stored, but are sums of the sample counts of the
+ preceding blocks, after the start of the first block, which is zero except in
+ slices.  So starts given with appended blocks are ignored, and starts of
+ blocks after an edit never need updating.
+ */
+class BlockArray
+{
+public:
+   using NodePtr = std::shared_ptr<const BlockArrayNode>;
+
+   //! Visits blocks in order, with their starts
+   /*! Like other iterators of containers, invalidated by changes of the
+    array */
+   class const_iterator
+   {
+   public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = SeqBlock;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const SeqBlock *;
+      using reference = const SeqBlock &;
+
+      const_iterator() = default;
+
+      reference operator * () const { return mBlock; }
+      pointer operator -> () const { return &mBlock; }
+      const_iterator &operator ++ ();
+      const_iterator operator ++ (int)
+         { auto result = *this; ++*this; return result; }
+
+      friend bool operator == (
+         const const_iterator &a, const const_iterator &b)
+         { return a.Top() == b.Top(); }
+      friend bool operator != (
+         const const_iterator &a, const const_iterator &b)
+         { return !(a == b); }
+
+   private:
+      friend BlockArray;
+      const BlockArrayNode *Top() const
+         { return mPath.empty() ? nullptr : mPath.back(); }
+      //! Set mBlock from the top of the path
+      void Update();
+
+      //! Nodes whose blocks, and right subtrees, are not yet visited
+      std::vector<const BlockArrayNode *> mPath;
+      SeqBlock mBlock;
+   };
+
+   BlockArray() = default;
+
+   size_t size() const;
+   bool empty() const { return !mRoot; }
+   //! Total of the sample counts of the blocks
+   sampleCount GetSampleCount() const;
+   //! Largest sample count of a block, or zero if empty
+   size_t GetMaxBlockSampleCount() const;
+   //! Whether any block has a null pointer
+   bool HasNullBlocks() const;
+
+   //! Logarithmic time
+   /*! @pre `b < size()` */
+   SeqBlock operator [] (size_t b) const;
+   SeqBlock front() const { return (*this)[0]; }
+   SeqBlock back() const { return (*this)[size() - 1]; }
+
+   const_iterator begin() const { return IteratorAt(0); }
+   const_iterator end() const { return {}; }
+   //! Iterator to the block at the index, or end() if `b >= size()`
+   const_iterator IteratorAt(size_t b) const;
+
+   //! Index of the block that contains the sample
+   /*! @pre `front().start <= pos && pos < front().start + GetSampleCount()` */
+   size_t FindBlock(sampleCount pos) const;
+
+   //! The block's start is ignored
+   void push_back(const SeqBlock &block);
+   void emplace_back(const SeqBlock::SampleBlockPtr &sb, sampleCount start)
+      { push_back({ sb, start }); }
+   //! @pre `!empty()`
+   void pop_back();
+   void clear();
+   void swap(BlockArray &other);
+
+   //! Replace the sample block at the index, shifting starts of later blocks
+   //! if the sample count changes
+   /*! @pre `b < size()` */
+   void Set(size_t b, const SeqBlock::SampleBlockPtr &sb);
+
+   //! Blocks b0 up to but excluding b1, sharing the nodes of this, and with
+   //! the same starts
+   /*! @pre `b0 <= b1 && b1 <= size()` */
+   BlockArray Slice(size_t b0, size_t b1) const;
+
+   //! Append all of the other array's blocks, after those of this, and
+   //! ignoring the other's starts
+   void Append(const BlockArray &other);
+
+   //! Bytes of memory of the nodes not already in the set, which are added
+   /*! Nodes in the set are not visited again, nor are their descendants, so
+    the cost is proportional to the nodes not shared with arrays visited
+    before */
+   size_t AccumulateMemoryUsage(BlockArrayNodeSet &seen) const;
+
+private:
+   BlockArray(NodePtr root, sampleCount origin);
+
+   NodePtr mRoot;
+   //! Start of the first block
+   sampleCount mOrigin{ 0 };
+};
+
+#endif
@@ -26,6 +26,10 @@ Paul Licameli -- split from ProjectFileIO.cpp
 
 #define AUDACITY_PROJECT_PAGE_SIZE 65536
 
+// Largest mapping of the file for read-only connections; sqlite may lower it
+// to its compile-time maximum
+#define AUDACITY_PROJECT_MMAP_SIZE 0x7fff0000
+
 #define xstr(a) str(a)
 #define str(a) #a
 
@@ -48,6 +52,13 @@ static const char *FastConfig =
    "PRAGMA <schema>.synchronous = OFF;"
    "PRAGMA <schema>.journal_mode = OFF;";
 
+// Configuration of read-only connections, which read sample blobs directly
+// from the operating system's page cache
+static const char *ReadOnlyConfig =
+   "PRAGMA <schema>.busy_timeout = 5000;"
+   "PRAGMA <schema>.query_only = ON;"
+   "PRAGMA <schema>.mmap_size = " xstr(AUDACITY_PROJECT_MMAP_SIZE) ";";
+
 DBConnection::DBConnection(
    const std::weak_ptr<AudacityProject> &pProject,
    const std::shared_ptr<DBConnectionErrors> &pErrors,
@@ -81,6 +92,117 @@ bool DBConnection::ShouldBypass()
    return mBypass;
 }
 
+bool DBConnection::IsReadOnly() const
+{
+   return mReadOnly;
+}
+
+std::unique_lock<std::recursive_mutex> DBConnection::LockWrites()
+{
+   return std::unique_lock<std::recursive_mutex>{ mWriteMutex };
+}
+
+void DBConnection::BeginDeferredWrite()
+{
+   std::lock_guard<std::mutex> lock{ mDeferredMutex };
+   ++mDeferredWrites;
+}
+
+void DBConnection::DeferWrite(DeferredWrite write)
+{
+   {
+      std::lock_guard<std::mutex> lock{ mDeferredMutex };
+      mDeferredQueue.push_back(std::move(write));
+   }
+   mDeferredCondition.notify_all();
+}
+
+void DBConnection::EndDeferredWrite()
+{
+   std::lock_guard<std::mutex> lock{ mDeferredMutex };
+   wxASSERT(mDeferredWrites > 0);
+   if (--mDeferredWrites == 0)
+      mDeferredCondition.notify_all();
+}
+
+void DBConnection::WaitForDeferredWrites()
+{
+   while (true) {
+      // Don't wait for the writer thread, which needs the write lock that
+      // this thread may hold
+      FlushDeferredWrites();
+
+      std::unique_lock<std::mutex> lock{ mDeferredMutex };
+      mDeferredCondition.wait(lock, [this]{
+         return mDeferredWrites == 0 || !mDeferredQueue.empty(); });
+      if (mDeferredWrites == 0)
+         return;
+   }
+}
+
+void DBConnection::DeferredWriteThread()
+{
+   while (true)
+   {
+      {
+         std::unique_lock<std::mutex> lock{ mDeferredMutex };
+         mDeferredCondition.wait(lock, [this]{
+            return mDeferredStop || !mDeferredQueue.empty(); });
+
+         // Close() stops this thread only after all writes are done
+         if (mDeferredStop)
+            break;
+      }
+      FlushDeferredWrites();
+   }
+}
+
+void DBConnection::FlushDeferredWrites()
+{
+   // Take the lock first, so no other thread writes into the transaction
+   auto writeLock = LockWrites();
+
+   std::vector<DeferredWrite> writes;
+   {
+      std::lock_guard<std::mutex> lock{ mDeferredMutex };
+      writes.swap(mDeferredQueue);
+   }
+   if (writes.empty())
+      return;
+
+   const bool inTransaction = sqlite3_exec(mDB,
+      "SAVEPOINT DeferredWrites;", nullptr, nullptr, nullptr) == SQLITE_OK;
+
+   // Continue after a failure, but show only the first one to the user
+   bool failed = false;
+   for (auto &write : writes)
+      failed = !GuardedCall<bool>(
+         [&]{ write(); return true; },
+         MakeSimpleGuard(false),
+         [failed](AudacityException *pException){
+            if (!failed)
+               DefaultDelayedHandlerAction(pException);
+         }
+      ) || failed;
+
+   if (inTransaction &&
+       sqlite3_exec(mDB,
+         "RELEASE DeferredWrites;", nullptr, nullptr, nullptr) != SQLITE_OK)
+   {
+      wxLogMessage("Failed to release savepoint of deferred writes on %s\n"
+                   "\tError: %s\n",
+                   sqlite3_db_filename(mDB, nullptr),
+                   sqlite3_errmsg(mDB));
+      if (!failed)
+         GuardedCall( [this]{ ThrowException( true ); } );
+   }
+
+   std::lock_guard<std::mutex> lock{ mDeferredMutex };
+   wxASSERT(mDeferredWrites >= writes.size());
+   mDeferredWrites -= writes.size();
+   mDeferredCondition.notify_all();
+}
+
 void DBConnection::SetError(
    const TranslatableString &msg, const TranslatableString &libraryError, int errorCode)
 {
@@ -139,7 +261,7 @@ void DBConnection::SetDBError(
    }
 }
 
-int DBConnection::Open(const FilePath fileName)
+int DBConnection::Open(const FilePath fileName, bool readOnly)
 {
    wxASSERT(mDB == nullptr);
    int rc;
@@ -148,7 +270,9 @@ int DBConnection::Open(const FilePath fileName)
    mCheckpointStop = false;
    mCheckpointPending = false;
    mCheckpointActive = false;
-   rc = OpenStepByStep( fileName );
+   mDeferredStop = false;
+   mReadOnly = readOnly;
+   rc = readOnly ? OpenReadOnly( fileName ) : OpenStepByStep( fileName );
    if ( rc != SQLITE_OK)
    {
       if (mCheckpointDB)
@@ -225,11 +349,99 @@ int DBConnection::OpenStepByStep(const FilePath fileName)
    mCheckpointThread = std::thread(
       [this, db, fileName]{ CheckpointThread(db, fileName); });
 
+   mDeferredThread = std::thread([this]{ DeferredWriteThread(); });
+
    // Install our checkpoint hook
    sqlite3_wal_hook(mDB, CheckpointHook, this);
    return rc;
 }
 
+namespace {
+//! URI naming a file that sqlite may treat as unchanging, so that it needs
+//! no -shm or -wal file beside it
+wxString ImmutableURI(const FilePath &fileName)
+{
+   wxString path = fileName;
+   // Escape the characters that have meaning in URIs, '%' first
+   path.Replace("%", "%25");
+   path.Replace("?", "%3f");
+   path.Replace("#", "%23");
+   path.Replace("\\", "/");
+   // As for a Windows path beginning with a drive letter
+   if (!path.StartsWith("/"))
+      path.Prepend("/");
+   return "file:" + path + "?immutable=1";
+}
+}
+
+int DBConnection::OpenReadOnly(const FilePath fileName)
+{
+   // A project file in WAL mode needs its -shm file even to be read, and
+   // sqlite can't make one in a folder that isn't writable.  Then open the
+   // file as immutable instead, which skips the -shm and -wal files.
+   bool immutable = !wxFileName::IsDirWritable(wxPathOnly(fileName));
+
+   int rc;
+   while (true)
+   {
+      const auto walName = fileName + "-wal";
+      if (immutable && wxFileExists(walName) &&
+          wxFileName::GetSize(walName).GetValue() > 0)
+      {
+         // The file alone may not have the last changes saved
+         SetError(
+            XO("The project file %s can't be opened, because changes to it are "
+               "still in the file %s-wal, and the folder isn't writable.\n\n"
+               "Copy both files to a folder that is writable, and open the "
+               "project there.").Format(fileName, fileName),
+            {},
+            SQLITE_CANTOPEN);
+         return SQLITE_CANTOPEN;
+      }
+
+      const wxString name = immutable ? ImmutableURI(fileName) : fileName;
+      const int flags =
+         SQLITE_OPEN_READONLY | (immutable ? SQLITE_OPEN_URI : 0);
+      rc = sqlite3_open_v2(name.ToUTF8(), &mDB, flags, nullptr);
+      if (rc == SQLITE_OK)
+         // Opening doesn't read the file yet; make sure it can be read
+         rc = sqlite3_exec(mDB,
+            "SELECT count(*) FROM sqlite_master;", nullptr, nullptr, nullptr);
+
+      if (rc == SQLITE_OK || immutable ||
+          (rc != SQLITE_CANTOPEN && rc != SQLITE_READONLY))
+         break;
+
+      // The -shm file may exist but not be writable; try again without it
+      sqlite3_close(mDB);
+      mDB = nullptr;
+      immutable = true;
+   }
+
+   if (rc != SQLITE_OK)
+   {
+      ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
+      ADD_EXCEPTION_CONTEXT("sqlite3.context", "DBConnection::OpenReadOnly::open");
+
+      wxLogMessage("Failed to open read-only connection to %s: %d, %s\n",
+         fileName,
+         rc,
+         sqlite3_errstr(rc));
+      return rc;
+   }
+
+   rc = ModeConfig(mDB, "main", ReadOnlyConfig);
+   if (rc != SQLITE_OK)
+   {
+      SetDBError(XO("Failed to set read-only mode on connection to %s").Format(fileName));
+      return rc;
+   }
+
+   // Nothing is written, so there are no checkpoints, and no second
+   // connection and thread for them
+   return rc;
+}
+
 bool DBConnection::Close()
 {
    wxASSERT(mDB != nullptr);
@@ -241,6 +453,20 @@ bool DBConnection::Close()
       return true;
    }
 
+   // Let worker threads finish with the database first
+   WaitForDeferredWrites();
+
+   // Then stop the writer thread
+   {
+      std::lock_guard<std::mutex> guard(mDeferredMutex);
+      mDeferredStop = true;
+   }
+   mDeferredCondition.notify_all();
+   if (mDeferredThread.joinable())
+   {
+      mDeferredThread.join();
+   }
+
    // Uninstall our checkpoint hook so that no additional checkpoints
    // are sent our way.  (Though this shouldn't really happen.)
    sqlite3_wal_hook(mDB, nullptr, nullptr);
@@ -307,8 +533,8 @@ bool DBConnection::Close()
 
    // Not much we can do if the closes fail, so just report the error
 
-   // Close the checkpoint connection
-   rc = sqlite3_close(mCheckpointDB);
+   // Close the checkpoint connection, which read-only connections lack
+   rc = mCheckpointDB ? sqlite3_close(mCheckpointDB) : SQLITE_OK;
    if (rc != SQLITE_OK)
    {
       ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
@@ -599,6 +825,8 @@ struct DBConnectionTransactionScopeImpl final : TransactionScopeImpl {
    bool TransactionRollback(const wxString &name) override;
 
    DBConnection &mConnection;
+   //! Held while the savepoint is open, so that other threads wait to write
+   std::unique_lock<std::recursive_mutex> mWriteLock;
 };
 
 static TransactionScope::Factory::Scope scope {
@@ -617,6 +845,8 @@ bool DBConnectionTransactionScopeImpl::TransactionStart(const wxString &name)
 {
    char *errmsg = nullptr;
 
+   mWriteLock = mConnection.LockWrites();
+
    int rc = sqlite3_exec(mConnection.DB(),
                          wxT("SAVEPOINT ") + name + wxT(";"),
                          nullptr,
@@ -634,6 +864,9 @@ bool DBConnectionTransactionScopeImpl::TransactionStart(const wxString &name)
       sqlite3_free(errmsg);
    }
 
+   if (rc != SQLITE_OK)
+      mWriteLock = {};
+
    return rc == SQLITE_OK;
 }
 
@@ -658,6 +891,10 @@ bool DBConnectionTransactionScopeImpl::TransactionCommit(const wxString &name)
       sqlite3_free(errmsg);
    }
 
+   if (rc == SQLITE_OK)
+      // The savepoint is gone; let other threads write
+      mWriteLock = {};
+
    return rc == SQLITE_OK;
 }
 
@@ -19,6 +19,7 @@ Paul Licameli -- split from ProjectFileIO.h
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "ClientData.h"
 #include "Identifier.h"
@@ -49,9 +50,14 @@ public:
       CheckpointFailureCallback callback);
    ~DBConnection();
 
-   int Open(const FilePath fileName);
+   //! @param readOnly if true, the file is never written, and it is read
+   //! through memory mapping, without a checkpoint thread
+   int Open(const FilePath fileName, bool readOnly = false);
    bool Close();
 
+   //! Whether the connection was opened read-only
+   bool IsReadOnly() const;
+
    //! throw and show appropriate message box
    [[noreturn]] void ThrowException(
       bool write //!< If true, a database update failed; if false, only a SELECT failed
@@ -76,6 +82,7 @@ public:
       GetSummary64k,
       LoadSampleBlock,
       InsertSampleBlock,
+      UpdateSampleBlockSummary,
       DeleteSampleBlock,
       GetSampleBlockSize,
       GetAllSampleBlocksSize
@@ -85,6 +92,31 @@ public:
    void SetBypass( bool bypass );
    bool ShouldBypass();
 
+   //! Any thread must hold this lock while it writes to the database, and
+   //! from the start to the end of a savepoint, so that no thread's writes
+   //! join another thread's transaction
+   /*! The lock is recursive, so that transactions may nest */
+   std::unique_lock<std::recursive_mutex> LockWrites();
+
+   //! Type of a write to be done later, with the write lock held
+   /*! It may throw, and then the failure is shown to the user later in the
+    main thread */
+   using DeferredWrite = std::function<void()>;
+
+   //! Note that a worker thread will later write to the database
+   void BeginDeferredWrite();
+   //! Queue the write promised by BeginDeferredWrite()
+   /*! The writer thread of the connection does queued writes together in one
+    transaction of its own */
+   void DeferWrite(DeferredWrite write);
+   //! Note that a worker thread will not write after BeginDeferredWrite()
+   void EndDeferredWrite();
+   //! Block until all deferred writes are complete, doing queued writes in
+   //! the calling thread
+   /*! Close() calls this; so must any code that copies the database or
+    redirects the project to another connection */
+   void WaitForDeferredWrites();
+
    //! Just set stored errors
    void SetError(
       const TranslatableString &msg,
@@ -99,9 +131,13 @@ public:
 
 private:
    int OpenStepByStep(const FilePath fileName);
+   int OpenReadOnly(const FilePath fileName);
    int ModeConfig(sqlite3 *db, const char *schema, const char *config);
 
    void CheckpointThread(sqlite3 *db, const FilePath &fileName);
+   void DeferredWriteThread();
+   //! Do all queued deferred writes in one transaction
+   void FlushDeferredWrites();
    static int CheckpointHook(void *data, sqlite3 *db, const char *schema, int pages);
 
 private:
@@ -120,11 +156,23 @@ private:
    using StatementIndex = std::pair<enum StatementID, std::thread::id>;
    std::map<StatementIndex, sqlite3_stmt *> mStatements;
 
+   std::recursive_mutex mWriteMutex;
+
+   std::thread mDeferredThread;
+   std::mutex mDeferredMutex;
+   std::condition_variable mDeferredCondition;
+   //! Count of writes begun and not yet done
+   size_t mDeferredWrites{ 0 };
+   std::vector<DeferredWrite> mDeferredQueue;
+   bool mDeferredStop{ false };
+
    std::shared_ptr<DBConnectionErrors> mpErrors;
    CheckpointFailureCallback mCallback;
 
    // Bypass transactions if database will be deleted after close
    bool mBypass;
+
+   bool mReadOnly{ false };
 };
 
 using Connection = std::unique_ptr<DBConnection>;
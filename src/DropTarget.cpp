@@ -167,6 +167,9 @@ public:
             ProjectWindow::Get( *mProject ).HandleResize(); // Adjust scrollers for NEW track sizes.
          } );
 
+         // Let importers decode the next files while earlier ones are imported
+         Importer::Batch batch{ sortednames };
+
          for (const auto &name : sortednames) {
 #ifdef USE_MIDI
             if (FileNames::IsMidi(name))
@@ -69,6 +69,9 @@ struct SpaceUsageCalculator {
    }
 
    SpaceArray space;
+   //! Memory of the copied block arrays first used in each state, oldest
+   //! first
+   SpaceArray memory;
    Type clipboardSpaceUsage;
 
    void Calculate( UndoManager &manager )
@@ -99,6 +102,17 @@ struct SpaceUsageCalculator {
          true // newest state first
       );
 
+      // Memory for copies of tracks is shared among states, as for block
+      // files, but count it in the first state that uses it, because that
+      // is the cost of pushing the state
+      BlockArrayNodeSet nodes;
+      manager.VisitStates(
+         [this, &nodes]( const UndoStackElem &elem ){
+            memory.push_back(BlockArrayMemoryUsage(*elem.state.tracks, nodes));
+         },
+         false // oldest state first
+      );
+
       // Count the usage of the clipboard separately, using another set.  Do not
       // multiple-count any block occurring multiple times within the clipboard.
       seen.clear();
@@ -108,6 +122,15 @@ struct SpaceUsageCalculator {
       //TIMER_STOP( space_calc );
    }
 };
+
+//! Give the first column the width not used by the others
+void FitFirstColumn(wxListCtrl &list)
+{
+   auto width = list.GetClientSize().x;
+   for (int ii = 1, nn = list.GetColumnCount(); ii < nn; ++ii)
+      width -= list.GetColumnWidth(ii);
+   list.SetColumnWidth(0, width);
+}
 }
 
 enum {
@@ -176,7 +199,9 @@ void HistoryDialog::Populate(ShuttleGui & S)
             .ConnectRoot(wxEVT_KEY_DOWN, &HistoryDialog::OnListKeyDown)
             .AddListControlReportMode(
                { { XO("Action"), wxLIST_FORMAT_LEFT, 260 },
-                 { XO("Used Space"), wxLIST_FORMAT_LEFT, 125 } },
+                 { XO("Used Space"), wxLIST_FORMAT_LEFT, 125 },
+                 { XO("Copy Time"), wxLIST_FORMAT_LEFT, 90 },
+                 { XO("Copy Memory"), wxLIST_FORMAT_LEFT, 110 } },
                wxLC_SINGLE_SEL
             );
 
@@ -232,7 +257,7 @@ void HistoryDialog::Populate(ShuttleGui & S)
    Layout();
    Fit();
    SetMinSize(GetSize());
-   mList->SetColumnWidth(0, mList->GetClientSize().x - mList->GetColumnWidth(1));
+   FitFirstColumn(*mList);
    mList->SetTextColour(wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOWTEXT));
 }
 
@@ -291,6 +316,7 @@ void HistoryDialog::DoUpdate()
 
    // point to size for oldest state
    auto iter = calculator.space.rbegin();
+   auto iterMemory = calculator.memory.begin();
 
    mList->DeleteAllItems();
 
@@ -304,6 +330,12 @@ void HistoryDialog::DoUpdate()
          const auto &desc = elem.description;
          mList->InsertItem(i, desc.Translation(), i == mSelected ? 1 : 0);
          mList->SetItem(i, 1, size.Translation());
+         mList->SetItem(i, 2,
+            /* i18n-hint: milliseconds */
+            XO("%.1f ms").Format(elem.copyTime.count() / 1000.0)
+               .Translation());
+         mList->SetItem(i, 3,
+            Internat::FormatSize(*iterMemory++).Translation());
          ++i;
       },
       false // oldest state first
@@ -463,7 +495,7 @@ void HistoryDialog::OnShow(wxShowEvent & event)
 void HistoryDialog::OnSize(wxSizeEvent & WXUNUSED(event))
 {
    Layout();
-   mList->SetColumnWidth(0, mList->GetClientSize().x - mList->GetColumnWidth(1));
+   FitFirstColumn(*mList);
    if (mList->GetItemCount() > 0)
       mList->EnsureVisible(mSelected);
 }
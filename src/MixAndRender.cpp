@@ -12,6 +12,7 @@ Paul Licameli split from Mix.cpp
 
 #include "BasicUI.h"
 #include "Mix.h"
+#include "ThreadPool.h"
 #include "effects/RealtimeEffectList.h"
 #include "WaveTrack.h"
 
@@ -139,6 +140,7 @@ void MixAndRender(const TrackIterRange<const WaveTrack> &trackRange,
       true, warpOptions,
       startTime, endTime, mono ? 1 : 2, maxBlockLen, false,
       rate, format);
+   mixer.SetThreadPool(&ThreadPool::Get());
 
    using namespace BasicUI;
    auto updateResult = ProgressResult::Success;
@@ -778,6 +778,17 @@ bool ProjectAudioManager::DoRecord(AudacityProject &project,
       return false;
    // ...end of code from CommandHandler.
 
+   // Recorded samples would have nowhere to go
+   if (ProjectFileIO::Get(project).IsReadOnly()) {
+      AudacityMessageBox(
+         XO("This project was opened from a read-only file, so you can't "
+            "record into it.\nUse Save Project As to make a copy that can "
+            "be changed."),
+         XO("Read-only Project"),
+         wxOK | wxICON_WARNING);
+      return false;
+   }
+
    auto gAudioIO = AudioIO::Get();
    if (gAudioIO->IsBusy())
       return false;
@@ -11,6 +11,7 @@ Paul Licameli split from AudacityProject.cpp
 #include "ProjectFileIO.h"
 
 #include <atomic>
+#include <map>
 #include <sqlite3.h>
 #include <optional>
 #include <cstring>
@@ -167,6 +168,85 @@ static const char *ProjectFileSchema =
    "  samples              BLOB"
    ");";
 
+// CREATE SQL autosavefragments
+// The autosave document in pieces, so that each autosave rewrites only the
+// pieces that changed.  Concatenated in order of position, they make the
+// same stream as the dict and doc of autosave: first the dictionary of
+// names, then the document before the tracks, then one piece for each track,
+// then the rest of the document.
+// The table is made on demand, not with the rest of the project schema, so
+// that project files made before it existed can still be autosaved.  Older
+// versions of Audacity don't find the pieces, and open the last saved
+// project instead; they may also save the project, or autosave it whole,
+// without removing the pieces.  So the dictionary piece keeps a hash of the
+// saved project document that the pieces follow, and the pieces are not
+// restored if the saved document differs, or if there is a whole autosave.
+static const char *AutoSaveFragmentsSchema =
+   "CREATE TABLE IF NOT EXISTS main.autosavefragments"
+   "("
+   "  id                   INTEGER PRIMARY KEY,"
+   "  position             INTEGER,"
+   "  doc                  BLOB,"
+   "  projecthash          INTEGER"
+   ");";
+
+struct ProjectFileIO::AutoSaveFragments
+{
+   // Fixed row ids; tracks have the others
+   enum : int64_t { DictRow = 1, HeadRow, TailRow, FirstTrackRow };
+
+   struct Fragment
+   {
+      int64_t position;
+      std::vector<char> bytes;
+   };
+
+   void clear()
+   {
+      fragments.clear();
+      trackRows.clear();
+      nextRow = FirstTrackRow;
+   }
+
+   // Compute a 64 bit FNV-1a hash of the dict and doc of the saved project,
+   // or of nothing if it was never saved
+   static bool HashProject(sqlite3 *db, int64_t &hash)
+   {
+      sqlite3_stmt *stmt = nullptr;
+      if (sqlite3_prepare_v2(db,
+             "SELECT dict, doc FROM main.project WHERE id = 1;",
+             -1, &stmt, nullptr) != SQLITE_OK)
+         return false;
+      auto finalize = finally([stmt]{ sqlite3_finalize(stmt); });
+
+      uint64_t result = 14695981039346656037ull;
+      const auto rc = sqlite3_step(stmt);
+      if (rc == SQLITE_ROW)
+      {
+         for (int column : { 0, 1 })
+         {
+            const auto bytes = static_cast<const unsigned char *>(
+               sqlite3_column_blob(stmt, column));
+            const auto size = sqlite3_column_bytes(stmt, column);
+            for (int ii = 0; ii < size; ++ii)
+               result = (result ^ bytes[ii]) * 1099511628211ull;
+         }
+      }
+      else if (rc != SQLITE_DONE)
+         return false;
+
+      hash = static_cast<int64_t>(result);
+      return true;
+   }
+
+   // What was last written, by row id
+   std::map<int64_t, Fragment> fragments;
+   std::map<TrackId, int64_t> trackRows;
+   int64_t nextRow{ FirstTrackRow };
+   // Hash of the saved project when everything was last written
+   int64_t projectHash{ 0 };
+};
+
 // This singleton handles initialization/shutdown of the SQLite library.
 // It is needed because our local SQLite is built with SQLITE_OMIT_AUTOINIT
 // defined.
@@ -344,11 +424,17 @@ private:
 class BufferedProjectBlobStream : public BufferedStreamReader
 {
 public:
-   static constexpr std::array<const char*, 2> Columns = { "dict", "doc" };
+   //! Row and column of one of the blobs read in sequence
+   struct Blob
+   {
+      int64_t rowID;
+      const char* column;
+   };
 
+   //! Read the blobs in sequence, as one stream
    BufferedProjectBlobStream(
       sqlite3* db, const char* schema, const char* table,
-      int64_t rowID)
+      std::vector<Blob> blobs)
        // Despite we use 64k pages in SQLite - it is impossible to guarantee
        // that read is satisfied from a single page.
        // Reading 64k proved to be slower, (64k - 8) gives no measurable difference
@@ -358,21 +444,22 @@ public:
        , mDB(db)
        , mSchema(schema)
        , mTable(table)
-       , mRowID(rowID)
+       , mBlobs(std::move(blobs))
    {
    }
 
 private:
    bool OpenBlob(size_t index)
    {
-      if (index >= Columns.size())
+      if (index >= mBlobs.size())
       {
          mBlobStream.reset();
          return false;
       }
 
       mBlobStream = SQLiteBlobStream::Open(
-         mDB, mSchema, mTable, Columns[index], mRowID, true);
+         mDB, mSchema, mTable, mBlobs[index].column, mBlobs[index].rowID,
+         true);
 
       return mBlobStream.has_value();
    }
@@ -383,12 +470,12 @@ private:
    sqlite3* mDB;
    const char* mSchema;
    const char* mTable;
-   const int64_t mRowID;
+   const std::vector<Blob> mBlobs;
 
 protected:
    bool HasMoreData() const override
    {
-      return mBlobStream.has_value() || mNextBlobIndex < Columns.size();
+      return mBlobStream.has_value() || mNextBlobIndex < mBlobs.size();
    }
 
    size_t ReadData(void* buffer, size_t maxBytes) override
@@ -408,7 +495,7 @@ protected:
          // Reading has failed, close the stream and do not allow opening
          // the next one
          mBlobStream = {};
-         mNextBlobIndex = Columns.size();
+         mNextBlobIndex = mBlobs.size();
 
          return 0;
       }
@@ -421,8 +508,6 @@ protected:
    }
 };
 
-constexpr std::array<const char*, 2> BufferedProjectBlobStream::Columns;
-
 bool ProjectFileIO::InitializeSQL()
 {
    static SQLiteIniter sqliteIniter;
@@ -492,6 +577,7 @@ const ProjectFileIO &ProjectFileIO::Get( const AudacityProject &project )
 ProjectFileIO::ProjectFileIO(AudacityProject &project)
    : mProject{ project }
    , mpErrors{ std::make_shared<DBConnectionErrors>() }
+   , mpAutoSaveFragments{ std::make_unique<AutoSaveFragments>() }
 {
    mPrevConn = nullptr;
 
@@ -569,7 +655,8 @@ sqlite3 *ProjectFileIO::DB()
  @pre *CurConn() does not exist
  @post *CurConn() exists or return value is false
  */
-bool ProjectFileIO::OpenConnection(FilePath fileName /* = {}  */)
+bool ProjectFileIO::OpenConnection(
+   FilePath fileName /* = {}  */, bool readOnly /* = false */)
 {
    auto &curConn = CurrConn();
    wxASSERT(!curConn);
@@ -597,18 +684,24 @@ bool ProjectFileIO::OpenConnection(FilePath fileName /* = {}  */)
       }
    }
 
+   // A different database may hold different autosave fragments
+   mpAutoSaveFragments->clear();
+
    // Pass weak_ptr to project into DBConnection constructor
    curConn = std::make_unique<DBConnection>(
       mProject.shared_from_this(), mpErrors, [this]{ OnCheckpointFailure(); } );
-   auto rc = curConn->Open(fileName);
+   // A read-only open may explain its own failure
+   SetError({});
+   auto rc = curConn->Open(fileName, readOnly);
    if (rc != SQLITE_OK)
    {
       // Must use SetError() here since we do not have an active DB
-      SetError(
-         XO("Failed to open database file:\n\n%s").Format(fileName),
-         {},
-         rc
-      );
+      if (!readOnly || GetLastError().empty())
+         SetError(
+            XO("Failed to open database file:\n\n%s").Format(fileName),
+            {},
+            rc
+         );
       curConn.reset();
       return false;
    }
@@ -638,6 +731,7 @@ bool ProjectFileIO::CloseConnection()
       return false;
    }
    curConn.reset();
+   mpAutoSaveFragments->clear();
 
    SetFileName({});
 
@@ -651,9 +745,14 @@ void ProjectFileIO::SaveConnection()
    // Should do nothing in proper usage, but be sure not to leak a connection:
    DiscardConnection();
 
+   // Deferred writes must go to the connection where they were scheduled
+   if (auto &curConn = CurrConn())
+      curConn->WaitForDeferredWrites();
+
    mPrevConn = std::move(CurrConn());
    mPrevFileName = mFileName;
    mPrevTemporary = mTemporary;
+   mpAutoSaveFragments->clear();
 
    SetFileName({});
 }
@@ -710,6 +809,7 @@ void ProjectFileIO::RestoreConnection()
    curConn = std::move(mPrevConn);
    SetFileName(mPrevFileName);
    mTemporary = mPrevTemporary;
+   mpAutoSaveFragments->clear();
 
    mPrevFileName.clear();
 }
@@ -721,6 +821,7 @@ void ProjectFileIO::UseConnection(Connection &&conn, const FilePath &filePath)
 
    curConn = std::move(conn);
    SetFileName(filePath);
+   mpAutoSaveFragments->clear();
 }
 
 static int ExecCallback(void *data, int cols, char **vals, char **names)
@@ -994,6 +1095,12 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
    if (!pConn)
       return false;
 
+   // Copy only complete rows
+   pConn->WaitForDeferredWrites();
+
+   // No other thread may write while the copy is attached and in progress
+   auto writeLock = pConn->LockWrites();
+
    // Get access to the active tracklist
    auto pProject = &mProject;
 
@@ -1243,6 +1350,91 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
    return true;
 }
 
+bool ProjectFileIO::CopyReadOnlyTo(
+   const FilePath &destpath, const TranslatableString &msg)
+{
+   auto db = DB();
+   sqlite3 *destDB = nullptr;
+   sqlite3_backup *backup = nullptr;
+   bool success = false;
+
+   // Cleanup in case things go awry
+   auto cleanup = finally([&]
+   {
+      if (backup)
+         sqlite3_backup_finish(backup);
+      if (destDB)
+         sqlite3_close(destDB);
+      if (!success)
+         wxRemoveFile(destpath);
+   });
+
+   int rc = sqlite3_open(destpath.ToUTF8(), &destDB);
+   if (rc != SQLITE_OK)
+   {
+      ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.context", "ProjectGileIO::CopyReadOnlyTo.open");
+
+      SetDBError(
+         XO("Unable to open the destination project file"),
+         Verbatim(sqlite3_errstr(rc)), rc
+      );
+      return false;
+   }
+
+   backup = sqlite3_backup_init(destDB, "main", db, "main");
+   if (!backup)
+   {
+      rc = sqlite3_errcode(destDB);
+      ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.context", "ProjectGileIO::CopyReadOnlyTo.init");
+
+      SetDBError(
+         XO("Unable to copy the project file"),
+         Verbatim(sqlite3_errmsg(destDB)), rc
+      );
+      return false;
+   }
+
+   {
+      /* i18n-hint: This title appears on a dialog that indicates the progress
+         in doing something.*/
+      ProgressDialog progress(XO("Progress"), msg, pdlgHideStopButton);
+
+      // Copy a few megabytes of pages at a time
+      do
+      {
+         rc = sqlite3_backup_step(backup, 256);
+         const auto total = sqlite3_backup_pagecount(backup);
+         progress.Update(total - sqlite3_backup_remaining(backup), total);
+      } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+   }
+
+   const auto finished = sqlite3_backup_finish(backup);
+   backup = nullptr;
+   if (rc != SQLITE_DONE || finished != SQLITE_OK)
+   {
+      if (rc == SQLITE_DONE)
+         rc = finished;
+      ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.context", "ProjectGileIO::CopyReadOnlyTo.step");
+
+      SetDBError(
+         XO("Unable to copy the project file"),
+         Verbatim(sqlite3_errstr(rc)), rc
+      );
+      return false;
+   }
+
+   // Tell cleanup everything is good to go
+   success = true;
+
+   return true;
+}
+
 bool ProjectFileIO::ShouldCompact(const std::vector<const TrackList *> &tracks)
 {
    SampleBlockIDSet active;
@@ -1479,6 +1671,13 @@ void ProjectFileIO::Compact(
    // Haven't compacted yet
    mWasCompacted = false;
 
+   // Nothing was written, and nothing can be
+   if (IsReadOnly())
+   {
+      mHadUnused = false;
+      return;
+   }
+
    // Assume we have unused blocks until we find out otherwise. That way cleanup
    // at project close time will still occur.
    mHadUnused = true;
@@ -1657,6 +1856,14 @@ void ProjectFileIO::SetProjectTitle(int number)
       name += _("(Recovered)");
    }
 
+   if (IsReadOnly())
+   {
+      name += wxT(" ");
+      /* i18n-hint: The project file can be played and exported, but changes
+         can't be saved in it */
+      name += _("(Read-only)");
+   }
+
    if (name != window.GetTitle())
    {
       window.SetTitle( name );
@@ -1808,7 +2015,8 @@ void ProjectFileIO::WriteXMLHeader(XMLWriter &xmlFile) const
 
 void ProjectFileIO::WriteXML(XMLWriter &xmlFile,
                              bool recording /* = false */,
-                             const TrackList *tracks /* = nullptr */)
+                             const TrackList *tracks /* = nullptr */,
+                             const TrackWriteVisitor &visitor /* = {} */)
 // may throw
 {
    auto &proj = mProject;
@@ -1841,9 +2049,13 @@ void ProjectFileIO::WriteXML(XMLWriter &xmlFile,
          // when pushing.  Don't auto-save it.
          return;
       }
+      if (visitor)
+         visitor(useTrack);
       useTrack->WriteXML(xmlFile);
    });
 
+   if (visitor)
+      visitor(nullptr);
    xmlFile.EndTag(wxT("project"));
 
    //TIMER_STOP( xml_writer_timer );
@@ -1851,17 +2063,245 @@ void ProjectFileIO::WriteXML(XMLWriter &xmlFile,
 
 bool ProjectFileIO::AutoSave(bool recording)
 {
+   // There is nowhere to keep the backup
+   if (IsReadOnly())
+      return true;
+
+   auto now = std::chrono::high_resolution_clock::now();
+
+   // Serialize all, but remember where each track begins, to find the
+   // fragments that changed since the last autosave
    ProjectSerializer autosave;
+   std::vector<std::pair<const Track *, size_t>> trackStarts;
    WriteXMLHeader(autosave);
-   WriteXML(autosave, recording);
+   WriteXML(autosave, recording, nullptr, [&](const Track *pTrack){
+      trackStarts.emplace_back(pTrack, autosave.GetData().GetSize());
+   });
+
+   // With no fragments from an earlier autosave, all are written
+   const bool rewrite = mpAutoSaveFragments->fragments.empty();
+   size_t bytesWritten = 0;
+   if (!WriteAutoSaveFragments(autosave, trackStarts, bytesWritten))
+      return false;
+
+   mModified = true;
+
+   auto duration = std::chrono::high_resolution_clock::now() - now;
+
+   wxLogInfo(
+      rewrite
+         ? "Autosaved %llu of %llu bytes in %lld ms, rewriting all"
+         : "Autosaved %llu of %llu bytes in %lld ms",
+      static_cast<unsigned long long>(bytesWritten),
+      static_cast<unsigned long long>(
+         autosave.GetDict().GetSize() + autosave.GetData().GetSize()),
+      std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+
+   return true;
+}
 
-   if (WriteDoc("autosave", autosave))
+bool ProjectFileIO::WriteAutoSaveFragments(const ProjectSerializer &autosave,
+   const std::vector<std::pair<const Track *, size_t>> &trackStarts,
+   size_t &bytesWritten)
+{
+   using Fragments = AutoSaveFragments;
+   auto &previous = *mpAutoSaveFragments;
+   auto db = DB();
+
+   TransactionScope transaction(mProject, "AutoSave");
+
+   // If anything fails, the transaction rolls back, and the next autosave
+   // must write everything again
+   bool success = false;
+   auto cleanup = finally([&]
    {
-      mModified = true;
-      return true;
+      if (!success)
+         previous.clear();
+   });
+
+   Fragments next;
+   next.nextRow = previous.nextRow;
+   next.projectHash = previous.projectHash;
+
+   if (previous.fragments.empty())
+   {
+      // Write everything, replacing fragments from another session, which
+      // may have used another dictionary, and any whole autosave document;
+      // make the table again, in case it lacks a column
+      if (sqlite3_exec(db,
+             "DROP TABLE IF EXISTS main.autosavefragments;",
+             nullptr, nullptr, nullptr) != SQLITE_OK ||
+          sqlite3_exec(db, AutoSaveFragmentsSchema,
+             nullptr, nullptr, nullptr) != SQLITE_OK ||
+          sqlite3_exec(db,
+             "DELETE FROM main.autosave;",
+             nullptr, nullptr, nullptr) != SQLITE_OK ||
+          !Fragments::HashProject(db, next.projectHash))
+      {
+         ADD_EXCEPTION_CONTEXT(
+            "sqlite3.rc", std::to_string(sqlite3_errcode(db)));
+         ADD_EXCEPTION_CONTEXT(
+            "sqlite3.context", "ProjectGileIO::WriteAutoSaveFragments");
+
+         SetDBError(
+            XO("Failed to remove the autosave information from the project file.")
+         );
+         return false;
+      }
    }
 
-   return false;
+   // BIND SQL autosavefragments
+   const char *insertSql =
+      "INSERT OR REPLACE INTO main.autosavefragments"
+      "       (id, position, doc, projecthash)"
+      "       VALUES(?1, ?2, ?3, ?4);";
+   const char *moveSql =
+      "UPDATE main.autosavefragments SET position = ?2 WHERE id = ?1;";
+   const char *deleteSql =
+      "DELETE FROM main.autosavefragments WHERE id = ?1;";
+
+   {
+      sqlite3_stmt *insertStmt = nullptr, *moveStmt = nullptr,
+         *deleteStmt = nullptr;
+      // Finalize the statements before committing the transaction
+      auto finalize = finally([&]
+      {
+         for (auto stmt : { insertStmt, moveStmt, deleteStmt })
+            if (stmt)
+               sqlite3_finalize(stmt);
+      });
+
+      for (auto [sql, pStmt] : {
+         std::pair{ insertSql, &insertStmt },
+         std::pair{ moveSql, &moveStmt },
+         std::pair{ deleteSql, &deleteStmt } })
+      {
+         if (sqlite3_prepare_v2(db, sql, -1, pStmt, nullptr) != SQLITE_OK)
+         {
+            ADD_EXCEPTION_CONTEXT("sqlite3.query", sql);
+            ADD_EXCEPTION_CONTEXT(
+               "sqlite3.rc", std::to_string(sqlite3_errcode(db)));
+            ADD_EXCEPTION_CONTEXT("sqlite3.context",
+               "ProjectGileIO::WriteAutoSaveFragments::prepare");
+
+            SetDBError(
+               XO("Unable to prepare project file command:\n\n%s").Format(sql)
+            );
+            return false;
+         }
+      }
+
+      const auto step = [&](sqlite3_stmt *stmt, const char *sql)
+      {
+         auto reset = finally([stmt]
+         {
+            // Clear statement bindings and rewind statement
+            sqlite3_clear_bindings(stmt);
+            sqlite3_reset(stmt);
+         });
+
+         if (sqlite3_step(stmt) != SQLITE_DONE)
+         {
+            ADD_EXCEPTION_CONTEXT("sqlite3.query", sql);
+            ADD_EXCEPTION_CONTEXT(
+               "sqlite3.rc", std::to_string(sqlite3_errcode(db)));
+            ADD_EXCEPTION_CONTEXT("sqlite3.context",
+               "ProjectGileIO::WriteAutoSaveFragments::step");
+
+            SetDBError(
+               XO("Failed to update the project file.\nThe following command failed:\n\n%s")
+                  .Format(sql));
+            return false;
+         }
+         return true;
+      };
+
+      // Write one fragment, unless it was written before with the same
+      // contents, in which case at most update its position
+      int64_t position = 0;
+      const auto write = [&](int64_t row, const char *bytes, size_t size)
+      {
+         auto &fragment = next.fragments[row];
+         fragment.position = position++;
+
+         const auto iter = previous.fragments.find(row);
+         if (iter != previous.fragments.end() &&
+             std::equal(bytes, bytes + size,
+                iter->second.bytes.begin(), iter->second.bytes.end()))
+         {
+            fragment.bytes = std::move(iter->second.bytes);
+            if (iter->second.position == fragment.position)
+               return true;
+
+            sqlite3_bind_int64(moveStmt, 1, row);
+            sqlite3_bind_int64(moveStmt, 2, fragment.position);
+            return step(moveStmt, moveSql);
+         }
+
+         fragment.bytes.assign(bytes, bytes + size);
+         bytesWritten += size;
+
+         sqlite3_bind_int64(insertStmt, 1, row);
+         sqlite3_bind_int64(insertStmt, 2, fragment.position);
+         sqlite3_bind_blob(insertStmt, 3, bytes, size, SQLITE_STATIC);
+         if (row == Fragments::DictRow)
+            sqlite3_bind_int64(insertStmt, 4, next.projectHash);
+         return step(insertStmt, insertSql);
+      };
+
+      const auto &dict = autosave.GetDict();
+      if (!write(Fragments::DictRow,
+             static_cast<const char *>(dict.GetData()), dict.GetSize()))
+         return false;
+
+      // The data before the first track, then each track, then the rest
+      const auto &data = autosave.GetData();
+      const auto pData = static_cast<const char *>(data.GetData());
+      size_t begin = 0;
+      int64_t row = Fragments::HeadRow;
+      for (const auto &[pTrack, start] : trackStarts)
+      {
+         if (!write(row, pData + begin, start - begin))
+            return false;
+         begin = start;
+
+         if (pTrack)
+         {
+            const auto id = pTrack->GetId();
+            const auto iter = previous.trackRows.find(id);
+            row = (iter != previous.trackRows.end())
+               ? iter->second
+               : next.nextRow++;
+            if (!next.trackRows.emplace(id, row).second)
+               // Not expected, but don't let two tracks overwrite one row
+               row = next.nextRow++;
+         }
+         else
+            row = Fragments::TailRow;
+      }
+      if (!write(row, pData + begin, data.GetSize() - begin))
+         return false;
+
+      // Remove the fragments of tracks that are gone
+      for (const auto &pair : previous.fragments)
+      {
+         const auto oldRow = pair.first;
+         if (next.fragments.count(oldRow))
+            continue;
+
+         sqlite3_bind_int64(deleteStmt, 1, oldRow);
+         if (!step(deleteStmt, deleteSql))
+            return false;
+      }
+   }
+
+   if (!WriteRequiredVersion() || !transaction.Commit())
+      return false;
+
+   previous = std::move(next);
+   success = true;
+
+   return true;
 }
 
 bool ProjectFileIO::AutoSaveDelete(sqlite3 *db /* = nullptr */)
@@ -1873,7 +2313,11 @@ bool ProjectFileIO::AutoSaveDelete(sqlite3 *db /* = nullptr */)
       db = DB();
    }
 
-   rc = sqlite3_exec(db, "DELETE FROM autosave;", nullptr, nullptr, nullptr);
+   // The table of autosave fragments is made again when needed
+   rc = sqlite3_exec(db,
+      "DELETE FROM autosave;"
+      "DROP TABLE IF EXISTS autosavefragments;",
+      nullptr, nullptr, nullptr);
    if (rc != SQLITE_OK)
    {
       ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
@@ -1886,6 +2330,7 @@ bool ProjectFileIO::AutoSaveDelete(sqlite3 *db /* = nullptr */)
    }
 
    mModified = false;
+   mpAutoSaveFragments->clear();
 
    return true;
 }
@@ -2037,6 +2482,14 @@ bool ProjectFileIO::WriteDoc(const char *table,
    if (!writeStream("doc", data))
       return false;
 
+   if (!WriteRequiredVersion())
+      return false;
+
+   return transaction.Commit();
+}
+
+bool ProjectFileIO::WriteRequiredVersion()
+{
    const auto requiredVersion =
       ProjectFormatExtensionsRegistry::Get().GetRequiredVersion(mProject);
 
@@ -2048,14 +2501,17 @@ bool ProjectFileIO::WriteDoc(const char *table,
       // DV: Very unlikely case.
       // Since we need to improve the error messages in the future, let's use
       // the generic message for now, so no new strings are needed
-      reportError(setVersionSql);
+      SetDBError(
+         XO("Failed to update the project file.\nThe following command failed:\n\n%s")
+            .Format(setVersionSql));
       return false;
    }
 
-   return transaction.Commit();
+   return true;
 }
 
-bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
+bool ProjectFileIO::LoadProject(
+   const FilePath &fileName, bool ignoreAutosave, bool readOnly)
 {
    auto now = std::chrono::high_resolution_clock::now();
 
@@ -2072,16 +2528,32 @@ bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
    SaveConnection();
 
    // Open the project file
-   if (!OpenConnection(fileName))
+   if (!OpenConnection(fileName, readOnly))
    {
       return false;
    }
 
    int64_t rowId = -1;
 
-   bool useAutosave =
+   // Prefer the fragments of an incremental autosave, if they follow the
+   // saved project, and no other version autosaved it whole since; the
+   // table might not exist, or might lack the column of the hash
+   int64_t fragmentsCount = 0, projectHash = 0;
+   const bool useFragments =
       !ignoreAutosave &&
-      GetValue("SELECT ROWID FROM main.autosave WHERE id = 1;", rowId, true);
+      !GetValue("SELECT ROWID FROM main.autosave WHERE id = 1;", rowId, true) &&
+      AutoSaveFragments::HashProject(DB(), projectHash) &&
+      GetValue(("SELECT COUNT(1) FROM main.autosavefragments"
+                "   WHERE id = " + std::to_string(AutoSaveFragments::DictRow) +
+                "   AND projecthash = " + std::to_string(projectHash) + ";")
+                  .c_str(),
+         fragmentsCount, true) &&
+      fragmentsCount > 0;
+
+   bool useAutosave =
+      useFragments ||
+      (!ignoreAutosave &&
+       GetValue("SELECT ROWID FROM main.autosave WHERE id = 1;", rowId, true));
 
    int64_t rowsCount = 0;
    // If we didn't have an autosave doc, load the project doc instead
@@ -2104,9 +2576,39 @@ bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
    }
    else
    {
+      // Reassemble the fragments, or read one whole document
+      std::vector<BufferedProjectBlobStream::Blob> blobs;
+      if (useFragments)
+      {
+         bool parsed = true;
+         if (!Query("SELECT id FROM main.autosavefragments ORDER BY position;",
+            [&blobs, &parsed](int cols, char **vals, char **)
+            {
+               int64_t id = 0;
+               const std::string_view idString =
+                  (cols > 0 && vals[0]) ? vals[0] : "";
+               parsed = std::errc() == FromChars(
+                  idString.data(), idString.data() + idString.length(),
+                  id).ec;
+               blobs.push_back({ id, "doc" });
+               // Stop at a bad row
+               return parsed ? 0 : 1;
+            }) || !parsed)
+         {
+            SetError(
+               XO("Unable to parse project information.")
+            );
+            return false;
+         }
+      }
+      else
+         blobs = { { rowId, "dict" }, { rowId, "doc" } };
+
       // Load 'er up
-      BufferedProjectBlobStream stream(
-         DB(), "main", useAutosave ? "autosave" : "project", rowId);
+      BufferedProjectBlobStream stream(DB(), "main",
+         useFragments ? "autosavefragments"
+            : useAutosave ? "autosave" : "project",
+         std::move(blobs));
 
       success = ProjectSerializer::Decode(stream, this);
 
@@ -2120,10 +2622,11 @@ bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
 
       // Check for orphans blocks...sets mRecovered if any were deleted
       
+      // (Orphans in a read-only file remain until it is opened for writing)
       auto blockids = WaveTrackFactory::Get( mProject )
          .GetSampleBlockFactory()
             ->GetActiveBlockIDs();
-      if (blockids.size() > 0)
+      if (blockids.size() > 0 && !readOnly)
       {
          success = DeleteBlocks(blockids, true);
          if (!success)
@@ -2252,9 +2755,16 @@ bool ProjectFileIO::SaveProject(
    // current to the new file and make it the active file.
    if (mFileName != fileName)
    {
+      // A project opened from a read-only file can't be changed in place,
+      // so its old file keeps its autosave and blocks, and the copy gets
+      // the document below
+      const bool fromReadOnly = IsReadOnly();
+
       // Do NOT prune here since we need to retain the Undo history
       // after we switch to the new file.
-      if (!CopyTo(fileName, XO("Saving project"), false))
+      if (!(fromReadOnly
+         ? CopyReadOnlyTo(fileName, XO("Saving project"))
+         : CopyTo(fileName, XO("Saving project"), false)))
       {
          ShowError( {},
             XO("Error Saving Project"),
@@ -2331,7 +2841,7 @@ bool ProjectFileIO::SaveProject(
       }
 
       // Autosave no longer needed in original project file.
-      if (!AutoSaveDelete())
+      if (!fromReadOnly && !AutoSaveDelete())
       {
          // Additional help via a Help button links to the manual.
          ShowError( {},
@@ -2351,7 +2861,7 @@ bool ProjectFileIO::SaveProject(
          return false;
       }
 
-      if (lastSaved) {
+      if (lastSaved && !fromReadOnly) {
          // Bug2605: Be sure not to save orphan blocks
          bool recovered = mRecovered;
          SampleBlockIDSet blockids;
@@ -2373,6 +2883,17 @@ bool ProjectFileIO::SaveProject(
 
       // And make it the active project file 
       UseConnection(std::move(newConn), fileName);
+
+      // The copy has the document as it was opened; write it as it is now
+      if (fromReadOnly && !UpdateSaved(nullptr))
+      {
+         ShowError( {},
+            XO("Error Saving Project"),
+            FileException::WriteFailureMessage(fileName),
+            "Error:_Disk_full_or_not_writable"
+            );
+         return false;
+      }
    }
    else
    {
@@ -2450,12 +2971,13 @@ bool ProjectFileIO::CloseProject()
 bool ProjectFileIO::ReopenProject()
 {
    FilePath fileName = mFileName;
+   const bool readOnly = IsReadOnly();
    if (!CloseConnection())
    {
       return false;
    }
 
-   return OpenConnection(fileName);
+   return OpenConnection(fileName, readOnly);
 }
 
 bool ProjectFileIO::IsModified() const
@@ -2468,6 +2990,13 @@ bool ProjectFileIO::IsTemporary() const
    return mTemporary;
 }
 
+bool ProjectFileIO::IsReadOnly() const
+{
+   auto &connectionPtr = ConnectionPtr::Get( mProject );
+   return connectionPtr.mpConnection != nullptr &&
+      connectionPtr.mpConnection->IsReadOnly();
+}
+
 bool ProjectFileIO::IsRecovered() const
 {
    return mRecovered;
@@ -2563,8 +3092,8 @@ void ProjectFileIO::SetBypass()
 
    currConn->SetBypass( true );
 
-   // Only permanent project files need cleaning at shutdown
-   if (!IsTemporary() && !WasCompacted())
+   // Only permanent, writable project files need cleaning at shutdown
+   if (!IsTemporary() && !WasCompacted() && !currConn->IsReadOnly())
    {
       // If we still have unused blocks, then we must not bypass deletions
       // during shutdown.  Otherwise, we would have orphaned blocks the next time
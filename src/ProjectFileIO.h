@@ -11,6 +11,7 @@ Paul Licameli split from AudacityProject.h
 #ifndef __AUDACITY_PROJECT_FILE_IO__
 #define __AUDACITY_PROJECT_FILE_IO__
 
+#include <functional>
 #include <memory>
 #include <unordered_set>
 
@@ -30,6 +31,7 @@ class DBConnection;
 struct DBConnectionErrors;
 class ProjectSerializer;
 class SqliteSampleBlock;
+class Track;
 class TrackList;
 class WaveTrack;
 
@@ -88,6 +90,9 @@ public:
    bool IsModified() const;
    bool IsTemporary() const;
    bool IsRecovered() const;
+   //! Whether the project file was opened read-only, so that edits can't be
+   //! saved in it
+   bool IsReadOnly() const;
 
    bool AutoSave(bool recording = false);
    bool AutoSaveDelete(sqlite3 *db = nullptr);
@@ -96,7 +101,10 @@ public:
    bool CloseProject();
    bool ReopenProject();
 
-   bool LoadProject(const FilePath &fileName, bool ignoreAutosave);
+   //! @param readOnly if true, open the file without ever writing it, which
+   //! is faster for playing or exporting a large project
+   bool LoadProject(const FilePath &fileName, bool ignoreAutosave,
+      bool readOnly = false);
    bool UpdateSaved(const TrackList *tracks = nullptr);
    bool SaveProject(const FilePath &fileName, const TrackList *lastSaved);
    bool SaveCopy(const FilePath& fileName);
@@ -206,9 +214,13 @@ public:
 private:
    void OnCheckpointFailure();
 
+   //! Called before writing each track, and with null before the end tag
+   using TrackWriteVisitor = std::function<void(const Track *)>;
+
    void WriteXMLHeader(XMLWriter &xmlFile) const;
    void WriteXML(XMLWriter &xmlFile, bool recording = false,
-      const TrackList *tracks = nullptr) /* not override */;
+      const TrackList *tracks = nullptr,
+      const TrackWriteVisitor &visitor = {}) /* not override */;
 
    // XMLTagHandler callback methods
    bool HandleXMLTag(const std::string_view& tag, const AttributesList &attrs) override;
@@ -223,7 +235,7 @@ private:
    // if opening fails.
    sqlite3 *DB();
 
-   bool OpenConnection(FilePath fileName = {});
+   bool OpenConnection(FilePath fileName = {}, bool readOnly = false);
    bool CloseConnection();
 
    // Put the current database connection aside, keeping it open, so that
@@ -250,6 +262,17 @@ private:
    // Write project or autosave XML (binary) documents
    bool WriteDoc(const char *table, const ProjectSerializer &autosave, const char *schema = "main");
 
+   // Write those pieces of the autosave document that changed since the
+   // last autosave; trackStarts are offsets in the data where tracks begin,
+   // and then where the data after the tracks begins; adds to bytesWritten
+   // the sizes of the pieces written
+   bool WriteAutoSaveFragments(const ProjectSerializer &autosave,
+      const std::vector<std::pair<const Track *, size_t>> &trackStarts,
+      size_t &bytesWritten);
+
+   // Set the version of the project file required by features in use
+   bool WriteRequiredVersion();
+
    // Application defined function to verify blockid exists is in set of blockids
    static void InSet(sqlite3_context *context, int argc, sqlite3_value **argv);
 
@@ -264,6 +287,12 @@ private:
       */
    );
 
+   //! Copy all pages of a read-only project file into a new file
+   /*! A read-only connection can't attach another database to write in, as
+    CopyTo does, so this uses the sqlite backup interface instead */
+   bool CopyReadOnlyTo(const FilePath &destpath,
+      const TranslatableString &msg);
+
    //! Just set stored errors
    void SetError(const TranslatableString & msg,
        const TranslatableString& libraryError = {},
@@ -310,6 +339,11 @@ private:
    Connection mPrevConn;
    FilePath mPrevFileName;
    bool mPrevTemporary;
+
+   // What the last incremental autosave wrote to the current connection;
+   // empty if all must be written again
+   struct AutoSaveFragments;
+   std::unique_ptr<AutoSaveFragments> mpAutoSaveFragments;
 };
 
 class wxTopLevelWindow;
@@ -159,19 +159,25 @@ auto ProjectFileManager::ReadProjectFile(
    ///
    /// Parse project file
    ///
-   bool bParseSuccess = projectFileIO.LoadProject(fileName, discardAutosave);
+   // A file that can't be written, such as an archived project, is opened
+   // read-only; it can still be played and exported
+   const bool readOnly = !wxFileName::IsFileWritable(fileName);
+   bool bParseSuccess =
+      projectFileIO.LoadProject(fileName, discardAutosave, readOnly);
    
    bool err = false;
 
    if (bParseSuccess)
    {
-      if (discardAutosave)
+      if (discardAutosave) {
          // REVIEW: Failure OK?
-         projectFileIO.AutoSaveDelete();
+         if (!readOnly)
+            projectFileIO.AutoSaveDelete();
+      }
       else if (projectFileIO.IsRecovered()) {
          bool resaved = false;
 
-         if (!projectFileIO.IsTemporary())
+         if (!projectFileIO.IsTemporary() && !readOnly)
          {
             // Re-save non-temporary project to its own path.  This
             // might fail to update the document blob in the database.
@@ -233,6 +239,12 @@ bool ProjectFileManager::Save()
       return SaveAs(true);
    }
 
+   // A read-only file can only be saved elsewhere
+   if (projectFileIO.IsReadOnly())
+   {
+      return SaveAs();
+   }
+
    return DoSave(projectFileIO.GetFileName(), false);
 }
 
@@ -279,6 +291,19 @@ bool ProjectFileManager::DoSave(const FilePath & fileName, const bool fromSaveAs
 
    // Some confirmation dialogs
    {
+      // Save As copies a read-only project out to the new file, but it
+      // can't be saved in place
+      if (projectFileIO.IsReadOnly() && !fromSaveAs)
+      {
+         AudacityMessageBox(
+            XO("This project was opened from a read-only file.\n"
+               "Changes to it can't be saved there. Save it under another name."),
+            XO("Read-only Project"),
+            wxOK | wxICON_WARNING,
+            &window);
+         return false;
+      }
+
       if (TempDirectory::FATFilesystemDenied(fileName, XO("Projects cannot be saved to FAT drives.")))
       {
          return false;
@@ -561,6 +586,20 @@ bool ProjectFileManager::SaveCopy(const FilePath &fileName /* = wxT("") */)
    auto &projectFileIO = ProjectFileIO::Get(project);
    auto &window = GetProjectFrame(project);
    TitleRestorer Restorer(window, project); // RAII
+
+   // The copy would be made by attaching it to the project's database, which
+   // a read-only connection can't write in
+   if (projectFileIO.IsReadOnly())
+   {
+      AudacityMessageBox(
+         XO("This project was opened from a read-only file.\n"
+            "Use Save Project As to make a copy that can be changed."),
+         XO("Read-only Project"),
+         wxOK | wxICON_WARNING,
+         &window);
+      return false;
+   }
+
    wxFileName filename = fileName;
    FilePath defaultSavePath = FileNames::FindDefaultPath(FileNames::Operation::Save);
 
@@ -22,6 +22,11 @@
   AvailForPut and AvailForGet may underestimate but will never
   overestimate.
 
+  Besides copying with Put and Get, the writer and the reader may work on
+  the buffer memory in place:  each acquires at most two spans (two when the
+  run wraps around the end of the storage), then commits the number of
+  samples written or read.
+
 *//*******************************************************************/
 
 
@@ -72,37 +77,24 @@ size_t RingBuffer::AvailForPut()
 size_t RingBuffer::Put(constSamplePtr buffer, sampleFormat format,
                     size_t samplesToCopy, size_t padding)
 {
-   auto start = mStart.load( std::memory_order_acquire );
-   auto end = mWritten;
-   const auto free = Free( start, end );
-   samplesToCopy = std::min( samplesToCopy, free );
-   padding = std::min( padding, free - samplesToCopy );
+   const auto spans = AcquireForPut( samplesToCopy + padding );
    auto src = buffer;
    size_t copied = 0;
-   auto pos = end;
-
-   while ( samplesToCopy ) {
-      auto block = std::min( samplesToCopy, mBufferSize - pos );
 
-      CopySamples(src, format,
-                  mBuffer.ptr() + pos * SAMPLE_SIZE(mFormat), mFormat,
-                  block, DitherType::none);
-
-      src += block * SAMPLE_SIZE(format);
-      pos = (pos + block) % mBufferSize;
-      samplesToCopy -= block;
-      copied += block;
+   for (const auto &[ptr, size] : spans) {
+      const auto block = std::min( samplesToCopy, size );
+      if (block) {
+         CopySamples(src, format, ptr, mFormat, block, DitherType::none);
+         src += block * SAMPLE_SIZE(format);
+         samplesToCopy -= block;
+      }
+      if (size > block)
+         // Pad with zeroes after all of the given samples
+         ClearSamples( ptr, mFormat, block, size - block );
+      copied += size;
    }
 
-   while ( padding ) {
-      const auto block = std::min( padding, mBufferSize - pos );
-      ClearSamples( mBuffer.ptr(), mFormat, pos, block );
-      pos = (pos + block) % mBufferSize;
-      padding -= block;
-      copied += block;
-   }
-
-   mWritten = pos;
+   CommitPut( copied );
 
    return copied;
 }
@@ -153,6 +145,26 @@ std::pair<samplePtr, size_t> RingBuffer::GetUnflushed(unsigned iBlock)
          size1 };
 }
 
+auto RingBuffer::AcquireForPut(size_t samples) -> Spans<samplePtr>
+{
+   auto start = mStart.load( std::memory_order_acquire );
+   auto end = mWritten;
+   samples = std::min( samples, Free( start, end ) );
+
+   const auto size0 = std::min( samples, mBufferSize - end );
+   const auto size1 = samples - size0;
+   return {{
+      { size0 ? mBuffer.ptr() + end * SAMPLE_SIZE(mFormat) : nullptr, size0 },
+      { size1 ? mBuffer.ptr() : nullptr, size1 }
+   }};
+}
+
+void RingBuffer::CommitPut(size_t samples)
+{
+   // Still unseen by the reader until Flush()
+   mWritten = (mWritten + samples) % mBufferSize;
+}
+
 void RingBuffer::Flush()
 {
    // Atomically update the end pointer with release, so the nonatomic writes
@@ -181,34 +193,49 @@ size_t RingBuffer::AvailForGet()
 size_t RingBuffer::Get(samplePtr buffer, sampleFormat format,
                        size_t samplesToCopy)
 {
-   // Must match the writer's release with acquire for well defined reads of
-   // the buffer
-   auto end = mEnd.load( std::memory_order_acquire );
-   auto start = mStart.load( std::memory_order_relaxed );
-   samplesToCopy = std::min( samplesToCopy, Filled( start, end ) );
+   const auto spans = AcquireForGet( samplesToCopy );
    auto dest = buffer;
    size_t copied = 0;
 
-   while(samplesToCopy) {
-      auto block = std::min( samplesToCopy, mBufferSize - start );
-
-      CopySamples(mBuffer.ptr() + start * SAMPLE_SIZE(mFormat), mFormat,
-                  dest, format,
-                  block, DitherType::none);
-
-      dest += block * SAMPLE_SIZE(format);
-      start = (start + block) % mBufferSize;
-      samplesToCopy -= block;
-      copied += block;
+   for (const auto &[ptr, size] : spans) {
+      if (!size)
+         continue;
+      CopySamples(ptr, mFormat, dest, format, size, DitherType::none);
+      dest += size * SAMPLE_SIZE(format);
+      copied += size;
    }
 
-   // Communicate to writer that we have consumed some data,
-   // with nonrelaxed ordering
-   mStart.store( start, std::memory_order_release );
+   CommitGet( copied );
 
    return copied;
 }
 
+auto RingBuffer::AcquireForGet(size_t samples) -> Spans<constSamplePtr>
+{
+   // Must match the writer's release with acquire for well defined reads of
+   // the buffer
+   auto end = mEnd.load( std::memory_order_acquire );
+   auto start = mStart.load( std::memory_order_relaxed );
+   samples = std::min( samples, Filled( start, end ) );
+
+   const auto size0 = std::min( samples, mBufferSize - start );
+   const auto size1 = samples - size0;
+   return {{
+      { size0 ? mBuffer.ptr() + start * SAMPLE_SIZE(mFormat) : nullptr,
+         size0 },
+      { size1 ? mBuffer.ptr() : nullptr, size1 }
+   }};
+}
+
+void RingBuffer::CommitGet(size_t samples)
+{
+   auto start = mStart.load( std::memory_order_relaxed );
+   // Communicate to writer that we have consumed some data,
+   // with nonrelaxed ordering, so that the reads of the buffer happen-before
+   // its reuse
+   mStart.store( (start + samples) % mBufferSize, std::memory_order_release );
+}
+
 size_t RingBuffer::Discard(size_t samplesToDiscard)
 {
    auto end = mEnd.load( std::memory_order_relaxed ); // get away with it here
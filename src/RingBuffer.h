@@ -12,10 +12,19 @@
 #define __AUDACITY_RING_BUFFER__
 
 #include "SampleFormat.h"
+#include <array>
 #include <atomic>
 
 class RingBuffer final : public NonInterferingBase {
  public:
+   //! Contiguous storage for samples in the buffer's format
+   template<typename Ptr> struct Span {
+      Ptr ptr{};
+      size_t size{ 0 };
+   };
+   //! A run of samples that may wrap around the end of the buffer
+   template<typename Ptr> using Spans = std::array<Span<Ptr>, 2>;
+
    RingBuffer(sampleFormat format, size_t size);
    ~RingBuffer();
 
@@ -31,7 +40,14 @@ class RingBuffer final : public NonInterferingBase {
    size_t Clear(sampleFormat format, size_t samples);
    //! Get access to written but unflushed data, which is in at most two blocks
    std::pair<samplePtr, size_t> GetUnflushed(unsigned iBlock);
-   //! Flush after a sequence of Put (and/or Clear) calls to let consumer see
+   //! Get access to free space for writing in place, in at most two spans
+   /*! Sizes of the spans total at most samples, and at most AvailForPut() */
+   Spans<samplePtr> AcquireForPut(size_t samples);
+   //! Advance past samples written in place after AcquireForPut()
+   /*! @pre samples is no more than the total of the spans acquired */
+   void CommitPut(size_t samples);
+   //! Flush after a sequence of Put (and/or Clear, CommitPut) calls to let
+   //! consumer see
    void Flush();
 
    //
@@ -41,6 +57,14 @@ class RingBuffer final : public NonInterferingBase {
    size_t AvailForGet();
    //! Does not apply dithering
    size_t Get(samplePtr buffer, sampleFormat format, size_t samples);
+   //! Get access to flushed samples for reading in place, in at most two
+   //! spans
+   /*! Sizes of the spans total at most samples.  They remain valid until
+    CommitGet() or Discard(), which let the writer reuse the space */
+   Spans<constSamplePtr> AcquireForGet(size_t samples);
+   //! Advance past samples read in place after AcquireForGet()
+   /*! @pre samples is no more than the total of the spans acquired */
+   void CommitGet(size_t samples);
    size_t Discard(size_t samples);
 
  private:
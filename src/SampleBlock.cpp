@@ -23,6 +23,30 @@ SampleBlockFactoryPtr SampleBlockFactory::New( AudacityProject &project )
 
 SampleBlockFactory::~SampleBlockFactory() = default;
 
+SampleBlockFactory::BatchScope::BatchScope(SampleBlockFactory &factory)
+   : mFactory{ factory }
+{
+   mFactory.BeginBatch();
+}
+
+SampleBlockFactory::BatchScope::~BatchScope()
+{
+   mFactory.EndBatch();
+}
+
+void SampleBlockFactory::BeginBatch()
+{
+}
+
+void SampleBlockFactory::EndBatch()
+{
+}
+
+auto SampleBlockFactory::GetCacheStatistics() const -> CacheStatistics
+{
+   return {};
+}
+
 SampleBlockPtr SampleBlockFactory::Create(constSamplePtr src,
    size_t numsamples,
    sampleFormat srcformat)
@@ -90,3 +114,23 @@ size_t SampleBlock::GetSamples(samplePtr dest,
    }
 }
 
+double SampleBlock::GetSum(size_t start, size_t len, bool mayThrow)
+{
+   try{ return DoGetSum(start, len); }
+   catch( ... ) {
+      if( mayThrow )
+         throw;
+      return 0;
+   }
+}
+
+double SampleBlock::GetSum(bool mayThrow)
+{
+   try{ return DoGetSum(); }
+   catch( ... ) {
+      if( mayThrow )
+         throw;
+      return 0;
+   }
+}
+
@@ -81,6 +81,16 @@ public:
    // That may be appropriate when only attempting to display samples, not edit.
    MinMaxRMS GetMinMaxRMS(bool mayThrow = true) const;
 
+   /// Gets the sum of samples in the specified region, as for DC offset
+   // If !mayThrow and there is an error, ignores it and returns zero.
+   double GetSum(size_t start, size_t len, bool mayThrow = true);
+
+   /// Gets the sum of samples of the entire block
+   // Kept with the block after it is first calculated, so that repeated
+   // analysis need read only the blocks at the edges of a region.
+   // If !mayThrow and there is an error, ignores it and returns zero.
+   double GetSum(bool mayThrow = true);
+
    virtual size_t GetSpaceUsage() const = 0;
 
    virtual void SaveXML(XMLWriter &xmlFile) = 0;
@@ -94,6 +104,10 @@ protected:
    virtual MinMaxRMS DoGetMinMaxRMS(size_t start, size_t len) = 0;
 
    virtual MinMaxRMS DoGetMinMaxRMS() const = 0;
+
+   virtual double DoGetSum(size_t start, size_t len) = 0;
+
+   virtual double DoGetSum() = 0;
 };
 
 // Makes a useful function object
@@ -138,7 +152,43 @@ public:
    /*! @return ids of all sample blocks created by this factory and still extant */
    virtual SampleBlockIDs GetActiveBlockIDs() = 0;
 
+   //! RAII object during whose lifetime the factory may store new blocks
+   //! in batches, which is faster than storing each one as it is created
+   /*!
+    Scopes may nest; the batch is completed when the outermost one ends.
+    Blocks created in the scope are usable at once.  Use in one thread only.
+    */
+   class AUDACITY_DLL_API BatchScope
+   {
+   public:
+      //! May throw if the factory can't start a batch
+      explicit BatchScope(SampleBlockFactory &factory);
+      ~BatchScope();
+      BatchScope(const BatchScope&) = delete;
+      BatchScope &operator=(const BatchScope&) = delete;
+   private:
+      SampleBlockFactory &mFactory;
+   };
+
+   //! Counters describing a cache of sample contents kept by a factory
+   struct CacheStatistics
+   {
+      size_t bytes = 0; //!< total size of cached contents
+      size_t budget = 0; //!< bound on bytes, beyond which entries are evicted
+      size_t entries = 0;
+      unsigned long long hits = 0;
+      unsigned long long misses = 0;
+      unsigned long long evictions = 0;
+   };
+   /*! Default implementation returns all zeroes, for factories without cache */
+   virtual CacheStatistics GetCacheStatistics() const;
+
 protected:
+   //! Default implementation does nothing
+   virtual void BeginBatch();
+   //! Default implementation does nothing.  Overrides must not throw
+   virtual void EndBatch();
+
    // The override should throw more informative exceptions on error than the
    // default InconsistencyException thrown by Create
    virtual SampleBlockPtr DoCreate(constSamplePtr src,
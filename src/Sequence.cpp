@@ -43,6 +43,7 @@
 
 #include "BasicUI.h"
 #include "SampleBlock.h"
+#include "SummaryPyramid.h"
 #include "InconsistencyException.h"
 
 size_t Sequence::sMaxDiskBlockSize = 1048576;
@@ -53,7 +54,8 @@ Sequence::Sequence(
 :  mpFactory(pFactory),
    mSampleFormat(format),
    mMinSamples(sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormat) / 2),
-   mMaxSamples(mMinSamples * 2)
+   mMaxSamples(mMinSamples * 2),
+   mpSummary{ std::make_unique<SummaryPyramid>() }
 {
 }
 
@@ -65,8 +67,11 @@ Sequence::Sequence(
 :  mpFactory(pFactory),
    mSampleFormat(orig.mSampleFormat),
    mMinSamples(orig.mMinSamples),
-   mMaxSamples(orig.mMaxSamples)
+   mMaxSamples(orig.mMaxSamples),
+   mpSummary{ std::make_unique<SummaryPyramid>() }
 {
+   // With the same factory, this shares the tree of blocks, so copies of
+   // tracks for undo history do not grow with the lengths of sequences
    Paste(0, &orig);
 }
 
@@ -86,8 +91,8 @@ size_t Sequence::GetIdealBlockSize() const
 
 bool Sequence::CloseLock()
 {
-   for (unsigned int i = 0; i < mBlock.size(); i++)
-      mBlock[i].sb->CloseLock();
+   for (const auto &block : mBlock)
+      block.sb->CloseLock();
 
    return true;
 }
@@ -166,10 +171,6 @@ bool Sequence::ConvertToSampleFormat(sampleFormat format,
    } );
 
    BlockArray newBlockArray;
-   // Use the ratio of old to NEW mMaxSamples to make a reasonable guess
-   // at allocation.
-   newBlockArray.reserve
-      (1 + mBlock.size() * ((float)oldMaxSamples / (float)mMaxSamples));
 
    {
       size_t oldSize = oldMaxSamples;
@@ -177,9 +178,8 @@ bool Sequence::ConvertToSampleFormat(sampleFormat format,
       size_t newSize = oldMaxSamples;
       SampleBuffer bufferNew(newSize, format);
 
-      for (size_t i = 0, nn = mBlock.size(); i < nn; i++)
+      for (const auto &oldSeqBlock : mBlock)
       {
-         SeqBlock &oldSeqBlock = mBlock[i];
          const auto &oldBlockFile = oldSeqBlock.sb;
          const auto len = oldBlockFile->GetSampleCount();
          ensureSampleBufferSize(bufferOld, oldFormat, oldSize, len);
@@ -212,7 +212,7 @@ bool Sequence::ConvertToSampleFormat(sampleFormat format,
 
    // Commit the changes to block file array
    CommitChangesIfConsistent
-      (newBlockArray, mNumSamples, wxT("Sequence::ConvertToSampleFormat()"));
+      (newBlockArray, mNumSamples, 0, wxT("Sequence::ConvertToSampleFormat()"));
 
    // Commit the other changes
    bSuccess = true;
@@ -240,16 +240,12 @@ std::pair<float, float> Sequence::GetMinMax(
    unsigned int block1 = FindBlock(start + len - 1);
 
    // First calculate the min/max of the blocks in the middle of this region;
-   // this is very fast because we have the min/max of every entire block
-   // already in memory.
-
-   for (unsigned b = block0 + 1; b < block1; ++b) {
-      auto results = mBlock[b].sb->GetMinMaxRMS(mayThrow);
-
-      if (results.min < min)
-         min = results.min;
-      if (results.max > max)
-         max = results.max;
+   // this is very fast because the summary pyramid combines the min/max of
+   // runs of entire blocks.
+   if (block0 + 1 < block1) {
+      const auto results = GetBlocksSummary(block0 + 1, block1);
+      min = results.min;
+      max = results.max;
    }
 
    // Now we take the first and last blocks into account, noting that the
@@ -316,17 +312,11 @@ float Sequence::GetRMS(sampleCount start, sampleCount len, bool mayThrow) const
    unsigned int block1 = FindBlock(start + len - 1);
 
    // First calculate the rms of the blocks in the middle of this region;
-   // this is very fast because we have the rms of every entire block
-   // already in memory.
-   for (unsigned b = block0 + 1; b < block1; b++) {
-      const SeqBlock &theBlock = mBlock[b];
-      const auto &sb = theBlock.sb;
-      auto results = sb->GetMinMaxRMS(mayThrow);
-
-      const auto fileLen = sb->GetSampleCount();
-      const auto blockRMS = results.RMS;
-      sumsq += blockRMS * blockRMS * fileLen;
-      length += fileLen;
+   // this is very fast because the summary pyramid combines the sums of
+   // squares of runs of entire blocks.
+   if (block0 + 1 < block1) {
+      sumsq = GetBlocksSummary(block0 + 1, block1).sumsq;
+      length = mBlock[block1].start - mBlock[block0 + 1].start;
    }
 
    // Now we take the first and last blocks into account, noting that the
@@ -369,6 +359,121 @@ float Sequence::GetRMS(sampleCount start, sampleCount len, bool mayThrow) const
    return sqrt(sumsq / length.as_double() );
 }
 
+double Sequence::GetSum(sampleCount start, sampleCount len, bool mayThrow,
+   const std::function<void(size_t)> & progressReport) const
+{
+   if (len == 0 || mBlock.size() == 0)
+      return 0;
+
+   double sum = 0;
+
+   unsigned int block0 = FindBlock(start);
+   unsigned int block1 = FindBlock(start + len - 1);
+
+   // Blocks not yet summed, as in a project just opened, are read whole, so
+   // report progress after each
+   const auto report = [&](size_t count){
+      if (progressReport)
+         progressReport(count);
+   };
+
+   // Only the first and last blocks may need reading of samples
+   {
+      const SeqBlock &theBlock = mBlock[block0];
+      const auto &sb = theBlock.sb;
+      const auto s0 = ( start - theBlock.start ).as_size_t();
+      const auto maxl0 =
+         (theBlock.start + sb->GetSampleCount() - start).as_size_t();
+      const auto l0 = limitSampleBufferSize( maxl0, len );
+      sum += (s0 == 0 && l0 == sb->GetSampleCount())
+         ? sb->GetSum(mayThrow)
+         : sb->GetSum(s0, l0, mayThrow);
+      report(l0);
+   }
+
+   // Blocks in the middle of this region contribute their sums, which are
+   // kept with the blocks after the first calculation
+   auto iter = mBlock.IteratorAt(block0 + 1);
+   for (unsigned b = block0 + 1; b < block1; ++b, ++iter) {
+      sum += iter->sb->GetSum(mayThrow);
+      report(iter->sb->GetSampleCount());
+   }
+
+   if (block1 > block0) {
+      const SeqBlock &theBlock = mBlock[block1];
+      const auto &sb = theBlock.sb;
+      const auto l0 = ( start + len - theBlock.start ).as_size_t();
+      sum += (l0 == sb->GetSampleCount())
+         ? sb->GetSum(mayThrow)
+         : sb->GetSum(0, l0, mayThrow);
+      report(l0);
+   }
+
+   return sum;
+}
+
+bool Sequence::IsQuieterThan(
+   sampleCount start, sampleCount len, double level) const
+{
+   if (len == 0)
+      return true;
+   if (mBlock.size() == 0)
+      return false;
+
+   const auto isQuiet = [level](float min, float max){
+      return max < level && min > -level;
+   };
+
+   // Examine summaries of coarser and then finer frames of the parts of
+   // blocks in the range, until all frames are quiet or one is not
+   const auto framesAreQuiet = [&](SampleBlock &sb,
+      size_t from, size_t to, size_t frameSize, bool summary64k)
+   {
+      const auto first = from / frameSize;
+      const auto nFrames = (to + frameSize - 1) / frameSize - first;
+      Floats summary{ 3 * nFrames };
+      if (!(summary64k
+         ? sb.GetSummary64k(summary.get(), first, nFrames)
+         : sb.GetSummary256(summary.get(), first, nFrames)))
+         return false;
+      for (size_t ii = 0; ii < nFrames; ++ii)
+         if (!isQuiet(summary[3 * ii], summary[3 * ii + 1]))
+            return false;
+      return true;
+   };
+
+   const unsigned int block0 = FindBlock(start);
+   const unsigned int block1 = FindBlock(start + len - 1);
+   auto iter = mBlock.IteratorAt(block0);
+   for (auto b = block0; b <= block1; ++b, ++iter) {
+      const SeqBlock &theBlock = *iter;
+      const auto &sb = theBlock.sb;
+      const auto count = sb->GetSampleCount();
+
+      // Whole-block extremes are kept in memory
+      const auto results = sb->GetMinMaxRMS(false);
+      if (isQuiet(results.min, results.max))
+         continue;
+
+      const auto from = (std::max(start, theBlock.start) - theBlock.start)
+         .as_size_t();
+      const auto to = (std::min(start + len, theBlock.start + count)
+         - theBlock.start).as_size_t();
+      if (from == 0 && to == count)
+         return false;
+      if (!framesAreQuiet(*sb, from, to, 65536, true) &&
+          !framesAreQuiet(*sb, from, to, 256, false))
+         return false;
+   }
+   return true;
+}
+
+MinMaxSumSq Sequence::GetBlocksSummary(size_t b0, size_t b1) const
+{
+   wxASSERT(b0 <= b1 && b1 <= mBlock.size());
+   return mpSummary->Query(mBlock, b0, b1);
+}
+
 // Must pass in the correct factory for the result.  If it's not the same
 // as in this, then block contents must be copied.
 std::unique_ptr<Sequence> Sequence::Copy( const SampleBlockFactoryPtr &pFactory,
@@ -394,8 +499,6 @@ std::unique_ptr<Sequence> Sequence::Copy( const SampleBlockFactoryPtr &pFactory,
    wxUnusedVar(numBlocks);
    wxASSERT(b0 <= b1);
 
-   dest->mBlock.reserve(b1 - b0 + 1);
-
    auto bufferSize = mMaxSamples;
    SampleBuffer buffer(bufferSize, mSampleFormat);
 
@@ -419,10 +522,19 @@ std::unique_ptr<Sequence> Sequence::Copy( const SampleBlockFactoryPtr &pFactory,
       --b0;
 
    // If there are blocks in the middle, use the blocks whole
-   for (int bb = b0 + 1; bb < b1; ++bb)
-      AppendBlock(pUseFactory, mSampleFormat,
-         dest->mBlock, dest->mNumSamples, mBlock[bb]);
-      // Increase ref count or duplicate file
+   if (b0 + 1 < b1) {
+      auto middle = mBlock.Slice(b0 + 1, b1);
+      if (!pUseFactory) {
+         // Share the nodes too
+         dest->mNumSamples += middle.GetSampleCount();
+         dest->mBlock.Append(middle);
+      }
+      else
+         for (const auto &block : middle)
+            AppendBlock(pUseFactory, mSampleFormat,
+               dest->mBlock, dest->mNumSamples, block);
+            // Duplicate file
+   }
 
    // Do the last block
    if (b1 > b0) {
@@ -529,21 +641,27 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
       // Build and swap a copy so there is a strong exception safety guarantee
       BlockArray newBlock{ mBlock };
       sampleCount samples = mNumSamples;
-      for (unsigned int i = 0; i < srcNumBlocks; i++)
-         // AppendBlock may throw for limited disk space, if pasting from
-         // one project into another.
-         AppendBlock(pUseFactory, mSampleFormat,
-            newBlock, samples, srcBlock[i]);
+      if (!pUseFactory) {
+         // Share the nodes too
+         newBlock.Append(srcBlock);
+         samples += addedLen;
+      }
+      else
+         for (const auto &block : srcBlock)
+            // AppendBlock may throw for limited disk space, if pasting from
+            // one project into another.
+            AppendBlock(pUseFactory, mSampleFormat,
+               newBlock, samples, block);
 
       CommitChangesIfConsistent
-         (newBlock, samples, wxT("Paste branch one"));
+         (newBlock, samples, numBlocks, wxT("Paste branch one"));
       return;
    }
 
    const int b = (s == mNumSamples) ? mBlock.size() - 1 : FindBlock(s);
    wxASSERT((b >= 0) && (b < (int)numBlocks));
-   SeqBlock *const pBlock = &mBlock[b];
-   const auto length = pBlock->sb->GetSampleCount();
+   const SeqBlock block = mBlock[b];
+   const auto length = block.sb->GetSampleCount();
    const auto largerBlockLen = addedLen + length;
    // PRL: when insertion point is the first sample of a block,
    // and the following test fails, perhaps we could test
@@ -552,7 +670,6 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
       // Special case: we can fit all of the NEW samples inside of
       // one block!
 
-      SeqBlock &block = *pBlock;
       // largerBlockLen is not more than mMaxSamples...
       SampleBuffer buffer(largerBlockLen.as_size_t(), mSampleFormat);
 
@@ -568,19 +685,19 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
            splitPoint, length - splitPoint, true);
 
       // largerBlockLen is not more than mMaxSamples...
-      block.sb = mpFactory->Create(
+      auto sb = mpFactory->Create(
          buffer.ptr(),
          largerBlockLen.as_size_t(),
          mSampleFormat);
 
       // Don't make a duplicate array.  We can still give Strong-guarantee
-      // if we modify only one block in place.
+      // if we modify only one block in place; starts of later blocks
+      // follow.
+      mBlock.Set(b, sb);
 
       // use No-fail-guarantee in remaining steps
-      for (unsigned int i = b + 1; i < numBlocks; i++)
-         mBlock[i].start += addedLen;
-
       mNumSamples += addedLen;
+      mpSummary->Invalidate(b);
 
       // This consistency check won't throw, it asserts.
       // Proof that we kept consistency is not hard.
@@ -592,16 +709,13 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
    // it's simplest to just lump all the data together
    // into one big block along with the split block,
    // then resplit it all
-   BlockArray newBlock;
-   newBlock.reserve(numBlocks + srcNumBlocks + 2);
-   newBlock.insert(newBlock.end(), mBlock.begin(), mBlock.begin() + b);
+   BlockArray newBlock = mBlock.Slice(0, b);
 
-   SeqBlock &splitBlock = mBlock[b];
+   const SeqBlock &splitBlock = block;
    auto splitLen = splitBlock.sb->GetSampleCount();
    // s lies within splitBlock
    auto splitPoint = ( s - splitBlock.start ).as_size_t();
 
-   unsigned int i;
    if (srcNumBlocks <= 4) {
 
       // addedLen is at most four times maximum block size
@@ -647,12 +761,16 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
       Blockify(*mpFactory, mMaxSamples, mSampleFormat,
                newBlock, splitBlock.start, sampleBuffer.ptr(), leftLen);
 
-      for (i = 2; i < srcNumBlocks - 2; i++) {
-         const SeqBlock &block = srcBlock[i];
-         auto sb = ShareOrCopySampleBlock(
-            pUseFactory, mSampleFormat, block.sb );
-         newBlock.push_back(SeqBlock(sb, block.start + s));
-      }
+      auto middle = srcBlock.Slice(2, srcNumBlocks - 2);
+      if (!pUseFactory)
+         // Share the nodes too
+         newBlock.Append(middle);
+      else
+         for (const auto &middleBlock : middle) {
+            auto sb = ShareOrCopySampleBlock(
+               pUseFactory, mSampleFormat, middleBlock.sb );
+            newBlock.push_back(SeqBlock(sb, middleBlock.start + s));
+         }
 
       auto lastStart = penultimate.start;
       src->Get(srcNumBlocks - 2, sampleBuffer.ptr(), mSampleFormat,
@@ -664,13 +782,12 @@ void Sequence::Paste(sampleCount s, const Sequence *src)
                newBlock, s + lastStart, sampleBuffer.ptr(), rightLen);
    }
 
-   // Copy remaining blocks to NEW block array and
-   // swap the NEW block array in for the old
-   for (i = b + 1; i < numBlocks; i++)
-      newBlock.push_back(mBlock[i].Plus(addedLen));
+   // Share remaining blocks in the NEW block array, with starts that follow,
+   // and swap the NEW block array in for the old
+   newBlock.Append(mBlock.Slice(b + 1, numBlocks));
 
    CommitChangesIfConsistent
-      (newBlock, mNumSamples + addedLen, wxT("Paste branch three"));
+      (newBlock, mNumSamples + addedLen, b, wxT("Paste branch three"));
 }
 
 /*! @excsafety{Strong} */
@@ -700,11 +817,6 @@ void Sequence::InsertSilence(sampleCount s0, sampleCount len)
 
    sampleCount pos = 0;
 
-   // Could nBlocks overflow a size_t?  Not very likely.  You need perhaps
-   // 2 ^ 52 samples which is over 3000 years at 44.1 kHz.
-   auto nBlocks = (len + idealSamples - 1) / idealSamples;
-   sTrack.mBlock.reserve(nBlocks.as_size_t());
-
    if (len >= idealSamples) {
       auto silentFile = factory.CreateSilent(
          idealSamples,
@@ -821,6 +933,24 @@ bool Sequence::HandleXMLTag(const std::string_view& tag, const AttributesList &a
          }
       }
 
+      // Make sure that start times and lengths are consistent; starts of
+      // blocks in the array always are, so detect gaps here
+      const auto numSamples = mBlock.GetSampleCount();
+      if (wb.start != numSamples)
+      {
+         wxLogWarning(
+            wxT("Gap detected in project file.\n")
+            wxT("   Start (%s) for block file %lld is not one sample past end of previous block (%s).\n")
+            wxT("   Moving start so blocks are contiguous."),
+            // PRL:  Why bother with Internat when the above is just wxT?
+            Internat::ToString(wb.start.as_double(), 0),
+            wb.sb->GetBlockID(),
+            Internat::ToString(numSamples.as_double(), 0));
+         wb.start = numSamples;
+         mErrorOpening = true;
+      }
+
+      mpSummary->Invalidate(mBlock.size());
       mBlock.push_back(wb);
 
       return true;
@@ -897,26 +1027,8 @@ void Sequence::HandleXMLEndTag(const std::string_view& tag)
 
    // Make sure that the sequence is valid.
 
-   // Make sure that start times and lengths are consistent
-   sampleCount numSamples = 0;
-   for (unsigned b = 0, nn = mBlock.size(); b < nn;  b++)
-   {
-      SeqBlock &block = mBlock[b];
-      if (block.start != numSamples)
-      {
-         wxLogWarning(
-            wxT("Gap detected in project file.\n")
-            wxT("   Start (%s) for block file %lld is not one sample past end of previous block (%s).\n")
-            wxT("   Moving start so blocks are contiguous."),
-            // PRL:  Why bother with Internat when the above is just wxT?
-            Internat::ToString(block.start.as_double(), 0),
-            block.sb->GetBlockID(),
-            Internat::ToString(numSamples.as_double(), 0));
-         block.start = numSamples;
-         mErrorOpening = true;
-      }
-      numSamples += block.sb->GetSampleCount();
-   }
+   // Starts of blocks were corrected as they were read
+   const auto numSamples = mBlock.GetSampleCount();
 
    if (mNumSamples != numSamples)
    {
@@ -944,17 +1056,13 @@ XMLTagHandler *Sequence::HandleXMLChild(const std::string_view& tag)
 void Sequence::WriteXML(XMLWriter &xmlFile) const
 // may throw
 {
-   unsigned int b;
-
    xmlFile.StartTag(wxT("sequence"));
 
    xmlFile.WriteAttr(wxT("maxsamples"), mMaxSamples);
    xmlFile.WriteAttr(wxT("sampleformat"), (size_t)mSampleFormat);
    xmlFile.WriteAttr(wxT("numsamples"), mNumSamples.as_long_long() );
 
-   for (b = 0; b < mBlock.size(); b++) {
-      const SeqBlock &bb = mBlock[b];
-
+   for (const auto &bb : mBlock) {
       // See http://bugzilla.audacityteam.org/show_bug.cgi?id=451.
       if (bb.sb->GetSampleCount() > mMaxSamples)
       {
@@ -995,42 +1103,8 @@ int Sequence::FindBlock(sampleCount pos) const
    if (pos == 0)
       return 0;
 
-   int numBlocks = mBlock.size();
-
-   size_t lo = 0, hi = numBlocks, guess;
-   sampleCount loSamples = 0, hiSamples = mNumSamples;
-
-   while (true) {
-      //this is not a binary search, but a
-      //dictionary search where we guess something smarter than the binary division
-      //of the unsearched area, since samples are usually proportional to block file number.
-      const double frac = (pos - loSamples).as_double() /
-         (hiSamples - loSamples).as_double();
-      guess = std::min(hi - 1, lo + size_t(frac * (hi - lo)));
-      const SeqBlock &block = mBlock[guess];
-
-      wxASSERT(block.sb->GetSampleCount() > 0);
-      wxASSERT(lo <= guess && guess < hi && lo < hi);
-
-      if (pos < block.start) {
-         wxASSERT(lo != guess);
-         hi = guess;
-         hiSamples = block.start;
-      }
-      else {
-         const sampleCount nextStart = block.start + block.sb->GetSampleCount();
-         if (pos < nextStart)
-            break;
-         else {
-            wxASSERT(guess < hi - 1);
-            lo = guess + 1;
-            loSamples = nextStart;
-         }
-      }
-   }
-
-   const int rval = guess;
-   wxASSERT(rval >= 0 && rval < numBlocks &&
+   const int rval = mBlock.FindBlock(pos);
+   wxASSERT(rval >= 0 && rval < (int)mBlock.size() &&
             pos >= mBlock[rval].start &&
             pos < mBlock[rval].start + mBlock[rval].sb->GetSampleCount());
 
@@ -1121,8 +1195,8 @@ void Sequence::SetSamples(constSamplePtr buffer, sampleFormat format,
    }
 
    int b = FindBlock(start);
-   BlockArray newBlock;
-   std::copy( mBlock.begin(), mBlock.begin() + b, std::back_inserter(newBlock) );
+   const auto firstChanged = b;
+   BlockArray newBlock = mBlock.Slice(0, b);
 
    while (len > 0
       // Redundant termination condition,
@@ -1131,8 +1205,7 @@ void Sequence::SetSamples(constSamplePtr buffer, sampleFormat format,
       // that cause the loop to make no progress because blen == 0
       && b < (int)size
    ) {
-      newBlock.push_back( mBlock[b] );
-      SeqBlock &block = newBlock.back();
+      SeqBlock block = mBlock[b];
       // start is within block
       const auto bstart = ( start - block.start ).as_size_t();
       const auto fileLength = block.sb->GetSampleCount();
@@ -1195,6 +1268,8 @@ void Sequence::SetSamples(constSamplePtr buffer, sampleFormat format,
             block.sb = factory.CreateSilent(fileLength, mSampleFormat);
       }
 
+      newBlock.push_back( block );
+
       // blen might be zero for inconsistent Sequence...
       if( buffer )
          buffer += (blen * SAMPLE_SIZE(format));
@@ -1206,9 +1281,10 @@ void Sequence::SetSamples(constSamplePtr buffer, sampleFormat format,
       b++;
    }
 
-   std::copy( mBlock.begin() + b, mBlock.end(), std::back_inserter(newBlock) );
+   newBlock.Append( mBlock.Slice( b, size ) );
 
-   CommitChangesIfConsistent( newBlock, mNumSamples, wxT("SetSamples") );
+   CommitChangesIfConsistent(
+      newBlock, mNumSamples, firstChanged, wxT("SetSamples") );
 }
 
 size_t Sequence::GetIdealAppendLen() const
@@ -1281,22 +1357,31 @@ SeqBlock::SampleBlockPtr Sequence::DoAppend(
    BlockArray newBlock;
    sampleCount newNumSamples = mNumSamples;
 
+   // Store the rows together when making several blocks
+   std::optional<SampleBlockFactory::BatchScope> batch;
+   if (len > GetIdealBlockSize())
+      batch.emplace(factory);
+
    // If the last block is not full, we need to add samples to it
    int numBlocks = mBlock.size();
-   SeqBlock *pLastBlock;
-   decltype(pLastBlock->sb->GetSampleCount()) length;
-   size_t bufferSize = mMaxSamples;
-   SampleBuffer buffer2(bufferSize, mSampleFormat);
+   SeqBlock lastBlock;
+   decltype(lastBlock.sb->GetSampleCount()) length;
+   // Allocated only when samples must be copied or converted
+   SampleBuffer buffer2;
+   const auto scratch = [&]{
+      if (!buffer2.ptr())
+         buffer2.Allocate(mMaxSamples, mSampleFormat);
+      return buffer2.ptr();
+   };
    bool replaceLast = false;
    if (coalesce &&
        numBlocks > 0 &&
        (length =
-        (pLastBlock = &mBlock.back())->sb->GetSampleCount()) < mMinSamples) {
+        (lastBlock = mBlock.back()).sb->GetSampleCount()) < mMinSamples) {
       // Enlarge a sub-minimum block at the end
-      const SeqBlock &lastBlock = *pLastBlock;
       const auto addLen = std::min(mMaxSamples - length, len);
 
-      Read(buffer2.ptr(), mSampleFormat, lastBlock, 0, length, true);
+      Read(scratch(), mSampleFormat, lastBlock, 0, length, true);
 
       CopySamples(buffer,
                   format,
@@ -1332,7 +1417,7 @@ SeqBlock::SampleBlockPtr Sequence::DoAppend(
          result = pBlock;
       }
       else {
-         CopySamples(buffer, format, buffer2.ptr(), mSampleFormat, addedLen);
+         CopySamples(buffer, format, scratch(), mSampleFormat, addedLen);
          pBlock = factory.Create(buffer2.ptr(), addedLen, mSampleFormat);
       }
 
@@ -1365,7 +1450,11 @@ void Sequence::Blockify(SampleBlockFactory &factory,
       return;
 
    auto num = (len + (mMaxSamples - 1)) / mMaxSamples;
-   list.reserve(list.size() + num);
+
+   // Store the rows together when making several blocks
+   std::optional<SampleBlockFactory::BatchScope> batch;
+   if (num > 1)
+      batch.emplace(factory);
 
    for (decltype(num) i = 0; i < num; i++) {
       SeqBlock b;
@@ -1399,8 +1488,8 @@ void Sequence::Delete(sampleCount start, sampleCount len)
 
    auto sampleSize = SAMPLE_SIZE(mSampleFormat);
 
-   SeqBlock *pBlock;
-   decltype(pBlock->sb->GetSampleCount()) length;
+   SeqBlock b;
+   decltype(b.sb->GetSampleCount()) length;
 
    // One buffer for reuse in various branches here
    SampleBuffer scratch;
@@ -1411,8 +1500,7 @@ void Sequence::Delete(sampleCount start, sampleCount len)
    // block and the resulting length is not too small, perform the
    // deletion within this block:
    if (b0 == b1 &&
-       (length = (pBlock = &mBlock[b0])->sb->GetSampleCount()) - len >= mMinSamples) {
-      SeqBlock &b = *pBlock;
+       (length = (b = mBlock[b0]).sb->GetSampleCount()) - len >= mMinSamples) {
       // start is within block
       auto pos = ( start - b.start ).as_size_t();
 
@@ -1433,17 +1521,16 @@ void Sequence::Delete(sampleCount start, sampleCount len)
            // is not more than the length of the block
            ( pos + len ).as_size_t(), newLen - pos, true);
 
-      b.sb = factory.Create(scratch.ptr(), newLen, mSampleFormat);
+      auto sb = factory.Create(scratch.ptr(), newLen, mSampleFormat);
 
       // Don't make a duplicate array.  We can still give Strong-guarantee
-      // if we modify only one block in place.
+      // if we modify only one block in place; starts of later blocks
+      // follow.
+      mBlock.Set(b0, sb);
 
       // use No-fail-guarantee in remaining steps
-
-      for (unsigned int j = b0 + 1; j < numBlocks; j++)
-         mBlock[j].start -= len;
-
       mNumSamples -= len;
+      mpSummary->Invalidate(b0);
 
       // This consistency check won't throw, it asserts.
       // Proof that we kept consistency is not hard.
@@ -1451,14 +1538,10 @@ void Sequence::Delete(sampleCount start, sampleCount len)
       return;
    }
 
-   // Create a NEW array of blocks
-   BlockArray newBlock;
-   newBlock.reserve(numBlocks - (b1 - b0) + 2);
-
-   // Copy the blocks before the deletion point over to
-   // the NEW array
-   newBlock.insert(newBlock.end(), mBlock.begin(), mBlock.begin() + b0);
-   unsigned int i;
+   // Create a NEW array of blocks, sharing the blocks before the deletion
+   // point
+   BlockArray newBlock = mBlock.Slice(0, b0);
+   auto firstChanged = b0;
 
    // First grab the samples in block b0 before the deletion point
    // into preBuffer.  If this is enough samples for its own block,
@@ -1493,6 +1576,7 @@ void Sequence::Delete(sampleCount start, sampleCount len)
               preBlock, 0, preBufferLen, true);
 
          newBlock.pop_back();
+         --firstChanged;
          Blockify(*mpFactory, mMaxSamples, mSampleFormat,
                   newBlock, prepreBlock.start, scratch.ptr(), sum);
       }
@@ -1525,7 +1609,7 @@ void Sequence::Delete(sampleCount start, sampleCount len)
 
          newBlock.push_back(SeqBlock(file, start));
       } else {
-         SeqBlock &postpostBlock = mBlock[b1 + 1];
+         const SeqBlock &postpostBlock = mBlock[b1 + 1];
          const auto postpostLen = postpostBlock.sb->GetSampleCount();
          const auto sum = postpostLen + postBufferLen;
 
@@ -1548,21 +1632,20 @@ void Sequence::Delete(sampleCount start, sampleCount len)
       // right on the end of a block.
    }
 
-   // Copy the remaining blocks over from the old array
-   for (i = b1 + 1; i < numBlocks; i++)
-      newBlock.push_back(mBlock[i].Plus(-len));
+   // Share the remaining blocks of the old array, with starts that follow
+   newBlock.Append(mBlock.Slice(b1 + 1, numBlocks));
 
    CommitChangesIfConsistent
-      (newBlock, mNumSamples - len, wxT("Delete - branch two"));
+      (newBlock, mNumSamples - len, firstChanged, wxT("Delete - branch two"));
 }
 
 void Sequence::ConsistencyCheck(const wxChar *whereStr, bool mayThrow) const
 {
-   ConsistencyCheck(mBlock, mMaxSamples, 0, mNumSamples, whereStr, mayThrow);
+   ConsistencyCheck(mBlock, mMaxSamples, mNumSamples, whereStr, mayThrow);
 }
 
 void Sequence::ConsistencyCheck
-   (const BlockArray &mBlock, size_t maxSamples, size_t from,
+   (const BlockArray &mBlock, size_t maxSamples,
     sampleCount mNumSamples, const wxChar *whereStr,
     bool WXUNUSED(mayThrow))
 {
@@ -1570,28 +1653,14 @@ void Sequence::ConsistencyCheck
    // gives a little more discrimination
    std::optional<InconsistencyException> ex;
 
-   unsigned int numBlocks = mBlock.size();
-
-   unsigned int i;
-   sampleCount pos = from < numBlocks ? mBlock[from].start : mNumSamples;
-   if ( from == 0 && pos != 0 )
+   // Starts of blocks are contiguous by construction of the array
+   if ( !mBlock.empty() && mBlock.front().start != 0 )
       ex.emplace( CONSTRUCT_INCONSISTENCY_EXCEPTION );
-
-   for (i = from; !ex && i < numBlocks; i++) {
-      const SeqBlock &seqBlock = mBlock[i];
-      if (pos != seqBlock.start)
-         ex.emplace( CONSTRUCT_INCONSISTENCY_EXCEPTION );
-
-      if ( seqBlock.sb ) {
-         const auto length = seqBlock.sb->GetSampleCount();
-         if (length > maxSamples)
-            ex.emplace( CONSTRUCT_INCONSISTENCY_EXCEPTION );
-         pos += length;
-      }
-      else
-         ex.emplace( CONSTRUCT_INCONSISTENCY_EXCEPTION );
-   }
-   if ( !ex && pos != mNumSamples )
+   else if ( mBlock.HasNullBlocks() )
+      ex.emplace( CONSTRUCT_INCONSISTENCY_EXCEPTION );
+   else if ( mBlock.GetMaxBlockSampleCount() > maxSamples )
+      ex.emplace( CONSTRUCT_INCONSISTENCY_EXCEPTION );
+   else if ( mBlock.GetSampleCount() != mNumSamples )
       ex.emplace( CONSTRUCT_INCONSISTENCY_EXCEPTION );
 
    if ( ex )
@@ -1613,13 +1682,17 @@ void Sequence::ConsistencyCheck
 }
 
 void Sequence::CommitChangesIfConsistent
-   (BlockArray &newBlock, sampleCount numSamples, const wxChar *whereStr)
+   (BlockArray &newBlock, sampleCount numSamples, size_t from,
+    const wxChar *whereStr)
 {
-   ConsistencyCheck( newBlock, mMaxSamples, 0, numSamples, whereStr ); // may throw
+   ConsistencyCheck( newBlock, mMaxSamples, numSamples, whereStr ); // may throw
 
    // now commit
    // use No-fail-guarantee
 
+   // Summaries of blocks before the first replaced one remain correct
+   mpSummary->Invalidate(from);
+
    mBlock.swap(newBlock);
    mNumSamples = numSamples;
 }
@@ -1634,47 +1707,32 @@ void Sequence::AppendBlocksIfConsistent
    if (additionalBlocks.empty())
       return;
 
-   bool tmpValid = false;
-   SeqBlock tmp;
+   // Build and swap a copy, sharing the nodes of mBlock, so there is a
+   // strong exception safety guarantee
+   BlockArray newBlock{ mBlock };
+   if ( replaceLast && ! newBlock.empty() )
+      newBlock.pop_back();
 
-   if ( replaceLast && ! mBlock.empty() ) {
-      tmp = mBlock.back(), tmpValid = true;
-      mBlock.pop_back();
-   }
+   auto prevSize = newBlock.size();
+   newBlock.Append( additionalBlocks );
 
-   auto prevSize = mBlock.size();
-
-   bool consistent = false;
-   auto cleanup = finally( [&] {
-      if ( !consistent ) {
-         mBlock.resize( prevSize );
-         if ( tmpValid )
-            mBlock.push_back( tmp );
-      }
-   } );
-
-   std::copy( additionalBlocks.begin(), additionalBlocks.end(),
-              std::back_inserter( mBlock ) );
-
-   // Check consistency only of the blocks that were added,
-   // avoiding quadratic time for repeated checking of repeating appends
-   ConsistencyCheck( mBlock, mMaxSamples, prevSize, numSamples, whereStr ); // may throw
+   ConsistencyCheck( newBlock, mMaxSamples, numSamples, whereStr ); // may throw
 
    // now commit
    // use No-fail-guarantee
 
+   mpSummary->Invalidate(prevSize);
+   mBlock.swap(newBlock);
    mNumSamples = numSamples;
-   consistent = true;
 }
 
 void Sequence::DebugPrintf
    (const BlockArray &mBlock, sampleCount mNumSamples, wxString *dest)
 {
-   unsigned int i;
+   unsigned int i = 0;
    decltype(mNumSamples) pos = 0;
 
-   for (i = 0; i < mBlock.size(); i++) {
-      const SeqBlock &seqBlock = mBlock[i];
+   for (const auto &seqBlock : mBlock) {
       *dest += wxString::Format
          (wxT("   Block %3u: start %8lld, len %8lld, refs %ld, id %lld"),
           i,
@@ -1690,6 +1748,7 @@ void Sequence::DebugPrintf
 
       if (seqBlock.sb)
          pos += seqBlock.sb->GetSampleCount();
+      ++i;
    }
    if (pos != mNumSamples)
       *dest += wxString::Format
@@ -1707,6 +1766,12 @@ size_t Sequence::GetMaxDiskBlockSize()
    return sMaxDiskBlockSize;
 }
 
+size_t Sequence::GetMaxBlockSize(sampleFormat format)
+{
+   // The same calculations as in the constructor
+   return sMaxDiskBlockSize / SAMPLE_SIZE(format) / 2 * 2;
+}
+
 bool Sequence::IsValidSampleFormat(const int nValue)
 {
    return (nValue == int16Sample) || (nValue == int24Sample) || (nValue == floatSample);
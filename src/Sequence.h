@@ -14,39 +14,20 @@
 
 #include <vector>
 #include <functional>
+#include <memory>
 
+#include "BlockArray.h"
 #include "SampleFormat.h"
+#include "SampleStatistics.h"
 #include "XMLTagHandler.h"
 
 #include "SampleCount.h"
 
 class SampleBlock;
 class SampleBlockFactory;
+class SummaryPyramid;
 using SampleBlockFactoryPtr = std::shared_ptr<SampleBlockFactory>;
 
-// This is an internal data structure!  For advanced use only.
-class SeqBlock {
- public:
-   using SampleBlockPtr = std::shared_ptr<SampleBlock>;
-   SampleBlockPtr sb;
-   ///the sample in the global wavetrack that this block starts at.
-   sampleCount start;
-
-   SeqBlock()
-      : sb{}, start(0)
-   {}
-
-   SeqBlock(const SampleBlockPtr &sb_, sampleCount start_)
-      : sb(sb_), start(start_)
-   {}
-
-   // Construct a SeqBlock with changed start, same file
-   SeqBlock Plus(sampleCount delta) const
-   {
-      return SeqBlock(sb, start + delta);
-   }
-};
-class BlockArray : public std::vector<SeqBlock> {};
 using BlockPtrArray = std::vector<SeqBlock*>; // non-owning pointers
 
 // Put extra symbol information in the release build, for the purpose of gathering
@@ -67,6 +48,8 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
 
    static void SetMaxDiskBlockSize(size_t bytes);
    static size_t GetMaxDiskBlockSize();
+   //! GetMaxBlockSize() of a new sequence of the given format
+   static size_t GetMaxBlockSize(sampleFormat format);
 
    //! true if nValue is one of the sampleFormat enum values
    static bool IsValidSampleFormat(const int nValue);
@@ -118,7 +101,7 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    void SetSilence(sampleCount s0, sampleCount len);
    void InsertSilence(sampleCount s0, sampleCount len);
 
-   const SampleBlockFactoryPtr &GetFactory() { return mpFactory; }
+   const SampleBlockFactoryPtr &GetFactory() const { return mpFactory; }
 
    //
    // XMLTagHandler callback methods for loading and saving
@@ -155,6 +138,22 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    std::pair<float, float> GetMinMax(
       sampleCount start, sampleCount len, bool mayThrow) const;
    float GetRMS(sampleCount start, sampleCount len, bool mayThrow) const;
+   //! Sum of samples, as for DC offset; reads only partly covered blocks,
+   //! after sums of whole blocks are first calculated
+   /*! @param progressReport if not empty, is given the number of samples of
+    each block, after they are summed; it may throw to cancel */
+   double GetSum(sampleCount start, sampleCount len, bool mayThrow,
+      const std::function<void(size_t)> & progressReport = {}) const;
+   //! Whether the summaries of blocks show that all samples in the range are
+   //! strictly between -level and level
+   /*! Reads no samples, so the answer may be false for quiet samples that
+    share a summary frame with louder ones */
+   bool IsQuieterThan(sampleCount start, sampleCount len, double level) const;
+
+   //! Extremes and sum of squares of blocks b0 up to but excluding b1
+   /*! Cost is logarithmic in the number of blocks, using summaries that are
+    kept between calls and recomputed after edits only where blocks changed */
+   MinMaxSumSq GetBlocksSummary(size_t b0, size_t b1) const;
 
    //
    // Getting block size and alignment information
@@ -201,6 +200,8 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
 
    bool          mErrorOpening{ false };
 
+   const std::unique_ptr<SummaryPyramid> mpSummary;
+
    //
    // Private methods
    //
@@ -253,8 +254,9 @@ public:
       (const BlockArray &block, sampleCount numSamples, wxString *dest);
 
 private:
+   //! Constant time, using statistics of all blocks kept in the array
    static void ConsistencyCheck
-      (const BlockArray &block, size_t maxSamples, size_t from,
+      (const BlockArray &block, size_t maxSamples,
        sampleCount numSamples, const wxChar *whereStr,
        bool mayThrow = true);
 
@@ -262,8 +264,10 @@ private:
    // They either throw because final consistency check fails, or swap the
    // changed contents into place.
 
+   //! @param from index of the first block that may differ from mBlock
    void CommitChangesIfConsistent
-      (BlockArray &newBlock, sampleCount numSamples, const wxChar *whereStr);
+      (BlockArray &newBlock, sampleCount numSamples, size_t from,
+       const wxChar *whereStr);
 
    void AppendBlocksIfConsistent
       (BlockArray &additionalBlocks, bool replaceLast,
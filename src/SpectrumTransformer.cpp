@@ -12,6 +12,7 @@ Edward Hui
 
 #include <algorithm>
 #include "FFT.h"
+#include "ThreadPool.h"
 #include "WaveTrack.h"
 
 SpectrumTransformer::SpectrumTransformer( bool needsOutput,
@@ -103,7 +104,11 @@ bool SpectrumTransformer::DoFinish()
 void
 TrackSpectrumTransformer::DoOutput(const float *outBuffer, size_t mStepSize)
 {
-   mOutputTrack->Append((constSamplePtr)outBuffer, floatSample, mStepSize);
+   if (mpSegmentOutput)
+      mpSegmentOutput->insert(mpSegmentOutput->end(),
+         outBuffer, outBuffer + mStepSize);
+   else
+      mOutputTrack->Append((constSamplePtr)outBuffer, floatSample, mStepSize);
 }
 
 bool SpectrumTransformer::Start(size_t queueLength)
@@ -375,6 +380,92 @@ bool TrackSpectrumTransformer::Process( const WindowProcessor &processor,
    return bLoopSuccess;
 }
 
+bool TrackSpectrumTransformer::ProcessInSegments(
+   const WindowProcessor &processor, const SegmentFactory &factory,
+   WaveTrack *track, size_t queueLength, sampleCount start, sampleCount len,
+   size_t warmupSteps, size_t lookaheadSteps, ThreadPool &pool,
+   const std::function<bool(double)> &progress)
+{
+   if (!track)
+      return false;
+
+   mpTrack = track;
+
+   if (!Start(queueLength))
+      return false;
+
+   mStart = start;
+   mLen = len;
+
+   // Segments begin on the same grid of steps as windows of Process() do;
+   // make them long enough that the extra steps are a small overhead, but
+   // bound the memory for a batch
+   const auto extraSteps = warmupSteps + lookaheadSteps;
+   const size_t segmentLen = mStepSize * std::max<size_t>(
+      16 * extraSteps, ((1 << 20) + mStepSize - 1) / mStepSize);
+   const auto nSlots = pool.GetNumThreads() + 1;
+
+   struct Slot {
+      std::unique_ptr<TrackSpectrumTransformer> pTransformer;
+      FloatVector input, output;
+      sampleCount inputStart, segmentStart;
+      size_t segmentLen{};
+      bool success{ false };
+   };
+   std::vector<Slot> slots(nSlots);
+   for (auto &slot : slots) {
+      slot.pTransformer = factory();
+      slot.pTransformer->mpSegmentOutput = &slot.output;
+   }
+
+   const auto end = start + len;
+   auto segmentStart = start;
+   while (segmentStart < end) {
+      // Read inputs in this thread
+      size_t nSegments = 0;
+      for (; nSegments < nSlots && segmentStart < end; ++nSegments) {
+         auto &slot = slots[nSegments];
+         slot.segmentStart = segmentStart;
+         slot.segmentLen = limitSampleBufferSize(segmentLen, end - segmentStart);
+         slot.inputStart = std::max(start,
+            segmentStart - sampleCount(warmupSteps * mStepSize));
+         const auto inputEnd = std::min(end,
+            segmentStart + slot.segmentLen + lookaheadSteps * mStepSize);
+         slot.input.resize((inputEnd - slot.inputStart).as_size_t());
+         track->GetFloats(
+            slot.input.data(), slot.inputStart, slot.input.size());
+         segmentStart += slot.segmentLen;
+      }
+
+      // Transform concurrently
+      pool.ParallelFor(nSegments, [&](size_t ii){
+         auto &slot = slots[ii];
+         auto &transformer = *slot.pTransformer;
+         slot.output.clear();
+         slot.success = transformer.Start(queueLength) &&
+            transformer.ProcessSamples(
+               processor, slot.input.data(), slot.input.size()) &&
+            transformer.Finish(processor);
+      });
+
+      // Stitch outputs in order, without those of the extra steps
+      for (size_t ii = 0; ii < nSegments; ++ii) {
+         auto &slot = slots[ii];
+         const auto offset =
+            (slot.segmentStart - slot.inputStart).as_size_t();
+         if (!slot.success || slot.output.size() < offset + slot.segmentLen)
+            return false;
+         mOutputTrack->Append((constSamplePtr)(slot.output.data() + offset),
+            floatSample, slot.segmentLen);
+      }
+
+      if (!progress((segmentStart - start).as_double() / len.as_double()))
+         return false;
+   }
+
+   return DoFinish();
+}
+
 bool TrackSpectrumTransformer::DoFinish()
 {
    if (mOutputTrack) {
@@ -177,6 +177,7 @@ private:
    const bool mNeedsOutput;
 };
 
+class ThreadPool;
 class WaveTrack;
 
 //! Subclass of SpectrumTransformer that rewrites a track
@@ -185,10 +186,34 @@ public:
    using SpectrumTransformer::SpectrumTransformer;
    ~TrackSpectrumTransformer() override;
 
+   //! Type of function that makes another transformer like this one, for
+   //! one segment of a track
+   using SegmentFactory =
+      std::function< std::unique_ptr<TrackSpectrumTransformer>() >;
+
    //! Invokes Start(), ProcessSamples(), and Finish()
    bool Process( const WindowProcessor &processor, WaveTrack *track,
       size_t queueLength, sampleCount start, sampleCount len);
 
+   //! Like Process(), but transforms consecutive segments of the range
+   //! concurrently, each with a transformer made by the factory
+   /*!
+    Each segment also takes warmupSteps steps of input before it and
+    lookaheadSteps steps after it, and discards the output of those.  So the
+    result is the same as from Process(), if the processor makes each step of
+    output independent of windows farther away.
+
+    The processor is called in threads of the pool, and must not use the
+    user interface.  Segments are done in batches; between batches, progress
+    is called in this thread with the fraction done, and may return false to
+    cancel.
+    */
+   bool ProcessInSegments( const WindowProcessor &processor,
+      const SegmentFactory &factory, WaveTrack *track,
+      size_t queueLength, sampleCount start, sampleCount len,
+      size_t warmupSteps, size_t lookaheadSteps, ThreadPool &pool,
+      const std::function<bool(double)> &progress);
+
 protected:
    bool DoStart() override;
    void DoOutput(const float *outBuffer, size_t mStepSize) override;
@@ -197,6 +222,8 @@ protected:
 private:
    WaveTrack *mpTrack = nullptr;
    std::shared_ptr<WaveTrack> mOutputTrack;
+   //! When transforming a segment, output goes here instead
+   FloatVector *mpSegmentOutput = nullptr;
    sampleCount mStart = 0, mLen = 0;
 };
 
@@ -15,17 +15,133 @@ Paul Licameli -- split from SampleBlock.cpp and SampleBlock.h
 #include "DBConnection.h"
 #include "ProjectFileIO.h"
 #include "SampleFormat.h"
+#include "SampleStatistics.h"
 #include "XMLTagHandler.h"
 
 #include "SampleBlock.h" // to inherit
+#include "ThreadPool.h"
+#include "TransactionScope.h"
 #include "UndoManager.h"
 #include "WaveTrack.h"
 
 #include "SentryHelper.h"
 #include <wx/log.h>
+#include <wx/thread.h>
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 class SqliteSampleBlockFactory;
 
+///\brief Least-recently-used cache of the sample contents of committed blocks,
+/// bounded by a budget of bytes
+/*!
+ Contents of a block never change after it is committed, so entries need only
+ be dropped when the budget is exceeded or the block is destroyed.
+
+ Only reads in the main thread use the cache, so that the audio thread and
+ worker threads never wait for its mutex nor allocate entries.  Blocks are
+ still erased from other threads, so all access is serialized by a mutex.
+ */
+class SampleBlockCache
+{
+public:
+   using Blob = std::shared_ptr<const std::vector<char>>;
+   using Key = std::pair<const SqliteSampleBlockFactory*, SampleBlockID>;
+
+   explicit SampleBlockCache(size_t budget) : mBudget{ budget } {}
+
+   //! @return null if not found; else marks the entry as most recently used
+   Blob Find(const Key &key);
+   void Insert(const Key &key, Blob blob);
+   void Erase(const Key &key);
+
+   SampleBlockFactory::CacheStatistics GetStatistics() const;
+
+private:
+   //! Evict least recently used entries until within budget
+   /*! @pre mMutex is locked */
+   void Trim();
+
+   mutable std::mutex mMutex;
+
+   // Most recently used entries are at the front
+   using List = std::list<std::pair<Key, Blob>>;
+   List mList;
+   std::map<Key, List::iterator> mIndex;
+
+   const size_t mBudget;
+   size_t mBytes{ 0 };
+   unsigned long long mHits{ 0 };
+   unsigned long long mMisses{ 0 };
+   unsigned long long mEvictions{ 0 };
+};
+
+auto SampleBlockCache::Find(const Key &key) -> Blob
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   auto iter = mIndex.find(key);
+   if (iter == mIndex.end()) {
+      ++mMisses;
+      return {};
+   }
+   ++mHits;
+   mList.splice(mList.begin(), mList, iter->second);
+   return iter->second->second;
+}
+
+void SampleBlockCache::Insert(const Key &key, Blob blob)
+{
+   if (!blob || blob->size() > mBudget)
+      return;
+
+   std::lock_guard<std::mutex> lock{ mMutex };
+   if (auto iter = mIndex.find(key); iter != mIndex.end()) {
+      // Another thread got here first; contents are the same
+      mList.splice(mList.begin(), mList, iter->second);
+      return;
+   }
+   mBytes += blob->size();
+   mList.emplace_front(key, std::move(blob));
+   mIndex.emplace(key, mList.begin());
+   Trim();
+}
+
+void SampleBlockCache::Erase(const Key &key)
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   if (auto iter = mIndex.find(key); iter != mIndex.end()) {
+      mBytes -= iter->second->second->size();
+      mList.erase(iter->second);
+      mIndex.erase(iter);
+   }
+}
+
+void SampleBlockCache::Trim()
+{
+   while (mBytes > mBudget && !mList.empty()) {
+      auto &last = mList.back();
+      mBytes -= last.second->size();
+      mIndex.erase(last.first);
+      mList.pop_back();
+      ++mEvictions;
+   }
+}
+
+auto SampleBlockCache::GetStatistics() const
+   -> SampleBlockFactory::CacheStatistics
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   return { mBytes, mBudget, mList.size(), mHits, mMisses, mEvictions };
+}
+
 ///\brief Implementation of @ref SampleBlock using Sqlite database
 class SqliteSampleBlock final : public SampleBlock
 {
@@ -42,7 +158,34 @@ public:
 
    //! Numbers of bytes needed for 256 and for 64k summaries
    using Sizes = std::pair< size_t, size_t >;
-   void Commit(Sizes sizes);
+   //! Statistics of all samples of the block
+   struct Totals {
+      double min{ 0 };
+      double max{ 0 };
+      double rms{ 0 };
+      //! Sum of samples, stored after the 64k summary
+      double sum{ NAN };
+   };
+   //! Summaries kept in memory until they are stored in the database
+   /*! Shared by the block with the worker thread and the deferred write that
+    make and store them, so that destruction of the block need not wait */
+   struct PendingSummary {
+      Sizes sizes;
+      //! New samples, only until the worker thread calculates the summaries
+      ArrayOf<char> samples;
+      //! Guards the summaries, which become null when stored
+      std::mutex mutex;
+      ArrayOf<char> summary256;
+      ArrayOf<char> summary64k;
+      //! Set when the row is deleted, with the write lock held
+      bool cancelled{ false };
+   };
+
+   void Commit();
+   //! Store summaries in the row that Commit() inserted
+   /*! @pre the write lock of conn is held */
+   static void CommitSummary(DBConnection &conn, SampleBlockID id,
+      const Totals &totals, const PendingSummary &summary);
 
    void Delete();
 
@@ -67,6 +210,10 @@ public:
    /// Gets extreme values for the entire block
    MinMaxRMS DoGetMinMaxRMS() const override;
 
+   double DoGetSum(size_t start, size_t len) override;
+
+   double DoGetSum() override;
+
    size_t GetSpaceUsage() const override;
    void SaveXML(XMLWriter &xmlFile) override;
 
@@ -84,13 +231,43 @@ private:
                   sampleFormat srcformat,
                   size_t srcoffset,
                   size_t srcbytes);
+   //! Fetch all sample contents from the database or from the cache
+   SampleBlockCache::Blob GetSamplesBlob();
+   //! Pass all sample contents to a visitor, from the cache in the main
+   //! thread; else directly from the statement, without copying them into
+   //! the cache
+   /*! The pointer is valid only during the visit */
+   void VisitSamples(
+      const std::function<void(constSamplePtr src, size_t blobbytes)> &visitor);
+   //! Execute a statement selecting one blob for this block, and pass the
+   //! result to a visitor before the statement is reset
+   void VisitBlob(sqlite3_stmt *stmt,
+      const std::function<void(constSamplePtr src, size_t blobbytes)> &visitor);
+   static size_t CopyBlob(void *dest,
+                  sampleFormat destformat,
+                  constSamplePtr src,
+                  size_t blobbytes,
+                  sampleFormat srcformat,
+                  size_t srcoffset,
+                  size_t srcbytes);
 
    enum {
       fields = 3, /* min, max, rms */
       bytesPerFrame = fields * sizeof(float),
    };
    Sizes SetSizes( size_t numsamples, sampleFormat srcformat );
-   void CalcSummary(Sizes sizes);
+   static Totals CalcSummary(constSamplePtr src, sampleFormat format,
+      size_t count, Sizes sizes,
+      ArrayOf<char> &summary256, ArrayOf<char> &summary64k);
+   //! Calculate summaries in a worker thread, and defer the storing of them
+   /*! @pre Commit() was called; @post mSamples is reset */
+   void ScheduleSummary(Sizes sizes);
+   //! Block until summaries scheduled by ScheduleSummary() are calculated
+   void WaitForSummary() const;
+   //! Totals of the samples, after any calculation in a worker thread
+   Totals GetTotals() const;
+   //! Calculate and store summaries that are missing from the database
+   void RecoverSummary();
 
 private:
    //! This must never be called for silent blocks
@@ -114,11 +291,19 @@ private:
    size_t mSampleCount;
    sampleFormat mSampleFormat;
 
-   ArrayOf<char> mSummary256;
-   ArrayOf<char> mSummary64k;
+   // Totals of loaded samples
    double mSumMin;
    double mSumMax;
    double mSumRms;
+   //! Sum of samples; NaN until it is calculated at first use, if it was not
+   //! stored with the summaries
+   std::atomic<double> mSumTotal{ NAN };
+
+   //! Becomes ready with the totals of new samples, when their summaries are
+   //! calculated; the totals above are not used then
+   std::shared_future<Totals> mSummaryReady;
+   //! Summaries not yet stored, if any
+   std::shared_ptr<PendingSummary> mpPendingSummary;
 
 #if defined(WORDS_BIGENDIAN)
 #error All sample block data is little endian...big endian not yet supported
@@ -155,10 +340,31 @@ public:
       sampleFormat srcformat,
       const AttributesList &attrs) override;
 
+   CacheStatistics GetCacheStatistics() const override;
+
+protected:
+   void BeginBatch() override;
+   void EndBatch() override;
+
 private:
    void OnBeginPurge(size_t begin, size_t end);
    void OnEndPurge();
 
+   //! Called after each insertion of a row; completes a batch in progress
+   //! when it grows large enough, and starts another
+   void OnInserted();
+   //! @return success
+   bool CommitBatch();
+   //! Lock out writes of other threads to the current connection, if any
+   std::unique_lock<std::recursive_mutex> LockWrites();
+   //! Throw a message for the user, if the project was opened read-only
+   void CheckWritable();
+
+   //! The cache of sample contents, shared by the factories of all projects
+   /*! Keys include the factory because block ids are unique only within one
+    project database */
+   static SampleBlockCache &Cache();
+
    friend SqliteSampleBlock;
    
    AudacityProject &mProject;
@@ -173,6 +379,17 @@ private:
    using AllBlocksMap =
       std::map< SampleBlockID, std::weak_ptr< SqliteSampleBlock > >;
    AllBlocksMap mAllBlocks;
+
+   // Inserts are grouped in one transaction while a BatchScope exists.
+   // Bound the number of rows per transaction, so that the write-ahead log
+   // can still be checkpointed during very long imports, and so that other
+   // threads don't wait long for the write lock of the connection.
+   // These members change only with the write lock held.
+   static constexpr size_t BatchRows = 1024;
+   std::optional<TransactionScope> mBatchTransaction;
+   std::thread::id mBatchThread;
+   size_t mBatchDepth{ 0 };
+   size_t mBatchRows{ 0 };
 };
 
 SqliteSampleBlockFactory::SqliteSampleBlockFactory( AudacityProject &project )
@@ -194,9 +411,98 @@ SqliteSampleBlockFactory::SqliteSampleBlockFactory( AudacityProject &project )
 
 SqliteSampleBlockFactory::~SqliteSampleBlockFactory() = default;
 
+SampleBlockCache &SqliteSampleBlockFactory::Cache()
+{
+   // Enough for some minutes of stereo float audio at 44.1 kHz
+   static SampleBlockCache theCache{ 256 * 1024 * 1024 };
+   return theCache;
+}
+
+auto SqliteSampleBlockFactory::GetCacheStatistics() const -> CacheStatistics
+{
+   return Cache().GetStatistics();
+}
+
+void SqliteSampleBlockFactory::BeginBatch()
+{
+   CheckWritable();
+   auto writeLock = LockWrites();
+   if (mBatchDepth == 0) {
+      // May throw
+      mBatchTransaction.emplace(mProject, "SampleBlockBatch");
+      mBatchThread = std::this_thread::get_id();
+      mBatchRows = 0;
+   }
+   ++mBatchDepth;
+}
+
+void SqliteSampleBlockFactory::EndBatch()
+{
+   auto writeLock = LockWrites();
+   wxASSERT(mBatchDepth > 0);
+   if (--mBatchDepth == 0) {
+      // Commit even when unwinding for an exception:  blocks already created
+      // must keep their rows
+      if (!CommitBatch())
+         // Show the user the same message as OnInserted() does, but later in
+         // the main thread, because this is called from a destructor
+         GuardedCall( [this]{
+            mppConnection->mpConnection->ThrowException( true ); } );
+      mBatchTransaction.reset();
+   }
+}
+
+std::unique_lock<std::recursive_mutex> SqliteSampleBlockFactory::LockWrites()
+{
+   if (auto &pConnection = mppConnection->mpConnection)
+      return pConnection->LockWrites();
+   return {};
+}
+
+void SqliteSampleBlockFactory::CheckWritable()
+{
+   // Edits that make new samples fail here, before anything changes, and
+   // not later with an error from the database
+   auto &pConnection = mppConnection->mpConnection;
+   if (pConnection && pConnection->IsReadOnly())
+      throw SimpleMessageBoxException
+      {
+         ExceptionType::BadUserAction,
+         XO("This project was opened from a read-only file, so its audio "
+            "can't be changed.\nUse Save Project As to make a copy that can "
+            "be."),
+         XO("Read-only Project")
+      };
+}
+
+bool SqliteSampleBlockFactory::CommitBatch()
+{
+   return !mBatchTransaction || mBatchTransaction->Commit();
+}
+
+void SqliteSampleBlockFactory::OnInserted()
+{
+   // Called with the write lock held.  Other threads, such as recording,
+   // can't insert while the batch transaction is open; they insert alone
+   // after it ends.
+   if (!mBatchTransaction || std::this_thread::get_id() != mBatchThread)
+      return;
+   if (++mBatchRows < BatchRows)
+      return;
+
+   if (!CommitBatch())
+      // Just showing the user a simple message, not the library error too
+      // which isn't internationalized
+      mppConnection->mpConnection->ThrowException( true );
+   mBatchTransaction.reset();
+   mBatchTransaction.emplace(mProject, "SampleBlockBatch");
+   mBatchRows = 0;
+}
+
 SampleBlockPtr SqliteSampleBlockFactory::DoCreate(
    constSamplePtr src, size_t numsamples, sampleFormat srcformat )
 {
+   CheckWritable();
    auto sb = std::make_shared<SqliteSampleBlock>(shared_from_this());
    sb->SetSamples(src, numsamples, srcformat);
    // block id has now been assigned
@@ -316,15 +622,23 @@ SqliteSampleBlock::~SqliteSampleBlock()
       return;
    }
 
+   // The row id may be reused by the database after deletion
+   SqliteSampleBlockFactory::Cache().Erase({ mpFactory.get(), mBlockID });
+
    // See ProjectFileIO::Bypass() for a description of mIO.mBypass
    GuardedCall( [this]{
-      if (!mLocked && !Conn()->ShouldBypass())
+      if (!mLocked && !Conn()->ShouldBypass() && !Conn()->IsReadOnly())
       {
          // In case Delete throws, don't let an exception escape a destructor,
          // but we can still enqueue the delayed handler so that an error message
          // is presented to the user.
          // The failure in this case may be a less harmful waste of space in the
          // database, which should not cause aborting of the attempted edit.
+         // Don't let a deferred write store summaries after the row is
+         // deleted, and its id is maybe reused.
+         auto writeLock = Conn()->LockWrites();
+         if (mpPendingSummary)
+            mpPendingSummary->cancelled = true;
          Delete();
       }
    } );
@@ -379,16 +693,53 @@ size_t SqliteSampleBlock::DoGetSamples(samplePtr dest,
       return numsamples;
    }
 
+   size_t copied = 0;
+   VisitSamples([&](constSamplePtr src, size_t blobbytes){
+      copied = CopyBlob(dest,
+                  destformat,
+                  src,
+                  blobbytes,
+                  mSampleFormat,
+                  sampleoffset * SAMPLE_SIZE(mSampleFormat),
+                  numsamples * SAMPLE_SIZE(mSampleFormat));
+   });
+   return copied / SAMPLE_SIZE(mSampleFormat);
+}
+
+void SqliteSampleBlock::VisitSamples(
+   const std::function<void(constSamplePtr src, size_t blobbytes)> &visitor)
+{
+   // When read-only, the operating system already caches pages of the mapped
+   // file.  Other threads, such as audio playback, must not contend for the
+   // cache or allocate into it.
+   if (Conn()->IsReadOnly() || !wxIsMainThread()) {
+      sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::GetSamples,
+         "SELECT samples FROM sampleblocks WHERE blockid = ?1;");
+      VisitBlob(stmt, visitor);
+      return;
+   }
+
+   const auto blob = GetSamplesBlob();
+   visitor(blob->data(), blob->size());
+}
+
+SampleBlockCache::Blob SqliteSampleBlock::GetSamplesBlob()
+{
+   auto &cache = SqliteSampleBlockFactory::Cache();
+   const SampleBlockCache::Key key{ mpFactory.get(), mBlockID };
+   if (auto blob = cache.Find(key))
+      return blob;
+
    // Prepare and cache statement...automatically finalized at DB close
    sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::GetSamples,
       "SELECT samples FROM sampleblocks WHERE blockid = ?1;");
 
-   return GetBlob(dest,
-                  destformat,
-                  stmt,
-                  mSampleFormat,
-                  sampleoffset * SAMPLE_SIZE(mSampleFormat),
-                  numsamples * SAMPLE_SIZE(mSampleFormat)) / SAMPLE_SIZE(mSampleFormat);
+   std::shared_ptr<std::vector<char>> blob;
+   VisitBlob(stmt, [&](constSamplePtr src, size_t blobbytes){
+      blob = std::make_shared<std::vector<char>>(src, src + blobbytes);
+   });
+   cache.Insert(key, blob);
+   return blob;
 }
 
 void SqliteSampleBlock::SetSamples(constSamplePtr src,
@@ -399,9 +750,97 @@ void SqliteSampleBlock::SetSamples(constSamplePtr src,
    mSamples.reinit(mSampleBytes);
    memcpy(mSamples.get(), src, mSampleBytes);
 
-   CalcSummary( sizes );
+   // Store the samples now, so that the block id is known, but don't make
+   // recording or importing wait for the summaries
+   Commit();
+
+   ScheduleSummary( sizes );
+}
+
+void SqliteSampleBlock::ScheduleSummary(Sizes sizes)
+{
+   const auto pConn = Conn();
+   const auto pSummary = mpPendingSummary = std::make_shared<PendingSummary>();
+   pSummary->sizes = sizes;
+   pSummary->samples = std::move(mSamples);
+   pConn->BeginDeferredWrite();
+   // The task does not use this object
+   mSummaryReady = ThreadPool::Get().Submit(
+   [pConn, pSummary, id = mBlockID, format = mSampleFormat,
+      count = mSampleCount]{
+      bool deferred = false;
+      auto cleanup = finally([&]{
+         // If calculation fails, there is nothing to write
+         if (!deferred)
+            pConn->EndDeferredWrite();
+      });
+
+      ArrayOf<char> summary256, summary64k;
+      const auto totals = CalcSummary(pSummary->samples.get(), format, count,
+         pSummary->sizes, summary256, summary64k);
+      pSummary->samples.reset();
+      {
+         std::lock_guard<std::mutex> lock{ pSummary->mutex };
+         pSummary->summary256 = std::move(summary256);
+         pSummary->summary64k = std::move(summary64k);
+      }
+
+      // The writer thread of the connection stores summaries of many blocks
+      // together.  If that fails, the user is told, and the summaries stay
+      // in memory; the row keeps null summaries, which Load() calculates
+      // again.
+      pConn->DeferWrite([pConn, pSummary, id, totals]{
+         if (pSummary->cancelled)
+            return;
+         CommitSummary(*pConn, id, totals, *pSummary);
+         std::lock_guard<std::mutex> lock{ pSummary->mutex };
+         pSummary->summary256.reset();
+         pSummary->summary64k.reset();
+      });
+      deferred = true;
+      return totals;
+   }).share();
+}
 
-   Commit( sizes );
+void SqliteSampleBlock::WaitForSummary() const
+{
+   if (mSummaryReady.valid())
+      mSummaryReady.wait();
+}
+
+auto SqliteSampleBlock::GetTotals() const -> Totals
+{
+   if (mSummaryReady.valid())
+      return mSummaryReady.get();
+   return { mSumMin, mSumMax, mSumRms,
+      mSumTotal.load(std::memory_order_relaxed) };
+}
+
+void SqliteSampleBlock::RecoverSummary()
+{
+   // Perhaps the program stopped before a worker stored the summaries
+   sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::GetSamples,
+      "SELECT samples FROM sampleblocks WHERE blockid = ?1;");
+   auto pSummary = std::make_shared<PendingSummary>();
+   pSummary->sizes = SetSizes(mSampleCount, mSampleFormat);
+   VisitBlob(stmt, [&](constSamplePtr src, size_t){
+      const auto totals = CalcSummary(src, mSampleFormat, mSampleCount,
+         pSummary->sizes, pSummary->summary256, pSummary->summary64k);
+      mSumMin = totals.min;
+      mSumMax = totals.max;
+      mSumRms = totals.rms;
+      mSumTotal.store(totals.sum, std::memory_order_relaxed);
+   });
+
+   try {
+      auto writeLock = Conn()->LockWrites();
+      CommitSummary(*Conn(), mBlockID, GetTotals(), *pSummary);
+   }
+   catch ( const AudacityException & ) {
+      // The database might not be writable; then keep the summaries in
+      // memory for drawing
+      mpPendingSummary = std::move(pSummary);
+   }
 }
 
 bool SqliteSampleBlock::GetSummary256(float *dest,
@@ -428,6 +867,24 @@ bool SqliteSampleBlock::GetSummary(float *dest,
 {
    // Non-throwing, it returns true for success
    bool silent = IsSilent();
+   WaitForSummary();
+   if (!silent && mpPendingSummary) {
+      // Summaries might not be stored yet
+      auto &summary = *mpPendingSummary;
+      std::lock_guard<std::mutex> lock{ summary.mutex };
+      const bool is256 = (id == DBConnection::GetSummary256);
+      const auto &array = is256 ? summary.summary256 : summary.summary64k;
+      if (array) {
+         CopyBlob(dest,
+            floatSample,
+            array.get(),
+            is256 ? summary.sizes.first : summary.sizes.second,
+            floatSample,
+            frameoffset * fields * SAMPLE_SIZE(floatSample),
+            numframes * fields * SAMPLE_SIZE(floatSample));
+         return true;
+      }
+   }
    if (!silent) {
       // Not a silent block
       try {
@@ -453,17 +910,17 @@ bool SqliteSampleBlock::GetSummary(float *dest,
 
 double SqliteSampleBlock::GetSumMin() const
 {
-   return mSumMin;
+   return GetTotals().min;
 }
 
 double SqliteSampleBlock::GetSumMax() const
 {
-   return mSumMax;
+   return GetTotals().max;
 }
 
 double SqliteSampleBlock::GetSumRms() const
 {
-   return mSumRms;
+   return GetTotals().rms;
 }
 
 /// Retrieves the minimum, maximum, and maximum RMS of the
@@ -485,7 +942,22 @@ MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS(size_t start, size_t len)
       Load(mBlockID);
    }
 
-   if (start < mSampleCount)
+   if (start < mSampleCount && mSampleFormat == floatSample)
+   {
+      len = std::min(len, mSampleCount - start);
+
+      // Examine the stored samples in place
+      VisitSamples([&](constSamplePtr src, size_t blobbytes){
+         const auto count = std::min(blobbytes / sizeof(float), start + len);
+         const auto stats = count > start
+            ? ComputeMinMaxSumSq((const float *)src + start, count - start)
+            : MinMaxSumSq{};
+         min = stats.min;
+         max = stats.max;
+         sumsq = stats.sumsq;
+      });
+   }
+   else if (start < mSampleCount)
    {
       len = std::min(len, mSampleCount - start);
 
@@ -494,22 +966,10 @@ MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS(size_t start, size_t len)
       float *samples = (float *) blockData.ptr();
 
       size_t copied = DoGetSamples((samplePtr) samples, floatSample, start, len);
-      for (size_t i = 0; i < copied; ++i, ++samples)
-      {
-         float sample = *samples;
-
-         if (sample > max)
-         {
-            max = sample;
-         }
-
-         if (sample < min)
-         {
-            min = sample;
-         }
-
-         sumsq += (sample * sample);
-      }
+      const auto stats = ComputeMinMaxSumSq(samples, copied);
+      min = stats.min;
+      max = stats.max;
+      sumsq = stats.sumsq;
    }
 
    return { min, max, (float) sqrt(sumsq / len) };
@@ -520,7 +980,68 @@ MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS(size_t start, size_t len)
 /// these values are already computed.
 MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS() const
 {
-   return { (float) mSumMin, (float) mSumMax, (float) mSumRms };
+   const auto totals = GetTotals();
+   return { (float) totals.min, (float) totals.max, (float) totals.rms };
+}
+
+/// Retrieves the sum of the specified sample data in this block.
+///
+/// @param start The offset in this block where the region should begin
+/// @param len   The number of samples to include in the region
+double SqliteSampleBlock::DoGetSum(size_t start, size_t len)
+{
+   if (IsSilent())
+      return 0;
+
+   if (!mValid)
+   {
+      Load(mBlockID);
+   }
+
+   double sum = 0;
+   if (start < mSampleCount && mSampleFormat == floatSample)
+   {
+      len = std::min(len, mSampleCount - start);
+
+      // Examine the stored samples in place
+      VisitSamples([&](constSamplePtr src, size_t blobbytes){
+         const auto count = std::min(blobbytes / sizeof(float), start + len);
+         if (count > start)
+            sum = ComputeSum((const float *)src + start, count - start);
+      });
+   }
+   else if (start < mSampleCount)
+   {
+      len = std::min(len, mSampleCount - start);
+
+      SampleBuffer blockData(len, floatSample);
+      float *samples = (float *) blockData.ptr();
+
+      size_t copied = DoGetSamples((samplePtr) samples, floatSample, start, len);
+      sum = ComputeSum(samples, copied);
+   }
+
+   return sum;
+}
+
+/// Retrieves the sum of this entire block, reading the samples only the
+/// first time if they were not summarized in this session.
+double SqliteSampleBlock::DoGetSum()
+{
+   if (IsSilent())
+      return 0;
+
+   auto sum = GetTotals().sum;
+   if (std::isnan(sum))
+   {
+      if (!mValid)
+      {
+         Load(mBlockID);
+      }
+      sum = DoGetSum(0, mSampleCount);
+      mSumTotal.store(sum, std::memory_order_relaxed);
+   }
+   return sum;
 }
 
 size_t SqliteSampleBlock::GetSpaceUsage() const
@@ -537,6 +1058,17 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
                                   sampleFormat srcformat,
                                   size_t srcoffset,
                                   size_t srcbytes)
+{
+   size_t result = 0;
+   VisitBlob(stmt, [&](constSamplePtr src, size_t blobbytes){
+      result = CopyBlob(dest, destformat, src, blobbytes,
+         srcformat, srcoffset, srcbytes);
+   });
+   return result;
+}
+
+void SqliteSampleBlock::VisitBlob(sqlite3_stmt *stmt,
+   const std::function<void(constSamplePtr src, size_t blobbytes)> &visitor)
 {
    auto db = DB();
 
@@ -548,7 +1080,6 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
    }
 
    int rc;
-   size_t minbytes = 0;
 
    // Bind statement parameters
    // Might return SQLITE_MISUSE which means it's our mistake that we violated
@@ -588,16 +1119,29 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
    }
 
    // Retrieve returned data
-   samplePtr src = (samplePtr) sqlite3_column_blob(stmt, 0);
+   auto src = (constSamplePtr) sqlite3_column_blob(stmt, 0);
    size_t blobbytes = (size_t) sqlite3_column_bytes(stmt, 0);
 
-   srcoffset = std::min(srcoffset, blobbytes);
-   minbytes = std::min(srcbytes, blobbytes - srcoffset);
+   // Don't let an exception from the visitor leave the statement unreset
+   auto cleanup = finally([stmt]{
+      // Clear statement bindings and rewind statement
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+   });
 
-   if (srcoffset != 0)
-   {
-      srcoffset += 0;
-   }
+   visitor(src, blobbytes);
+}
+
+size_t SqliteSampleBlock::CopyBlob(void *dest,
+                                  sampleFormat destformat,
+                                  constSamplePtr src,
+                                  size_t blobbytes,
+                                  sampleFormat srcformat,
+                                  size_t srcoffset,
+                                  size_t srcbytes)
+{
+   srcoffset = std::min(srcoffset, blobbytes);
+   const auto minbytes = std::min(srcbytes, blobbytes - srcoffset);
 
    /*
     Will dithering happen in CopySamples?  Answering this as of 3.0.3 by
@@ -648,10 +1192,6 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
       memset(dest, 0, srcbytes - minbytes);
    }
 
-   // Clear statement bindings and rewind statement
-   sqlite3_clear_bindings(stmt);
-   sqlite3_reset(stmt);
-
    return srcbytes;
 }
 
@@ -668,11 +1208,13 @@ void SqliteSampleBlock::Load(SampleBlockID sbid)
    mSumMin = FLT_MAX;
    mSumMax = -FLT_MAX;
    mSumMin = 0.0;
+   mSumTotal.store(NAN, std::memory_order_relaxed);
 
    // Prepare and cache statement...automatically finalized at DB close
    sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::LoadSampleBlock,
       "SELECT sampleformat, summin, summax, sumrms,"
-      "       length(samples)"
+      "       length(samples), summary256 IS NULL,"
+      "       length(summary64k), substr(summary64k, -8)"
       "  FROM sampleblocks WHERE blockid = ?1;");
 
    // Bind statement parameters
@@ -715,22 +1257,36 @@ void SqliteSampleBlock::Load(SampleBlockID sbid)
    mSumRms = sqlite3_column_double(stmt, 3);
    mSampleBytes = sqlite3_column_int(stmt, 4);
    mSampleCount = mSampleBytes / SAMPLE_SIZE(mSampleFormat);
+   const bool noSummary = sqlite3_column_int(stmt, 5) != 0;
+   // The sum follows the frames of the 64k summary, if it was stored; older
+   // versions ignore it, and don't store it
+   if (sqlite3_column_int(stmt, 6) % bytesPerFrame == sizeof(double) &&
+       sqlite3_column_bytes(stmt, 7) == sizeof(double))
+   {
+      double sum;
+      memcpy(&sum, sqlite3_column_blob(stmt, 7), sizeof(double));
+      mSumTotal.store(sum, std::memory_order_relaxed);
+   }
 
    // Clear statement bindings and rewind statement
    sqlite3_clear_bindings(stmt);
    sqlite3_reset(stmt);
 
    mValid = true;
+
+   if (noSummary && mSampleCount > 0)
+      RecoverSummary();
 }
 
-void SqliteSampleBlock::Commit(Sizes sizes)
+void SqliteSampleBlock::Commit()
 {
-   const auto mSummary256Bytes = sizes.first;
-   const auto mSummary64kBytes = sizes.second;
-
    auto db = DB();
    int rc;
 
+   // The row id is retrieved below, and a batch may be completed, before
+   // another thread can insert
+   auto writeLock = Conn()->LockWrites();
+
    // Prepare and cache statement...automatically finalized at DB close
    sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::InsertSampleBlock,
       "INSERT INTO sampleblocks (sampleformat, summin, summax, sumrms,"
@@ -740,12 +1296,14 @@ void SqliteSampleBlock::Commit(Sizes sizes)
    // Bind statement parameters
    // Might return SQLITE_MISUSE which means it's our mistake that we violated
    // preconditions; should return SQL_OK which is 0
+   // Summaries are not yet calculated, so bind NULL; CommitSummary() fills
+   // them in later
    if (sqlite3_bind_int(stmt, 1, mSampleFormat) ||
        sqlite3_bind_double(stmt, 2, mSumMin) ||
        sqlite3_bind_double(stmt, 3, mSumMax) ||
        sqlite3_bind_double(stmt, 4, mSumRms) ||
-       sqlite3_bind_blob(stmt, 5, mSummary256.get(), mSummary256Bytes, SQLITE_STATIC) ||
-       sqlite3_bind_blob(stmt, 6, mSummary64k.get(), mSummary64kBytes, SQLITE_STATIC) ||
+       sqlite3_bind_null(stmt, 5) ||
+       sqlite3_bind_null(stmt, 6) ||
        sqlite3_bind_blob(stmt, 7, mSamples.get(), mSampleBytes, SQLITE_STATIC))
    {
 
@@ -778,16 +1336,74 @@ void SqliteSampleBlock::Commit(Sizes sizes)
    // Retrieve returned data
    mBlockID = sqlite3_last_insert_rowid(db);
 
-   // Reset local arrays
-   mSamples.reset();
-   mSummary256.reset();
-   mSummary64k.reset();
-
    // Clear statement bindings and rewind statement
    sqlite3_clear_bindings(stmt);
    sqlite3_reset(stmt);
 
    mValid = true;
+
+   mpFactory->OnInserted();
+}
+
+void SqliteSampleBlock::CommitSummary(DBConnection &conn, SampleBlockID id,
+   const Totals &totals, const PendingSummary &summary)
+{
+   const auto mSummary256Bytes = summary.sizes.first;
+   const auto mSummary64kBytes = summary.sizes.second;
+
+   // Append the sum to the 64k summary, so that analysis of DC offset need
+   // not read the samples again; see Load()
+   ArrayOf<char> summary64k{ mSummary64kBytes + sizeof(double) };
+   memcpy(summary64k.get(), summary.summary64k.get(), mSummary64kBytes);
+   memcpy(summary64k.get() + mSummary64kBytes, &totals.sum, sizeof(double));
+
+   auto db = conn.DB();
+   int rc;
+
+   // Prepare and cache statement...automatically finalized at DB close
+   sqlite3_stmt *stmt = conn.Prepare(DBConnection::UpdateSampleBlockSummary,
+      "UPDATE sampleblocks SET summin = ?1, summax = ?2, sumrms = ?3,"
+      "                        summary256 = ?4, summary64k = ?5"
+      "                    WHERE blockid = ?6;");
+
+   // Bind statement parameters
+   // Might return SQLITE_MISUSE which means it's our mistake that we violated
+   // preconditions; should return SQL_OK which is 0
+   if (sqlite3_bind_double(stmt, 1, totals.min) ||
+       sqlite3_bind_double(stmt, 2, totals.max) ||
+       sqlite3_bind_double(stmt, 3, totals.rms) ||
+       sqlite3_bind_blob(stmt, 4, summary.summary256.get(), mSummary256Bytes, SQLITE_STATIC) ||
+       sqlite3_bind_blob(stmt, 5, summary64k.get(), mSummary64kBytes + sizeof(double), SQLITE_STATIC) ||
+       sqlite3_bind_int64(stmt, 6, id))
+   {
+      ADD_EXCEPTION_CONTEXT(
+         "sqlite3.rc", std::to_string(sqlite3_errcode(db)));
+      ADD_EXCEPTION_CONTEXT("sqlite3.context", "SqliteSampleBlock::CommitSummary::bind");
+
+      wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
+   }
+
+   // Execute the statement
+   rc = sqlite3_step(stmt);
+   if (rc != SQLITE_DONE)
+   {
+      ADD_EXCEPTION_CONTEXT("sqlite3.rc", std::to_string(rc));
+      ADD_EXCEPTION_CONTEXT("sqlite3.context", "SqliteSampleBlock::CommitSummary::step");
+
+      wxLogDebug(wxT("SqliteSampleBlock::CommitSummary - SQLITE error %s"), sqlite3_errmsg(db));
+
+      // Clear statement bindings and rewind statement
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+
+      // Just showing the user a simple message, not the library error too
+      // which isn't internationalized
+      conn.ThrowException( true );
+   }
+
+   // Clear statement bindings and rewind statement
+   sqlite3_clear_bindings(stmt);
+   sqlite3_reset(stmt);
 }
 
 void SqliteSampleBlock::Delete()
@@ -797,6 +1413,8 @@ void SqliteSampleBlock::Delete()
 
    wxASSERT(!IsSilent());
 
+   auto writeLock = Conn()->LockWrites();
+
    // Prepare and cache statement...automatically finalized at DB close
    sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::DeleteSampleBlock,
       "DELETE FROM sampleblocks WHERE blockid = ?1;");
@@ -853,36 +1471,38 @@ auto SqliteSampleBlock::SetSizes(
    return { frames256 * bytesPerFrame, frames64k * bytesPerFrame };
 }
 
-/// Calculates summary block data describing this sample data.
+/// Calculates summary block data describing sample data.
 ///
-/// This method also has the side effect of setting the mSumMin,
-/// mSumMax, and mSumRms members of this class.
+/// @return totals of all the samples
 ///
-void SqliteSampleBlock::CalcSummary(Sizes sizes)
+auto SqliteSampleBlock::CalcSummary(constSamplePtr src, sampleFormat format,
+   size_t count, Sizes sizes,
+   ArrayOf<char> &summary256Array, ArrayOf<char> &summary64kArray) -> Totals
 {
+   Totals totals;
+
    const auto mSummary256Bytes = sizes.first;
    const auto mSummary64kBytes = sizes.second;
 
    Floats samplebuffer;
-   float *samples;
+   const float *samples;
 
-   if (mSampleFormat == floatSample)
+   if (format == floatSample)
    {
-      samples = (float *) mSamples.get();
+      samples = (const float *) src;
    }
    else
    {
-      samplebuffer.reinit((unsigned) mSampleCount);
-      SamplesToFloats(mSamples.get(), mSampleFormat,
-         samplebuffer.get(), mSampleCount);
+      samplebuffer.reinit(count);
+      SamplesToFloats(src, format, samplebuffer.get(), count);
       samples = samplebuffer.get();
    }
    
-   mSummary256.reinit(mSummary256Bytes);
-   mSummary64k.reinit(mSummary64kBytes);
+   summary256Array.reinit(mSummary256Bytes);
+   summary64kArray.reinit(mSummary64kBytes);
 
-   float *summary256 = (float *) mSummary256.get();
-   float *summary64k = (float *) mSummary64k.get();
+   float *summary256 = (float *) summary256Array.get();
+   float *summary64k = (float *) summary64kArray.get();
 
    float min;
    float max;
@@ -891,36 +1511,22 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
    double fraction = 0.0;
 
    // Recalc 256 summaries
-   int sumLen = (mSampleCount + 255) / 256;
+   int sumLen = (count + 255) / 256;
    int summaries = 256;
 
    for (int i = 0; i < sumLen; ++i)
    {
-      min = samples[i * 256];
-      max = samples[i * 256];
-      sumsq = min * min;
-
       int jcount = 256;
-      if (jcount > mSampleCount - i * 256)
+      if (jcount > count - i * 256)
       {
-         jcount = mSampleCount - i * 256;
+         jcount = count - i * 256;
          fraction = 1.0 - (jcount / 256.0);
       }
 
-      for (int j = 1; j < jcount; ++j)
-      {
-         float f1 = samples[i * 256 + j];
-         sumsq += f1 * f1;
-
-         if (f1 < min)
-         {
-            min = f1;
-         }
-         else if (f1 > max)
-         {
-            max = f1;
-         }
-      }
+      const auto stats = ComputeMinMaxSumSq(samples + i * 256, jcount);
+      min = stats.min;
+      max = stats.max;
+      sumsq = stats.sumsq;
 
       totalSquares += sumsq;
 
@@ -942,10 +1548,11 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
    }
 
    // Calculate now while we can do it accurately
-   mSumRms = sqrt(totalSquares / mSampleCount);
+   totals.rms = sqrt(totalSquares / count);
+   totals.sum = ComputeSum(samples, count);
 
    // Recalc 64K summaries
-   sumLen = (mSampleCount + 65535) / 65536;
+   sumLen = (count + 65535) / 65536;
 
    for (int i = 0; i < sumLen; ++i)
    {
@@ -1007,8 +1614,9 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
       }
    }
 
-   mSumMin = min;
-   mSumMax = max;
+   totals.min = min;
+   totals.max = max;
+   return totals;
 }
 
 //! Just to find a denominator for a progress indicator.
@@ -0,0 +1,97 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SummaryPyramid.cpp
+  @brief Summaries of runs of whole blocks of a Sequence
+
+**********************************************************************/
+
+#include "SummaryPyramid.h"
+
+#include <algorithm>
+
+#include "SampleBlock.h"
+#include "Sequence.h"
+
+namespace {
+// Each level has a quarter as many nodes as the one below
+constexpr unsigned LevelShift = 2;
+constexpr size_t Fanout = 1 << LevelShift;
+
+MinMaxSumSq BlockStatistics(const SampleBlock &block)
+{
+   // Whole-block statistics are stored with the block, and cheap to get
+   const auto stats = block.GetMinMaxRMS(false);
+   const double count = block.GetSampleCount();
+   return { stats.min, stats.max, double(stats.RMS) * stats.RMS * count };
+}
+}
+
+void SummaryPyramid::Invalidate(size_t from)
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   mValid = std::min(mValid, from);
+}
+
+MinMaxSumSq SummaryPyramid::Query(
+   const BlockArray &blocks, size_t b0, size_t b1)
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   Update(blocks);
+
+   MinMaxSumSq result;
+   while (b0 < b1) {
+      // Take the highest node that starts at b0 and ends by b1
+      size_t level = 0;
+      while (level + 1 < mLevels.size()) {
+         const auto shift = (level + 1) * LevelShift;
+         if (b0 & ((size_t(1) << shift) - 1) ||
+             b0 + (size_t(1) << shift) > b1)
+            break;
+         ++level;
+      }
+      const auto shift = level * LevelShift;
+      result = Combine(result, mLevels[level][b0 >> shift]);
+      b0 += size_t(1) << shift;
+   }
+   return result;
+}
+
+void SummaryPyramid::Update(const BlockArray &blocks)
+{
+   const auto nBlocks = blocks.size();
+   if (mValid >= nBlocks && !mLevels.empty() && mLevels[0].size() == nBlocks)
+      return;
+   mValid = std::min(mValid, nBlocks);
+
+   if (mLevels.empty())
+      mLevels.emplace_back();
+   mLevels[0].resize(nBlocks);
+   auto iter = blocks.IteratorAt(mValid);
+   for (auto ii = mValid; ii < nBlocks; ++ii, ++iter)
+      mLevels[0][ii] = BlockStatistics(*iter->sb);
+
+   // Recompute only the nodes that depend on changed blocks
+   size_t level = 1;
+   for (auto from = mValid, size = nBlocks; size > 1; ++level) {
+      from >>= LevelShift;
+      size = (size + Fanout - 1) >> LevelShift;
+      if (mLevels.size() <= level)
+         mLevels.emplace_back();
+      const auto &below = mLevels[level - 1];
+      auto &nodes = mLevels[level];
+      nodes.resize(size);
+      for (auto ii = from; ii < size; ++ii) {
+         const auto first = ii << LevelShift;
+         const auto last = std::min(first + Fanout, below.size());
+         MinMaxSumSq node;
+         for (auto jj = first; jj < last; ++jj)
+            node = Combine(node, below[jj]);
+         nodes[ii] = node;
+      }
+   }
+   mLevels.resize(std::max<size_t>(1, level));
+
+   mValid = nBlocks;
+}
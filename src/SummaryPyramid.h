@@ -0,0 +1,50 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SummaryPyramid.h
+  @brief Summaries of runs of whole blocks of a Sequence
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SUMMARY_PYRAMID__
+#define __AUDACITY_SUMMARY_PYRAMID__
+
+#include <mutex>
+#include <vector>
+
+#include "SampleStatistics.h"
+
+class BlockArray;
+
+//! Levels of statistics over the blocks of a Sequence
+/*!
+ Level zero has one node for each block; each node of a higher level
+ combines four consecutive nodes of the level below, up to a level with one
+ node.  So statistics of any run of whole blocks combine at most three nodes
+ at each level.
+
+ Nodes are recomputed lazily, only from the first block changed by an edit.
+ */
+class SummaryPyramid
+{
+public:
+   //! Note that the blocks at this index and after may have changed
+   void Invalidate(size_t from);
+
+   //! Statistics of the samples of blocks b0 up to but excluding b1
+   /*! @pre b0 <= b1 <= blocks.size() */
+   MinMaxSumSq Query(const BlockArray &blocks, size_t b0, size_t b1);
+
+private:
+   //! Recompute nodes for blocks from mValid on
+   /*! @pre mMutex is locked */
+   void Update(const BlockArray &blocks);
+
+   std::mutex mMutex;
+   std::vector<std::vector<MinMaxSumSq>> mLevels;
+   //! Count of leading blocks whose nodes, at all levels, are up to date
+   size_t mValid{ 0 };
+};
+
+#endif
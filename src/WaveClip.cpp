@@ -127,6 +127,13 @@ bool WaveClip::GetSamples(samplePtr buffer, sampleFormat format,
    return mSequence->Get(buffer, format, start + TimeToSamples(mTrimLeft), len, mayThrow);
 }
 
+bool WaveClip::IsQuieterThan(
+   sampleCount start, size_t len, double level) const
+{
+   return mSequence->IsQuieterThan(
+      start + TimeToSamples(mTrimLeft), len, level);
+}
+
 /*! @excsafety{Strong} */
 void WaveClip::SetSamples(constSamplePtr buffer, sampleFormat format,
                    sampleCount start, size_t len)
@@ -150,9 +157,21 @@ const BlockArray* WaveClip::GetSequenceBlockArray() const
 
 void WaveClip::MarkChanged() // NOFAIL-GUARANTEE
 {
+   PlayRegionChanged();
    Caches::ForEach( std::mem_fn( &WaveClipListener::MarkChanged ) );
 }
 
+void WaveClip::SetPlayRegionEpoch(PlayRegionEpoch pEpoch)
+{
+   mpPlayRegionEpoch = std::move(pEpoch);
+}
+
+void WaveClip::PlayRegionChanged() noexcept
+{
+   if (mpPlayRegionEpoch)
+      ++*mpPlayRegionEpoch;
+}
+
 std::pair<float, float> WaveClip::GetMinMax(
    double t0, double t1, bool mayThrow) const
 {
@@ -191,6 +210,23 @@ float WaveClip::GetRMS(double t0, double t1, bool mayThrow) const
    return mSequence->GetRMS(s0, s1-s0, mayThrow);
 }
 
+std::pair<double, sampleCount> WaveClip::GetSum(
+   double t0, double t1, bool mayThrow,
+   const std::function<void(size_t)> & progressReport) const
+{
+   if (t0 > t1) {
+      if (mayThrow)
+         THROW_INCONSISTENCY_EXCEPTION;
+      return { 0, 0 };
+   }
+
+   auto s0 = TimeToSequenceSamples(t0);
+   auto s1 = TimeToSequenceSamples(t1);
+
+   return {
+      mSequence->GetSum(s0, s1-s0, mayThrow, progressReport), s1 - s0 };
+}
+
 void WaveClip::ConvertToSampleFormat(sampleFormat format,
    const std::function<void(size_t)> & progressReport)
 {
@@ -214,13 +250,16 @@ void WaveClip::UpdateEnvelopeTrackLen()
 std::shared_ptr<SampleBlock> WaveClip::AppendNewBlock(
    samplePtr buffer, sampleFormat format, size_t len)
 {
-   return mSequence->AppendNewBlock( buffer, format, len );
+   auto result = mSequence->AppendNewBlock( buffer, format, len );
+   PlayRegionChanged();
+   return result;
 }
 
 /*! @excsafety{Strong} */
 void WaveClip::AppendSharedBlock(const std::shared_ptr<SampleBlock> &pBlock)
 {
    mSequence->AppendSharedBlock( pBlock );
+   PlayRegionChanged();
 }
 
 /*! @excsafety{Partial}
@@ -263,6 +302,20 @@ bool WaveClip::Append(constSamplePtr buffer, sampleFormat format,
       if (len == 0)
          break;
 
+      if (mAppendBufferLen == 0 && len >= blockSize &&
+          format == seqFormat && stride == 1) {
+         // Whole blocks in the sequence's format need no buffering; make
+         // them directly from the given samples
+         // use Strong-guarantee
+         mSequence->Append(buffer, seqFormat, blockSize);
+         result = true;
+
+         buffer += blockSize * SAMPLE_SIZE(format);
+         len -= blockSize;
+         blockSize = mSequence->GetIdealAppendLen();
+         continue;
+      }
+
       // use No-fail-guarantee for rest of this "for"
       wxASSERT(mAppendBufferLen <= maxBlockSize);
       auto toCopy = std::min(len, maxBlockSize - mAppendBufferLen);
@@ -361,8 +414,11 @@ bool WaveClip::HandleXMLTag(const std::string_view& tag, const AttributesList &a
 
 void WaveClip::HandleXMLEndTag(const std::string_view& tag)
 {
-   if (tag == "waveclip")
+   if (tag == "waveclip") {
       UpdateEnvelopeTrackLen();
+      // The sequence was read without the clip's knowledge
+      PlayRegionChanged();
+   }
 }
 
 XMLTagHandler *WaveClip::HandleXMLChild(const std::string_view& tag)
@@ -846,6 +902,7 @@ void WaveClip::Resample(int rate, BasicUI::ProgressDialog *progress)
       // Use No-fail-guarantee in these steps
       mSequence = std::move(newSequence);
       mRate = rate;
+      PlayRegionChanged();
       Caches::ForEach( std::mem_fn( &WaveClipListener::Invalidate ) );
    }
 }
@@ -936,6 +993,7 @@ sampleCount WaveClip::GetPlaySamplesCount() const
 void WaveClip::SetTrimLeft(double trim)
 {
     mTrimLeft = std::max(.0, trim);
+    PlayRegionChanged();
 }
 
 double WaveClip::GetTrimLeft() const noexcept
@@ -946,6 +1004,7 @@ double WaveClip::GetTrimLeft() const noexcept
 void WaveClip::SetTrimRight(double trim)
 {
     mTrimRight = std::max(.0, trim);
+    PlayRegionChanged();
 }
 
 double WaveClip::GetTrimRight() const noexcept
@@ -956,21 +1015,25 @@ double WaveClip::GetTrimRight() const noexcept
 void WaveClip::TrimLeft(double deltaTime)
 {
     mTrimLeft += deltaTime;
+    PlayRegionChanged();
 }
 
 void WaveClip::TrimRight(double deltaTime)
 {
     mTrimRight += deltaTime;
+    PlayRegionChanged();
 }
 
 void WaveClip::TrimLeftTo(double to)
 {
     mTrimLeft = std::clamp(to, GetSequenceStartTime(), GetPlayEndTime()) - GetSequenceStartTime();
+    PlayRegionChanged();
 }
 
 void WaveClip::TrimRightTo(double to)
 {
     mTrimRight = GetSequenceEndTime() - std::clamp(to, GetPlayStartTime(), GetSequenceEndTime());
+    PlayRegionChanged();
 }
 
 double WaveClip::GetSequenceStartTime() const noexcept
@@ -983,6 +1046,7 @@ void WaveClip::SetSequenceStartTime(double startTime)
 {
     mSequenceOffset = startTime;
     mEnvelope->SetOffset(startTime);
+    PlayRegionChanged();
 }
 
 double WaveClip::GetSequenceEndTime() const
@@ -21,6 +21,7 @@
 
 #include <wx/longlong.h>
 
+#include <atomic>
 #include <vector>
 #include <functional>
 
@@ -219,11 +220,25 @@ public:
    /*! @excsafety{No-fail} */
    void MarkChanged();
 
+   //! Counter that the clip increases whenever its play region may change
+   using PlayRegionEpoch = std::shared_ptr<std::atomic<size_t>>;
+   //! The track holding the clip shares its counter, to know when its cached
+   //! positions of clips are stale
+   void SetPlayRegionEpoch(PlayRegionEpoch pEpoch);
+
    /** Getting high-level data for screen display and clipping
     * calculations and Contrast */
    std::pair<float, float> GetMinMax(
       double t0, double t1, bool mayThrow = true) const;
    float GetRMS(double t0, double t1, bool mayThrow = true) const;
+   //! Whether summaries show all samples to be strictly between -level and
+   //! level; start is relative to the play start, as for GetSamples()
+   bool IsQuieterThan(sampleCount start, size_t len, double level) const;
+   //! Sum of samples between t0 and t1, and their number
+   /*! @param progressReport as for Sequence::GetSum() */
+   std::pair<double, sampleCount> GetSum(
+      double t0, double t1, bool mayThrow = true,
+      const std::function<void(size_t)> & progressReport = {}) const;
 
    /** Whenever you do an operation to the sequence that will change the number
     * of samples (that is, the length of the clip), you will want to call this
@@ -355,7 +370,11 @@ protected:
    bool mIsPlaceholder { false };
 
 private:
+   /*! @excsafety{No-fail} */
+   void PlayRegionChanged() noexcept;
+
    wxString mName;
+   PlayRegionEpoch mpPlayRegionEpoch;
 };
 
 #endif
@@ -40,6 +40,7 @@ from the project that will own the track.
 #include <float.h>
 #include <math.h>
 #include <algorithm>
+#include <limits>
 #include <optional>
 
 #include "float_cast.h"
@@ -169,7 +170,7 @@ WaveTrack::WaveTrack(const WaveTrack &orig, ProtectedCreationArg &&a)
    mLastdBRange = -1;
    mLegacyProjectFileOffset = 0;
    for (const auto &clip : orig.mClips)
-      mClips.push_back
+      InsertClip
          ( std::make_unique<WaveClip>( *clip, mpFactory, true ) );
 }
 
@@ -405,13 +406,106 @@ int WaveTrack::ZeroLevelYCoordinate(wxRect rect) const
       (int)((mDisplayMax / (mDisplayMax - mDisplayMin)) * rect.height);
 }
 
-template< typename Container >
-static Container MakeIntervals(const std::vector<WaveClipHolder> &clips)
+//! Snapshot of the play regions of the clips, sorted by start
+/*!
+ Lookups of the clips at a time, or overlapping a span of time, are
+ logarithmic in the number of clips, and need not examine every clip, even
+ when play regions overlap, because each entry also has the greatest end of the
+ entries up to it.
+ */
+struct WaveTrack::ClipIndex
+{
+   struct Entry {
+      WaveClip *pClip;
+      //! Where the clip was in mClips
+      size_t position;
+      double start, end;
+      //! Greatest end of this and earlier entries
+      double maxEnd;
+   };
+   using Entries = std::vector<Entry>;
+   using Range = IteratorRange<Entries::const_iterator>;
+
+   //! Entries of clips that may intersect the closed interval [t0, t1]
+   /*! Some others, ending before t0, may also be included; callers test each
+    clip */
+   Range Overlapping(double t0, double t1) const
+   {
+      const auto last = std::upper_bound(entries.begin(), entries.end(), t1,
+         [](double t, const Entry &entry){ return t < entry.start; });
+      const auto first = std::partition_point(entries.begin(), last,
+         [=](const Entry &entry){ return entry.maxEnd < t0; });
+      return { first, last };
+   }
+
+   //! Entries of clips that may contain some of the len samples of the track
+   //! from start
+   /*! Clips have the rate of the track, and times are widened by a sample at
+    each side, to allow for rounding of times to samples */
+   Range OverlappingSamples(sampleCount start, size_t len, int rate) const
+   {
+      return Overlapping(
+         (start - 1).as_double() / rate, (start + len + 1).as_double() / rate);
+   }
+
+   //! Value of mpClipsEpoch when made
+   size_t epoch;
+   Entries entries;
+};
+
+void WaveTrack::InsertClip(WaveClipHolder clip)
+{
+   clip->SetPlayRegionEpoch(mpClipsEpoch);
+   mClips.push_back(std::move(clip));
+   ++*mpClipsEpoch;
+}
+
+WaveClipHolder WaveTrack::EraseClip(WaveClipHolders::iterator it)
+{
+   auto result = std::move(*it); // Array stops owning the clip, before we shrink it
+   mClips.erase(it);
+   result->SetPlayRegionEpoch({});
+   ++*mpClipsEpoch;
+   return result;
+}
+
+auto WaveTrack::GetClipIndex() const -> std::shared_ptr<const ClipIndex>
+{
+   // The epoch is read first, so that a change of clips while the index is
+   // made leaves it stale, not wrong
+   const size_t epoch = *mpClipsEpoch;
+   if (auto pIndex = std::atomic_load(&mpClipIndex);
+       pIndex && pIndex->epoch == epoch)
+      return pIndex;
+
+   auto pIndex = std::make_shared<ClipIndex>();
+   pIndex->epoch = epoch;
+   auto &entries = pIndex->entries;
+   entries.reserve(mClips.size());
+   size_t position = 0;
+   for (const auto &clip : mClips)
+      entries.push_back({ clip.get(), position++,
+         clip->GetPlayStartTime(), clip->GetPlayEndTime(), 0 });
+   std::stable_sort(entries.begin(), entries.end(),
+      [](const ClipIndex::Entry &a, const ClipIndex::Entry &b)
+   { return a.start < b.start; });
+   auto maxEnd = -std::numeric_limits<double>::infinity();
+   for (auto &entry : entries)
+      entry.maxEnd = maxEnd = std::max(maxEnd, entry.end);
+
+   std::shared_ptr<const ClipIndex> result = std::move(pIndex);
+   std::atomic_store(&mpClipIndex, result);
+   return result;
+}
+
+template< typename Container, typename Entries >
+static Container MakeIntervals(
+   const Entries &entries, const std::vector<WaveClipHolder> &clips)
 {
    Container result;
-   for (const auto &clip: clips) {
-      result.emplace_back( clip->GetPlayStartTime(), clip->GetPlayEndTime(),
-         std::make_unique<WaveTrack::IntervalData>( clip ) );
+   for (const auto &entry: entries) {
+      result.emplace_back( entry.start, entry.end,
+         std::make_unique<WaveTrack::IntervalData>( clips[entry.position] ) );
    }
    return result;
 }
@@ -427,12 +521,12 @@ Track::Holder WaveTrack::PasteInto( AudacityProject &project ) const
 
 auto WaveTrack::GetIntervals() const -> ConstIntervals
 {
-   return MakeIntervals<ConstIntervals>( mClips );
+   return MakeIntervals<ConstIntervals>( GetClipIndex()->entries, mClips );
 }
 
 auto WaveTrack::GetIntervals() -> Intervals
 {
-   return MakeIntervals<Intervals>( mClips );
+   return MakeIntervals<Intervals>( GetClipIndex()->entries, mClips );
 }
 
 const WaveClip* WaveTrack::FindClipByName(const wxString& name) const
@@ -732,7 +826,7 @@ Track::Holder WaveTrack::Copy(double t0, double t1, bool forClipboard) const
          // Whole clip is in copy region
          //wxPrintf("copy: clip %i is in copy region\n", (int)clip);
 
-         newTrack->mClips.push_back
+         newTrack->InsertClip
             (std::make_unique<WaveClip>(*clip, mpFactory, ! forClipboard));
          WaveClip *const newClip = newTrack->mClips.back().get();
          newClip->Offset(-t0);
@@ -755,7 +849,7 @@ Track::Holder WaveTrack::Copy(double t0, double t1, bool forClipboard) const
          if (newClip->GetPlayStartTime() < 0)
             newClip->SetPlayStartTime(0);
 
-         newTrack->mClips.push_back(std::move(newClip)); // transfer ownership
+         newTrack->InsertClip(std::move(newClip)); // transfer ownership
       }
    }
 
@@ -773,7 +867,7 @@ Track::Holder WaveTrack::Copy(double t0, double t1, bool forClipboard) const
       placeholder->SetIsPlaceholder(true);
       placeholder->InsertSilence(0, (t1 - t0) - newTrack->GetEndTime());
       placeholder->Offset(newTrack->GetEndTime());
-      newTrack->mClips.push_back(std::move(placeholder)); // transfer ownership
+      newTrack->InsertClip(std::move(placeholder)); // transfer ownership
    }
 
    return result;
@@ -1208,11 +1302,8 @@ std::shared_ptr<WaveClip> WaveTrack::RemoveAndReturnClip(WaveClip* clip)
 {
    // Be clear about who owns the clip!!
    auto it = FindClip(mClips, clip);
-   if (it != mClips.end()) {
-      auto result = std::move(*it); // Array stops owning the clip, before we shrink it
-      mClips.erase(it);
-      return result;
-   }
+   if (it != mClips.end())
+      return EraseClip(it);
    else
       return {};
 }
@@ -1224,7 +1315,7 @@ bool WaveTrack::AddClip(const std::shared_ptr<WaveClip> &clip)
 
    // Uncomment the following line after we correct the problem of zero-length clips
    //if (CanInsertClip(clip))
-      mClips.push_back(clip); // transfer ownership
+      InsertClip(clip); // transfer ownership
 
    return true;
 }
@@ -1354,13 +1445,13 @@ void WaveTrack::HandleClear(double t0, double t1,
    {
       auto myIt = FindClip(mClips, clip);
       if (myIt != mClips.end())
-         mClips.erase(myIt); // deletes the clip!
+         EraseClip(myIt); // deletes the clip!
       else
          wxASSERT(false);
    }
 
    for (auto &clip: clipsToAdd)
-      mClips.push_back(std::move(clip)); // transfer ownership
+      InsertClip(std::move(clip)); // transfer ownership
 }
 
 void WaveTrack::SyncLockAdjust(double oldT1, double newT1)
@@ -1554,7 +1645,7 @@ void WaveTrack::PasteWaveTrack(double t0, const WaveTrack* other)
                 newClip->SetName(MakeNewClipName());
             else
                 newClip->SetName(MakeClipCopyName(clip->GetName()));
-            mClips.push_back(std::move(newClip)); // transfer ownership
+            InsertClip(std::move(newClip)); // transfer ownership
         }
     }
 }
@@ -1609,7 +1700,7 @@ void WaveTrack::InsertSilence(double t, double len)
       auto clip = std::make_unique<WaveClip>(mpFactory, mFormat, mRate, this->GetWaveColorIndex());
       clip->InsertSilence(0, len);
       // use No-fail-guarantee
-      mClips.push_back( std::move( clip ) );
+      InsertClip( std::move( clip ) );
       return;
    }
    else {
@@ -1756,7 +1847,7 @@ void WaveTrack::Join(double t0, double t1)
       t = newClip->GetPlayEndTime();
 
       auto it = FindClip(mClips, clip);
-      mClips.erase(it); // deletes the clip
+      EraseClip(it); // deletes the clip
    }
 }
 
@@ -1994,42 +2085,16 @@ bool WaveTrack::CloseLock()
 
 double WaveTrack::GetStartTime() const
 {
-   bool found = false;
-   double best = 0.0;
-
-   if (mClips.empty())
-      return 0;
-
-   for (const auto &clip : mClips)
-      if (!found)
-      {
-         found = true;
-         best = clip->GetPlayStartTime();
-      }
-      else if (clip->GetPlayStartTime() < best)
-         best = clip->GetPlayStartTime();
-
-   return best;
+   const auto pIndex = GetClipIndex();
+   const auto &entries = pIndex->entries;
+   return entries.empty() ? 0 : entries.front().start;
 }
 
 double WaveTrack::GetEndTime() const
 {
-   bool found = false;
-   double best = 0.0;
-
-   if (mClips.empty())
-      return 0;
-
-   for (const auto &clip : mClips)
-      if (!found)
-      {
-         found = true;
-         best = clip->GetPlayEndTime();
-      }
-      else if (clip->GetPlayEndTime() > best)
-         best = clip->GetPlayEndTime();
-
-   return best;
+   const auto pIndex = GetClipIndex();
+   const auto &entries = pIndex->entries;
+   return entries.empty() ? 0 : entries.back().maxEnd;
 }
 
 //
@@ -2055,9 +2120,11 @@ std::pair<float, float> WaveTrack::GetMinMax(
    if (t0 == t1)
       return results;
 
-   for (const auto &clip: mClips)
+   const auto pIndex = GetClipIndex();
+   for (const auto &entry: pIndex->Overlapping(t0, t1))
    {
-      if (t1 >= clip->GetPlayStartTime() && t0 <= clip->GetPlayEndTime())
+      const auto clip = entry.pClip;
+      if (t1 >= entry.start && t0 <= entry.end)
       {
          clipFound = true;
          auto clipResults = clip->GetMinMax(t0, t1, mayThrow);
@@ -2090,15 +2157,17 @@ float WaveTrack::GetRMS(double t0, double t1, bool mayThrow) const
    double sumsq = 0.0;
    sampleCount length = 0;
 
-   for (const auto &clip: mClips)
+   const auto pIndex = GetClipIndex();
+   for (const auto &entry: pIndex->Overlapping(t0, t1))
    {
+      const auto clip = entry.pClip;
       // If t1 == clip->GetStartTime() or t0 == clip->GetEndTime(), then the clip
       // is not inside the selection, so we don't want it.
       // if (t1 >= clip->GetStartTime() && t0 <= clip->GetEndTime())
-      if (t1 >= clip->GetPlayStartTime() && t0 <= clip->GetPlayEndTime())
+      if (t1 >= entry.start && t0 <= entry.end)
       {
-         auto clipStart = clip->TimeToSequenceSamples(wxMax(t0, clip->GetPlayStartTime()));
-         auto clipEnd = clip->TimeToSequenceSamples(wxMin(t1, clip->GetPlayEndTime()));
+         auto clipStart = clip->TimeToSequenceSamples(wxMax(t0, entry.start));
+         auto clipEnd = clip->TimeToSequenceSamples(wxMin(t1, entry.end));
 
          float cliprms = clip->GetRMS(t0, t1, mayThrow);
 
@@ -2109,6 +2178,55 @@ float WaveTrack::GetRMS(double t0, double t1, bool mayThrow) const
    return length > 0 ? sqrt(sumsq / length.as_double()) : 0.0;
 }
 
+bool WaveTrack::IsQuieterThan(
+   sampleCount start, size_t len, double level) const
+{
+   // Space between clips is silent; examine only the overlaps with clips
+   const auto pIndex = GetClipIndex();
+   for (const auto &entry: pIndex->OverlappingSamples(start, len, mRate))
+   {
+      const auto clip = entry.pClip;
+      const auto clipStart = clip->GetPlayStartSample();
+      const auto clipEnd = clip->GetPlayEndSample();
+      const auto s0 = std::max(start, clipStart);
+      const auto s1 = std::min(start + len, clipEnd);
+      if (s0 < s1 &&
+          !clip->IsQuieterThan(s0 - clipStart, (s1 - s0).as_size_t(), level))
+         return false;
+   }
+   return true;
+}
+
+double WaveTrack::GetSum(
+   double t0, double t1, sampleCount *pCount, bool mayThrow,
+   const std::function<void(size_t)> & progressReport) const
+{
+   if (pCount)
+      *pCount = 0;
+
+   if (t0 > t1) {
+      if (mayThrow)
+         THROW_INCONSISTENCY_EXCEPTION;
+      return 0;
+   }
+
+   double sum = 0;
+   const auto pIndex = GetClipIndex();
+   for (const auto &entry: pIndex->Overlapping(t0, t1))
+   {
+      if (t1 >= entry.start && t0 <= entry.end)
+      {
+         const auto result = entry.pClip->GetSum(
+            wxMax(t0, entry.start), wxMin(t1, entry.end), mayThrow,
+            progressReport);
+         sum += result.first;
+         if (pCount)
+            *pCount += result.second;
+      }
+   }
+   return sum;
+}
+
 bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
                     sampleCount start, size_t len, fillFormat fill,
                     bool mayThrow, sampleCount * pNumWithinClips) const
@@ -2119,8 +2237,11 @@ bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
    bool doClear = true;
    bool result = true;
    sampleCount samplesCopied = 0;
-   for (const auto &clip: mClips)
+   const auto pIndex = GetClipIndex();
+   const auto clips = pIndex->OverlappingSamples(start, len, mRate);
+   for (const auto &entry: clips)
    {
+      const auto clip = entry.pClip;
       if (start >= clip->GetPlayStartSample() && start+len <= clip->GetPlayEndSample())
       {
          doClear = false;
@@ -2146,9 +2267,11 @@ bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
       }
    }
 
-   // Iterate the clips.  They are not necessarily sorted by time.
-   for (const auto &clip: mClips)
+   // Iterate the clips that may overlap, in order of play start, so that
+   // where clips overlap, the later one prevails
+   for (const auto &entry: clips)
    {
+      const auto clip = entry.pClip;
       auto clipStart = clip->GetPlayStartSample();
       auto clipEnd = clip->GetPlayEndSample();
 
@@ -2195,8 +2318,10 @@ bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
 void WaveTrack::Set(constSamplePtr buffer, sampleFormat format,
                     sampleCount start, size_t len)
 {
-   for (const auto &clip: mClips)
+   const auto pIndex = GetClipIndex();
+   for (const auto &entry: pIndex->OverlappingSamples(start, len, mRate))
    {
+      const auto clip = entry.pClip;
       auto clipStart = clip->GetPlayStartSample();
       auto clipEnd = clip->GetPlayEndSample();
 
@@ -2244,9 +2369,8 @@ void WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
    // to initialize the entire buffer to a default value.
    //
    // This does mean that, in the cases where a usable clip is located, the buffer value will
-   // be set twice.  Unfortunately, there is no easy way around this since the clips are not
-   // stored in increasing time order.  If they were, we could just track the time as the
-   // buffer is filled.
+   // be set twice.  Only the clips that may intersect the span are visited, in order of
+   // play start.
    for (decltype(bufferLen) i = 0; i < bufferLen; i++)
    {
       buffer[i] = 1.0;
@@ -2255,11 +2379,13 @@ void WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
    double startTime = t0;
    auto tstep = 1.0 / mRate;
    double endTime = t0 + tstep * bufferLen;
-   for (const auto &clip: mClips)
+   const auto pIndex = GetClipIndex();
+   for (const auto &entry: pIndex->Overlapping(startTime, endTime))
    {
+      const auto clip = entry.pClip;
       // IF clip intersects startTime..endTime THEN...
-      auto dClipStartTime = clip->GetPlayStartTime();
-      auto dClipEndTime = clip->GetPlayEndTime();
+      auto dClipStartTime = entry.start;
+      auto dClipEndTime = entry.end;
       if ((dClipStartTime < endTime) && (dClipEndTime > startTime))
       {
          auto rbuf = buffer;
@@ -2302,13 +2428,15 @@ void WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
 
 WaveClip* WaveTrack::GetClipAtSample(sampleCount sample)
 {
-   for (const auto &clip: mClips)
+   const auto pIndex = GetClipIndex();
+   for (const auto &entry: pIndex->OverlappingSamples(sample, 1, mRate))
    {
+      const auto clip = entry.pClip;
       auto start = clip->GetPlayStartSample();
       auto len   = clip->GetPlaySamplesCount();
 
       if (sample >= start && sample < start + len)
-         return clip.get();
+         return clip;
    }
 
    return NULL;
@@ -2318,23 +2446,27 @@ WaveClip* WaveTrack::GetClipAtSample(sampleCount sample)
 // latter clip is returned.
 WaveClip* WaveTrack::GetClipAtTime(double time)
 {
-   
-   const auto clips = SortedClipArray();
-   auto p = std::find_if(clips.rbegin(), clips.rend(), [&] (WaveClip* const& clip) {
-      return time >= clip->GetPlayStartTime() && time <= clip->GetPlayEndTime(); });
+   const auto pIndex = GetClipIndex();
+   const auto &entries = pIndex->entries;
+   const auto clips = pIndex->Overlapping(time, time);
+   auto p = std::find_if(clips.rbegin(), clips.rend(), [&] (const ClipIndex::Entry &entry) {
+      return time >= entry.start && time <= entry.end; });
+   if (p == clips.rend())
+      return nullptr;
+   auto it = p.base() - 1;
 
    // When two clips are immediately next to each other, the GetPlayEndTime() of the first clip
    // and the GetPlayStartTime() of the second clip may not be exactly equal due to rounding errors.
    // If "time" is the end time of the first of two such clips, and the end time is slightly
    // less than the start time of the second clip, then the first rather than the
    // second clip is found by the above code. So correct this.
-   if (p != clips.rend() && p != clips.rbegin() &&
-      time == (*p)->GetPlayEndTime() &&
-      (*p)->SharesBoundaryWithNextClip(*(p-1))) {
-      p--;
+   if (it + 1 != entries.end() &&
+      time == it->end &&
+      it->pClip->SharesBoundaryWithNextClip((it + 1)->pClip)) {
+      ++it;
    }
 
-   return p != clips.rend() ? *p : nullptr;
+   return it->pClip;
 }
 
 Envelope* WaveTrack::GetEnvelopeAtTime(double time)
@@ -2360,7 +2492,7 @@ WaveClip* WaveTrack::CreateClip(double offset, const wxString& name)
    auto clip = std::make_unique<WaveClip>(mpFactory, mFormat, mRate, GetWaveColorIndex());
    clip->SetName(name);
    clip->SetSequenceStartTime(offset);
-   mClips.push_back(std::move(clip));
+   InsertClip(std::move(clip));
 
    return mClips.back().get();
 }
@@ -2535,7 +2667,7 @@ void WaveTrack::SplitAt(double t)
          
          // This could invalidate the iterators for the loop!  But we return
          // at once so it's okay
-         mClips.push_back(std::move(newClip)); // transfer ownership
+         InsertClip(std::move(newClip)); // transfer ownership
          return;
       }
    }
@@ -2693,7 +2825,7 @@ void WaveTrack::MergeClips(int clipidx1, int clipidx2)
    // use No-fail-guarantee for the rest
    // Delete second clip
    auto it = FindClip(mClips, clip2);
-   mClips.erase(it);
+   EraseClip(it);
 }
 
 /*! @excsafety{Weak} -- Partial completion may leave clips at differing sample rates!
@@ -2708,26 +2840,24 @@ void WaveTrack::Resample(int rate, BasicUI::ProgressDialog *progress)
 
 namespace {
    template < typename Cont1, typename Cont2 >
-   Cont1 FillSortedClipArray(const Cont2& mClips)
+   Cont1 FillSortedClipArray(const Cont2& entries)
    {
       Cont1 clips;
-      for (const auto &clip : mClips)
-         clips.push_back(clip.get());
-      std::sort(clips.begin(), clips.end(),
-         [](const WaveClip *a, const WaveClip *b)
-      { return a->GetPlayStartTime() < b->GetPlayStartTime(); });
+      clips.reserve(entries.size());
+      for (const auto &entry : entries)
+         clips.push_back(entry.pClip);
       return clips;
    }
 }
 
 WaveClipPointers WaveTrack::SortedClipArray()
 {
-   return FillSortedClipArray<WaveClipPointers>(mClips);
+   return FillSortedClipArray<WaveClipPointers>(GetClipIndex()->entries);
 }
 
 WaveClipConstPointers WaveTrack::SortedClipArray() const
 {
-   return FillSortedClipArray<WaveClipConstPointers>(mClips);
+   return FillSortedClipArray<WaveClipConstPointers>(GetClipIndex()->entries);
 }
 
 auto WaveTrack::AllClipsIterator::operator ++ () -> AllClipsIterator &
@@ -2785,6 +2915,16 @@ void InspectBlocks(const TrackList &tracks, BlockInspector inspector,
       const_cast<TrackList &>(tracks), std::move( inspector ), pIDs );
 }
 
+size_t BlockArrayMemoryUsage(
+   const TrackList &tracks, BlockArrayNodeSet &seen)
+{
+   size_t result = 0;
+   for (auto wt : tracks.Any< const WaveTrack >())
+      for (const auto &clip : wt->GetAllClips())
+         result += clip->GetSequenceBlockArray()->AccumulateMemoryUsage(seen);
+   return result;
+}
+
 #include "Project.h"
 #include "SampleBlock.h"
 static auto TrackFactoryFactory = []( AudacityProject &project ) {
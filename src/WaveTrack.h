@@ -279,6 +279,21 @@ private:
       double t0, double t1, bool mayThrow = true) const;
    // May assume precondition: t0 <= t1
    float GetRMS(double t0, double t1, bool mayThrow = true) const;
+   //! Whether summaries of sample blocks show that all samples from start
+   //! for len, including zeroes between clips, are strictly between -level
+   //! and level
+   /*! Reads no samples, but may be false for quiet samples near loud ones
+    @pre level > 0 */
+   bool IsQuieterThan(sampleCount start, size_t len, double level) const;
+   //! Sum of samples within clips between t0 and t1, as for DC offset
+   /*! Reads only the sample blocks partly in the range, after sums of whole
+    blocks are first calculated
+    @param pCount if not null, receives the number of samples summed
+    @param progressReport as for Sequence::GetSum() */
+   // May assume precondition: t0 <= t1
+   double GetSum(double t0, double t1,
+      sampleCount *pCount = nullptr, bool mayThrow = true,
+      const std::function<void(size_t)> & progressReport = {}) const;
 
    //
    // MM: We now have more than one sequence and envelope per track, so
@@ -575,6 +590,25 @@ private:
 
    void PasteWaveTrack(double t0, const WaveTrack* other);
 
+   //! Append to mClips, and let the clip report changes of its play region
+   void InsertClip(WaveClipHolder clip);
+   //! Remove from mClips, returning the clip, which is destroyed if the caller
+   //! discards it
+   WaveClipHolder EraseClip(WaveClipHolders::iterator it);
+
+   struct ClipIndex;
+   //! Clips sorted by play start, remade only when clips have changed
+   /*! The result is never modified, so threads may share it */
+   std::shared_ptr<const ClipIndex> GetClipIndex() const;
+
+   //! Increased when clips are added or removed, or their play regions may
+   //! have changed
+   std::shared_ptr<std::atomic<size_t>> mpClipsEpoch{
+      std::make_shared<std::atomic<size_t>>(0) };
+   //! Cache for GetClipIndex(), accessed with std::atomic_load and
+   //! std::atomic_store
+   mutable std::shared_ptr<const ClipIndex> mpClipIndex;
+
    SampleBlockFactoryPtr mpFactory;
 
    wxCriticalSection mFlushCriticalSection;
@@ -606,6 +640,15 @@ void VisitBlocks(TrackList &tracks, BlockVisitor visitor,
 void InspectBlocks(const TrackList &tracks,
    BlockInspector inspector, SampleBlockIDSet *pIDs = nullptr);
 
+struct BlockArrayNode;
+using BlockArrayNodeSet = std::unordered_set<const BlockArrayNode *>;
+
+// Bytes of memory of the block arrays of all clips of wave tracks, counting
+// only the tree nodes not already in the set, and accumulating those into the
+// set.  Nodes are shared among copies of tracks, as in undo history.
+size_t BlockArrayMemoryUsage(
+   const TrackList &tracks, BlockArrayNodeSet &seen);
+
 class ProjectRate;
 
 class AUDACITY_DLL_API WaveTrackFactory final
@@ -9,6 +9,7 @@ Max Maisel
 ***********************************************************************/
 
 #include "EBUR128.h"
+#include <algorithm>
 #include <cstring>
 
 EBUR128::EBUR128(double rate, size_t channels)
@@ -118,6 +119,80 @@ void EBUR128::NextSample()
    ++mSampleCount;
 }
 
+void EBUR128::ProcessSamples(const float *const *channels, size_t len)
+{
+   for(size_t offset = 0; offset < len;)
+   {
+      // Take samples up to the next place where NextSample() would add a
+      // block to the histogram or close the ring.
+      const size_t count = std::min({ len - offset,
+         mBlockOverlap - mBlockRingPos % mBlockOverlap,
+         mBlockSize - mBlockRingPos });
+      double *const power = &mBlockRingBuffer[mBlockRingPos];
+      size_t channel = 0;
+      if(mChannelCount == 2)
+      {
+         // Interleave the two independent recursions for stereo, so that
+         // the processor can overlap them.
+         Biquad hsf0 = mWeightingFilter[0][0], hsf1 = mWeightingFilter[1][0];
+         Biquad hpf0 = mWeightingFilter[0][1], hpf1 = mWeightingFilter[1][1];
+         const float *const x_in0 = channels[0] + offset;
+         const float *const x_in1 = channels[1] + offset;
+         for(size_t i = 0; i < count; ++i)
+         {
+            const double value0 = hpf0.ProcessOne(hsf0.ProcessOne(x_in0[i]));
+            const double value1 = hpf1.ProcessOne(hsf1.ProcessOne(x_in1[i]));
+            power[i] = value0 * value0 + value1 * value1;
+         }
+         mWeightingFilter[0][0] = hsf0;
+         mWeightingFilter[1][0] = hsf1;
+         mWeightingFilter[0][1] = hpf0;
+         mWeightingFilter[1][1] = hpf1;
+         channel = 2;
+      }
+      for(; channel < mChannelCount; ++channel)
+      {
+         // Filter with copies, which the compiler can keep in registers,
+         // because stores to the ring buffer can't alias them.
+         Biquad hsf = mWeightingFilter[channel][0];
+         Biquad hpf = mWeightingFilter[channel][1];
+         const float *const x_in = channels[channel] + offset;
+         if(channel == 0)
+            for(size_t i = 0; i < count; ++i)
+            {
+               const double value = hpf.ProcessOne(hsf.ProcessOne(x_in[i]));
+               power[i] = value * value;
+            }
+         else
+            // Add the power of additional channels, as in
+            // ProcessSampleFromChannel().
+            for(size_t i = 0; i < count; ++i)
+            {
+               const double value = hpf.ProcessOne(hsf.ProcessOne(x_in[i]));
+               power[i] += value * value;
+            }
+         mWeightingFilter[channel][0] = hsf;
+         mWeightingFilter[channel][1] = hpf;
+      }
+
+      // The same as NextSample(), count times
+      mBlockRingPos += count;
+      mBlockRingSize += count;
+      mSampleCount += count;
+      if(mBlockRingPos % mBlockOverlap == 0)
+      {
+         // A new full block of samples was submitted.
+         if(mBlockRingSize >= mBlockSize)
+            AddBlockToHistogram(mBlockSize);
+      }
+      // Close the ring.
+      if(mBlockRingPos == mBlockSize)
+         mBlockRingPos = 0;
+
+      offset += count;
+   }
+}
+
 double EBUR128::IntegrativeLoudness()
 {
    // EBU R128: z_i = mean square without root
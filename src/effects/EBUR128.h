@@ -30,6 +30,10 @@ public:
    void Initialize();
    void ProcessSampleFromChannel(float x_in, size_t channel);
    void NextSample();
+   /// Process len samples of each of the channels; the same as calling
+   /// ProcessSampleFromChannel() for every channel, then NextSample(),
+   /// len times, but faster.
+   void ProcessSamples(const float *const *channels, size_t len);
    double IntegrativeLoudness();
    inline double IntegrativeLoudnessToLUFS(double loudness)
       { return 10 * log10(loudness); }
@@ -18,6 +18,9 @@
 #include "Loudness.h"
 
 #include <math.h>
+#include <list>
+#include <optional>
+#include <vector>
 
 #include <wx/intl.h>
 #include <wx/simplebook.h>
@@ -25,8 +28,13 @@
 
 #include "Internat.h"
 #include "Prefs.h"
+#include "Project.h"
+#include "../ProjectFileIO.h"
 #include "../ProjectFileManager.h"
+#include "../SampleBlock.h"
+#include "../Sequence.h"
 #include "../ShuttleGui.h"
+#include "../WaveClip.h"
 #include "../WaveTrack.h"
 #include "../widgets/valnum.h"
 #include "../widgets/ProgressDialog.h"
@@ -58,6 +66,95 @@ const ComponentInterfaceSymbol EffectLoudness::Symbol
 
 namespace{ BuiltinEffectsModule::Registration< EffectLoudness > reg; }
 
+namespace {
+//! Identifies the samples that a loudness analysis reads: the range, and
+//! the sample blocks of the channels with the places of their clips
+using AnalysisKey = std::vector<long long>;
+
+AnalysisKey MakeAnalysisKey(TrackIterRange<WaveTrack> range,
+   sampleCount start, sampleCount end, double rate)
+{
+   AnalysisKey key{ start.as_long_long(), end.as_long_long(),
+      static_cast<long long>(rate * 1000),
+      static_cast<long long>(range.size()) };
+   for(auto channel : range)
+   {
+      const auto &clips = channel->GetClips();
+      key.push_back(static_cast<long long>(clips.size()));
+      for(const auto &clip : clips)
+      {
+         const auto &blocks = clip->GetSequence()->GetBlockArray();
+         key.insert(key.end(), {
+            clip->GetSequenceStartSample().as_long_long(),
+            clip->GetPlayStartSample().as_long_long(),
+            clip->GetPlayEndSample().as_long_long(),
+            static_cast<long long>(blocks.size()) });
+         for(const auto &block : blocks)
+            key.insert(key.end(),
+               { block.sb->GetBlockID(), block.start.as_long_long() });
+      }
+   }
+   return key;
+}
+
+//! Integrated loudness of recent analyses in one project, most recent
+//! first.  Block ids are unique only within a project.  Edits make new
+//! sample blocks, so a key can't match samples that have changed.
+struct LoudnessAnalyses final : ClientData::Base
+{
+   //! @return null if there is no project
+   /*! Analyses are forgotten when the project's database changes, as when
+    another file is opened into an empty project */
+   static LoudnessAnalyses *Get(const AudacityProject *pProject);
+
+   std::optional<double> Find(const AnalysisKey &key);
+   void Store(AnalysisKey key, double loudness);
+
+   FilePath mFileName;
+   std::list<std::pair<AnalysisKey, double>> mAnalyses;
+   static constexpr size_t MaxAnalyses = 16;
+};
+
+const AudacityProject::AttachedObjects::RegisteredFactory sAnalysesKey{
+   [](AudacityProject &) {
+      return std::make_unique<LoudnessAnalyses>();
+   }
+};
+
+LoudnessAnalyses *LoudnessAnalyses::Get(const AudacityProject *pProject)
+{
+   if(!pProject)
+      return nullptr;
+   auto &analyses = const_cast<AudacityProject *>(pProject)
+      ->AttachedObjects::Get<LoudnessAnalyses>(sAnalysesKey);
+   const auto &fileName = ProjectFileIO::Get(*pProject).GetFileName();
+   if(analyses.mFileName != fileName)
+   {
+      analyses.mFileName = fileName;
+      analyses.mAnalyses.clear();
+   }
+   return &analyses;
+}
+
+std::optional<double> LoudnessAnalyses::Find(const AnalysisKey &key)
+{
+   for(auto iter = mAnalyses.begin(); iter != mAnalyses.end(); ++iter)
+      if(iter->first == key)
+      {
+         mAnalyses.splice(mAnalyses.begin(), mAnalyses, iter);
+         return iter->second;
+      }
+   return {};
+}
+
+void LoudnessAnalyses::Store(AnalysisKey key, double loudness)
+{
+   mAnalyses.emplace_front(std::move(key), loudness);
+   if(mAnalyses.size() > MaxAnalyses)
+      mAnalyses.pop_back();
+}
+}
+
 EffectLoudness::EffectLoudness()
 {
    Parameters().Reset(*this);
@@ -140,15 +237,38 @@ bool EffectLoudness::Process(EffectInstance &, EffectSettings &)
 
       mProcStereo = range.size() > 1;
 
+      double loudness = 0;
       if(mNormalizeTo == kLoudness)
       {
-         mLoudnessProcessor.reset(safenew EBUR128(mCurRate, range.size()));
-         mLoudnessProcessor->Initialize();
-         if(!ProcessOne(range, true))
+         // Analysis of the same samples was done before, maybe for a
+         // different target level?
+         const auto pAnalyses = LoudnessAnalyses::Get(FindProject());
+         std::optional<AnalysisKey> key;
+         std::optional<double> cached;
+         if(pAnalyses && mCurT1 > mCurT0)
          {
-            // Processing failed -> abort
-            bGoodResult = false;
-            break;
+            key = MakeAnalysisKey(range, track->TimeToLongSamples(mCurT0),
+               track->TimeToLongSamples(mCurT1), mCurRate);
+            cached = pAnalyses->Find(*key);
+         }
+         if(cached)
+         {
+            loudness = *cached;
+            mSteps = 1;
+         }
+         else
+         {
+            mLoudnessProcessor.reset(safenew EBUR128(mCurRate, range.size()));
+            mLoudnessProcessor->Initialize();
+            if(!ProcessOne(range, true))
+            {
+               // Processing failed -> abort
+               bGoodResult = false;
+               break;
+            }
+            loudness = mLoudnessProcessor->IntegrativeLoudness();
+            if(key)
+               pAnalyses->Store(std::move(*key), loudness);
          }
       }
       else // RMS
@@ -169,7 +289,7 @@ bool EffectLoudness::Process(EffectInstance &, EffectSettings &)
       // Calculate normalization values the analysis results
       float extent;
       if(mNormalizeTo == kLoudness)
-         extent = mLoudnessProcessor->IntegrativeLoudness();
+         extent = loudness;
       else // RMS
       {
          extent = mRMS[0];
@@ -437,13 +557,9 @@ void EffectLoudness::LoadBufferBlock(TrackIterRange<WaveTrack> range,
 /// (for loudness).
 bool EffectLoudness::AnalyseBufferBlock()
 {
-   for(size_t i = 0; i < mTrackBufferLen; i++)
-   {
-      mLoudnessProcessor->ProcessSampleFromChannel(mTrackBuffer[0][i], 0);
-      if(mProcStereo)
-         mLoudnessProcessor->ProcessSampleFromChannel(mTrackBuffer[1][i], 1);
-      mLoudnessProcessor->NextSample();
-   }
+   const float *const channels[] =
+      { mTrackBuffer[0].get(), mTrackBuffer[1].get() };
+   mLoudnessProcessor->ProcessSamples(channels, mTrackBufferLen);
 
    if(!UpdateProgress())
       return false;
@@ -49,6 +49,7 @@
 #include "Prefs.h"
 #include "RealFFTf.h"
 #include "../SpectrumTransformer.h"
+#include "ThreadPool.h"
 
 #include "../WaveTrack.h"
 #include "../widgets/AudacityMessageBox.h"
@@ -283,7 +284,11 @@ public:
       FloatVector mGains;
    };
 
-   bool Process(TrackList &tracks, double mT0, double mT1);
+   //! @param pool segments of the tracks are transformed concurrently in it,
+   //! unless it has no threads, or when profiling
+   bool Process(TrackList &tracks, double mT0, double mT1, ThreadPool &pool);
+   bool ProcessTrack(WaveTrack &track, double mT0, double mT1,
+      ThreadPool &pool);
 
 protected:
    MyWindow &NthWindow(int nn) { return static_cast<MyWindow&>(Nth(nn)); }
@@ -301,6 +306,13 @@ private:
 
 private:
 
+   const eWindowFunctions mInWindowType;
+   const eWindowFunctions mOutWindowType;
+   const Settings &mSettings;
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+   const double mF0, mF1;
+#endif
+
    const bool mDoProfile;
 
    EffectNoiseReduction &mEffect;
@@ -324,6 +336,13 @@ private:
    unsigned  mNWindowsToExamine;
    unsigned  mCenter;
    unsigned  mHistoryLen;
+   //! Number of steps after which a window no longer affects gains of
+   //! later windows
+   unsigned  mReleaseReach;
+
+   //! Whether this transforms one of the segments of a track that are
+   //! done concurrently
+   bool      mIsSegment = false;
 
    // Following are for progress indicator only:
    unsigned  mProgressTrackCount = 0;
@@ -620,37 +639,12 @@ EffectNoiseReduction::Worker::MyWindow::~MyWindow()
 {
 }
 
-bool EffectNoiseReduction::Process(EffectInstance &, EffectSettings &)
+namespace {
+std::pair<eWindowFunctions, eWindowFunctions>
+WindowFunctions(int windowTypes)
 {
-   // This same code will either reduce noise or profile it
-
-   this->CopyInputTracks(); // Set up mOutputTracks.
-
-   auto track = * (mOutputTracks->Selected< const WaveTrack >()).begin();
-   if (!track)
-      return false;
-
-   // Initialize statistics if gathering them, or check for mismatched (advanced)
-   // settings if reducing noise.
-   if (mSettings->mDoProfile) {
-      size_t spectrumSize = 1 + mSettings->WindowSize() / 2;
-      mStatistics = std::make_unique<Statistics>
-         (spectrumSize, track->GetRate(), mSettings->mWindowTypes);
-   }
-   else if (mStatistics->mWindowSize != mSettings->WindowSize()) {
-      // possible only with advanced settings
-      ::Effect::MessageBox(
-         XO("You must specify the same window size for steps 1 and 2.") );
-      return false;
-   }
-   else if (mStatistics->mWindowTypes != mSettings->mWindowTypes) {
-      // A warning only
-      ::Effect::MessageBox(
-         XO("Warning: window types are not the same as for profiling.") );
-   }
-
    eWindowFunctions inWindowType, outWindowType;
-   switch (mSettings->mWindowTypes) {
+   switch (windowTypes) {
    case WT_RECTANGULAR_HANN:
       inWindowType = eWinFuncRectangular;
       outWindowType = eWinFuncHann;
@@ -678,13 +672,49 @@ bool EffectNoiseReduction::Process(EffectInstance &, EffectSettings &)
       inWindowType = outWindowType = eWinFuncHann;
       break;
    }
+   return { inWindowType, outWindowType };
+}
+} // namespace
+
+bool EffectNoiseReduction::Process(EffectInstance &, EffectSettings &)
+{
+   // This same code will either reduce noise or profile it
+
+   this->CopyInputTracks(); // Set up mOutputTracks.
+
+   auto track = * (mOutputTracks->Selected< const WaveTrack >()).begin();
+   if (!track)
+      return false;
+
+   // Initialize statistics if gathering them, or check for mismatched (advanced)
+   // settings if reducing noise.
+   if (mSettings->mDoProfile) {
+      size_t spectrumSize = 1 + mSettings->WindowSize() / 2;
+      mStatistics = std::make_unique<Statistics>
+         (spectrumSize, track->GetRate(), mSettings->mWindowTypes);
+   }
+   else if (mStatistics->mWindowSize != mSettings->WindowSize()) {
+      // possible only with advanced settings
+      ::Effect::MessageBox(
+         XO("You must specify the same window size for steps 1 and 2.") );
+      return false;
+   }
+   else if (mStatistics->mWindowTypes != mSettings->mWindowTypes) {
+      // A warning only
+      ::Effect::MessageBox(
+         XO("Warning: window types are not the same as for profiling.") );
+   }
+
+   const auto [inWindowType, outWindowType] =
+      WindowFunctions(mSettings->mWindowTypes);
    Worker worker{ inWindowType, outWindowType,
       *this, *mSettings, *mStatistics
 #ifdef EXPERIMENTAL_SPECTRAL_EDITING
       , mF0, mF1
 #endif
    };
-   bool bGoodResult = worker.Process(*mOutputTracks, mT0, mT1);
+   bool bGoodResult =
+      worker.Process(*mOutputTracks, mT0, mT1, ThreadPool::Get());
    if (mSettings->mDoProfile) {
       if (bGoodResult)
          mSettings->mDoProfile = false; // So that "repeat last effect" will reduce noise
@@ -695,50 +725,49 @@ bool EffectNoiseReduction::Process(EffectInstance &, EffectSettings &)
    return bGoodResult;
 }
 
+bool EffectNoiseReduction::ReduceNoise(
+   WaveTrack &noise, const std::vector<WaveTrack*> &channels,
+   ThreadPool &pool)
+{
+   const auto [inWindowType, outWindowType] =
+      WindowFunctions(mSettings->mWindowTypes);
+   const auto makeWorker = [&]{
+      return std::make_unique<Worker>(inWindowType, outWindowType,
+         *this, *mSettings, *mStatistics
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+         , mF0, mF1
+#endif
+      );
+   };
+
+   mSettings->mDoProfile = true;
+   mStatistics = std::make_unique<Statistics>(1 + mSettings->WindowSize() / 2,
+      noise.GetRate(), mSettings->mWindowTypes);
+   if (!makeWorker()->ProcessTrack(
+      noise, noise.GetStartTime(), noise.GetEndTime(), pool) ||
+      mStatistics->mTotalWindows == 0)
+      return false;
+
+   mSettings->mDoProfile = false;
+   const auto worker = makeWorker();
+   for (const auto pChannel : channels)
+      if (!worker->ProcessTrack(*pChannel,
+         pChannel->GetStartTime(), pChannel->GetEndTime(), pool))
+         return false;
+   return true;
+}
+
 EffectNoiseReduction::Worker::~Worker()
 {
 }
 
 bool EffectNoiseReduction::Worker::Process(
-   TrackList &tracks, double inT0, double inT1)
+   TrackList &tracks, double inT0, double inT1, ThreadPool &pool)
 {
    mProgressTrackCount = 0;
    for ( auto track : tracks.Selected< WaveTrack >() ) {
-      mProgressWindowCount = 0;
-      if (track->GetRate() != mStatistics.mRate) {
-         if (mDoProfile)
-            mEffect.Effect::MessageBox(
-               XO("All noise profile data must have the same sample rate.") );
-         else
-            mEffect.Effect::MessageBox(
-               XO(
-"The sample rate of the noise profile must match that of the sound to be processed.") );
+      if (!ProcessTrack(*track, inT0, inT1, pool))
          return false;
-      }
-
-      double trackStart = track->GetStartTime();
-      double trackEnd = track->GetEndTime();
-      double t0 = std::max(trackStart, inT0);
-      double t1 = std::min(trackEnd, inT1);
-
-      if (t1 > t0) {
-         auto start = track->TimeToLongSamples(t0);
-         auto end = track->TimeToLongSamples(t1);
-         const auto len = end - start;
-         mLen = len;
-         const auto extra = (mStepsPerWindow - 1) * mStepSize;
-         // Adjust denominator for presence or absence of padding,
-         // which makes the number of windows visited either more or less
-         // than the number of window steps in the data.
-         if (mDoProfile)
-            mLen -= extra;
-         else
-            mLen += extra;
-
-         if (!TrackSpectrumTransformer::Process(
-            Processor, track, mHistoryLen, start, len ))
-            return false;
-      }
       ++mProgressTrackCount;
    }
 
@@ -752,6 +781,78 @@ bool EffectNoiseReduction::Worker::Process(
    return true;
 }
 
+bool EffectNoiseReduction::Worker::ProcessTrack(
+   WaveTrack &track, double inT0, double inT1, ThreadPool &pool)
+{
+   mProgressWindowCount = 0;
+   if (track.GetRate() != mStatistics.mRate) {
+      if (mDoProfile)
+         mEffect.Effect::MessageBox(
+            XO("All noise profile data must have the same sample rate.") );
+      else
+         mEffect.Effect::MessageBox(
+            XO(
+"The sample rate of the noise profile must match that of the sound to be processed.") );
+      return false;
+   }
+
+   double trackStart = track.GetStartTime();
+   double trackEnd = track.GetEndTime();
+   double t0 = std::max(trackStart, inT0);
+   double t1 = std::min(trackEnd, inT1);
+
+   if (t1 > t0) {
+      auto start = track.TimeToLongSamples(t0);
+      auto end = track.TimeToLongSamples(t1);
+      const auto len = end - start;
+      mLen = len;
+      const auto extra = (mStepsPerWindow - 1) * mStepSize;
+      // Adjust denominator for presence or absence of padding,
+      // which makes the number of windows visited either more or less
+      // than the number of window steps in the data.
+      if (mDoProfile)
+         mLen -= extra;
+      else
+         mLen += extra;
+
+      if (mDoProfile || pool.GetNumThreads() == 0) {
+         if (!TrackSpectrumTransformer::Process(
+            Processor, &track, mHistoryLen, start, len ))
+            return false;
+      }
+      else {
+         // Gains of a window depend on windows at most mHistoryLen steps
+         // later, and on earlier windows only through the release decay,
+         // which reaches the floor after mReleaseReach steps.  The output
+         // of a step also depends on the mStepsPerWindow windows that
+         // overlap it.  So segments with that much extra input on each
+         // side, in separate workers, give the same samples as one pass.
+         const auto factory = [this]{
+            auto result = std::make_unique<Worker>(
+               mInWindowType, mOutWindowType, mEffect, mSettings,
+               mStatistics
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+               , mF0, mF1
+#endif
+            );
+            result->mIsSegment = true;
+            return result;
+         };
+         const auto progress = [this](double fraction){
+            return !mEffect.TrackProgress(mProgressTrackCount, fraction);
+         };
+         if (!TrackSpectrumTransformer::ProcessInSegments(
+            Processor, factory, &track, mHistoryLen, start, len,
+            mHistoryLen + mReleaseReach + 2 * mStepsPerWindow,
+            mHistoryLen + 2 * mStepsPerWindow,
+            pool, progress))
+            return false;
+      }
+   }
+
+   return true;
+}
+
 void EffectNoiseReduction::Worker::ApplyFreqSmoothing(FloatVector &gains)
 {
    // Given an array of gain mutipliers, average them
@@ -795,6 +896,12 @@ EffectNoiseReduction::Worker::Worker(eWindowFunctions inWindowType,
    settings.WindowSize(), settings.StepsPerWindow(),
    !settings.mDoProfile, !settings.mDoProfile
 }
+, mInWindowType{ inWindowType }
+, mOutWindowType{ outWindowType }
+, mSettings{ settings }
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+, mF0{ f0 }, mF1{ f1 }
+#endif
 , mDoProfile{ settings.mDoProfile }
 
 , mEffect{ effect }
@@ -836,6 +943,9 @@ EffectNoiseReduction::Worker::Worker(eWindowFunctions inWindowType,
    mOneBlockRelease = DB_TO_LINEAR(noiseGain / nReleaseBlocks);
    // Applies to power, divide by 10:
    mOldSensitivityFactor = pow(10.0, settings.mOldSensitivity / 10.0);
+   // Decay of gain reaches the attenuation factor after nReleaseBlocks steps;
+   // allow one more for rounding
+   mReleaseReach = nReleaseBlocks + 1;
 
    mNWindowsToExamine = (mMethod == DM_OLD_METHOD)
       ? std::max(2, (int)(minSignalTime * sampleRate / mStepSize))
@@ -891,6 +1001,10 @@ bool EffectNoiseReduction::Worker::Processor(SpectrumTransformer &transformer)
    else
       worker.ReduceNoise();
 
+   // Segments run in other threads; progress is updated between batches
+   if (worker.mIsSegment)
+      return true;
+
    // Update the Progress meter, let user cancel
    return !worker.mEffect.TrackProgress(worker.mProgressTrackCount,
       std::min(1.0,
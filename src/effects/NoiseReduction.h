@@ -15,6 +15,9 @@
 
 #include "Effect.h"
 
+class ThreadPool;
+class WaveTrack;
+
 class EffectNoiseReduction final : public StatefulEffect {
 public:
    static const ComponentInterfaceSymbol Symbol;
@@ -44,6 +47,16 @@ public:
 
    bool Process(EffectInstance &instance, EffectSettings &settings) override;
 
+   //! Profile the noise in one track, then reduce it in other tracks,
+   //! with the saved settings and without dialogs
+   /*!
+    @param pool segments of the channels are transformed concurrently in it,
+    unless it has no threads
+    @return false if the profile is too short or the rates differ
+    */
+   bool ReduceNoise(WaveTrack &noise, const std::vector<WaveTrack*> &channels,
+      ThreadPool &pool);
+
    class Settings;
    class Statistics;
    class Dialog;
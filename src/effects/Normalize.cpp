@@ -27,6 +27,7 @@
 #include <wx/valgen.h>
 
 #include "Prefs.h"
+#include "UserException.h"
 #include "../ProjectFileManager.h"
 #include "../ShuttleGui.h"
 #include "../WaveTrack.h"
@@ -309,65 +310,48 @@ bool EffectNormalize::AnalyseTrack(const WaveTrack * track, const TranslatableSt
    return result;
 }
 
-//AnalyseTrackData() takes a track, transforms it to bunch of buffer-blocks,
-//and executes selected AnalyseOperation on it...
+//AnalyseTrackData() finds the DC offset of a track, from the sums of samples
+//kept with whole sample blocks, reading only the blocks at the edges, and
+//blocks whose sums are not yet known
 bool EffectNormalize::AnalyseTrackData(const WaveTrack * track, const TranslatableString &msg,
                                 double &progress, float &offset)
 {
    bool rc = true;
 
-   //Transform the marker timepoints to samples
-   auto start = track->TimeToLongSamples(mCurT0);
-   auto end = track->TimeToLongSamples(mCurT1);
-
-   //Get the length of the buffer (as double). len is
-   //used simply to calculate a progress meter, so it is easier
-   //to make it a double now than it is to do it later
-   auto len = (end - start).as_double();
-
-   //Initiate a processing buffer.  This buffer will (most likely)
-   //be shorter than the length of the track being processed.
-   Floats buffer{ track->GetMaxBlockSize() };
-
-   mSum   = 0.0; // dc offset inits
+   //Get the length of the selection (as double), to calculate a progress
+   //meter while the blocks are summed
+   const auto len = (track->TimeToLongSamples(mCurT1) -
+      track->TimeToLongSamples(mCurT0)).as_double();
+   const auto trackProgress = 1.0/double(2*GetNumWaveTracks());
+   double summed = 0;
+   const auto progressReport = [&](size_t count){
+      summed += count;
+      //Update the Progress meter
+      if (TotalProgress(progress + trackProgress * fmin(1.0, summed / len), msg))
+         throw UserException{};
+   };
 
-   sampleCount blockSamples;
    sampleCount totalSamples = 0;
-
-   //Go through the track one buffer at a time. s counts which
-   //sample the current buffer starts at.
-   auto s = start;
-   while (s < end) {
-      //Get a block of samples (smaller than the size of the buffer)
-      //Adjust the block size if it is the final block in the track
-      const auto block = limitSampleBufferSize(
-         track->GetBestBlockSize(s),
-         end - s
-      );
-
-      //Get the samples from the track and put them in the buffer
-      track->GetFloats(buffer.get(), s, block, fillZero, true, &blockSamples);
-      totalSamples += blockSamples;
-
-      //Process the buffer.
-      AnalyseDataDC(buffer.get(), block);
-
-      //Increment s one blockfull of samples
-      s += block;
-
-      //Update the Progress meter
-      if (TotalProgress(progress +
-                        ((s - start).as_double() / len)/double(2*GetNumWaveTracks()), msg)) {
-         rc = false; //lda .. break, not return, so that buffer is deleted
-         break;
-      }
+   double sum = 0;
+   try {
+      sum = track->GetSum(mCurT0, mCurT1, &totalSamples, true,
+         progressReport); // may throw
+   }
+   catch (const UserException &) {
+      //Cancelled
+      return false;
    }
+
    if( totalSamples > 0 )
-      offset = -mSum / totalSamples.as_double();  // calculate actual offset (amount that needs to be added on)
+      offset = -sum / totalSamples.as_double();  // calculate actual offset (amount that needs to be added on)
    else
       offset = 0.0;
 
-   progress += 1.0/double(2*GetNumWaveTracks());
+   progress += trackProgress;
+   //Update the Progress meter
+   if (TotalProgress(progress, msg))
+      rc = false;
+
    //Return true because the effect processing succeeded ... unless cancelled
    return rc;
 }
@@ -430,13 +414,6 @@ bool EffectNormalize::ProcessOne(
    return rc;
 }
 
-/// @see AnalyseDataLoudnessDC
-void EffectNormalize::AnalyseDataDC(float *buffer, size_t len)
-{
-   for(decltype(len) i = 0; i < len; i++)
-      mSum += (double)buffer[i];
-}
-
 void EffectNormalize::ProcessData(float *buffer, size_t len, float offset)
 {
    for(decltype(len) i = 0; i < len; i++) {
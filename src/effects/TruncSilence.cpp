@@ -69,9 +69,6 @@ const size_t Enums::NumDbChoices = WXSIZEOF(Enums::DbChoices);
 
 using Region = WaveTrack::Region;
 
-// Declaration of RegionList
-class RegionList : public std::list < Region > {};
-
 const EnumValueSymbol EffectTruncSilence::kActionStrings[nActions] =
 {
    { XO("Truncate Detected Silence") },
@@ -513,14 +510,36 @@ bool EffectTruncSilence::Analyze(RegionList& silenceList,
                                  int whichTrack,
                                  double* inputLength /*= NULL*/,
                                  double* minInputLength /*= NULL*/) const
+{
+   const AnalysisParameters parameters{ mT0, mT1, mThresholdDB, mActionIndex,
+      mInitialAllowedSilence, mTruncLongestAllowedSilence,
+      mSilenceCompressPercent };
+   const auto progress = [&](double fraction){
+      // Show progress dialog, test for cancellation
+      return TotalProgress(
+         detectFrac * (whichTrack + fraction) / (double)GetNumWaveTracks());
+   };
+   return Analyze(parameters, progress, silenceList, trackSilences, wt,
+      silentFrame, index, inputLength, minInputLength);
+}
+
+bool EffectTruncSilence::Analyze(const AnalysisParameters &parameters,
+                                 const AnalysisProgress &progress,
+                                 RegionList& silenceList,
+                                 RegionList& trackSilences,
+                                 const WaveTrack *wt,
+                                 sampleCount* silentFrame,
+                                 sampleCount* index,
+                                 double* inputLength /*= NULL*/,
+                                 double* minInputLength /*= NULL*/)
 {
    // Smallest silent region to detect in frames
-   auto minSilenceFrames = sampleCount(std::max( mInitialAllowedSilence, DEF_MinTruncMs) * wt->GetRate());
+   auto minSilenceFrames = sampleCount(std::max( parameters.initialAllowedSilence, DEF_MinTruncMs) * wt->GetRate());
 
-   double truncDbSilenceThreshold = DB_TO_LINEAR( mThresholdDB );
+   double truncDbSilenceThreshold = DB_TO_LINEAR( parameters.thresholdDB );
    auto blockLen = wt->GetMaxBlockSize();
-   auto start = wt->TimeToLongSamples(mT0);
-   auto end = wt->TimeToLongSamples(mT1);
+   auto start = wt->TimeToLongSamples(parameters.t0);
+   auto end = wt->TimeToLongSamples(parameters.t1);
    sampleCount outLength = 0;
 
    double previewLength;
@@ -544,13 +563,9 @@ bool EffectTruncSilence::Analyze(RegionList& silenceList,
          return true;
       }
 
-      if (!inputLength) {
-         // Show progress dialog, test for cancellation
-         bool cancelled = TotalProgress(
-               detectFrac * (whichTrack +
-                             (*index - start).as_double() /
-                             (end - start).as_double()) /
-                             (double)GetNumWaveTracks());
+      if (!inputLength && progress) {
+         bool cancelled = progress(
+            (*index - start).as_double() / (end - start).as_double());
          if (cancelled)
             return false;
       }
@@ -599,6 +614,20 @@ bool EffectTruncSilence::Analyze(RegionList& silenceList,
       // Limit size of current block if we've reached the end
       auto count = limitSampleBufferSize( blockLen, end - *index );
 
+      // Optimization: if summaries of sample blocks show that the buffer is
+      // all silent, count it without reading samples, as the loop below would.
+      // Silent samples add nothing to outLength, so when previewing, that
+      // loop stops in such a buffer only if it stops at the first sample
+      const bool previewDone = inputLength &&
+         ((outLength >= previewLen) ||
+          (outLength > wt->TimeToLongSamples(*minInputLength)));
+      if (parameters.useSummaries && !previewDone &&
+          wt->IsQuieterThan(*index, count, truncDbSilenceThreshold)) {
+         *silentFrame += count;
+         *index += count;
+         continue;
+      }
+
       // Fill buffer
       wt->GetFloats((buffer.get()), *index, count);
 
@@ -616,16 +645,16 @@ bool EffectTruncSilence::Analyze(RegionList& silenceList,
             sampleCount allowed = 0;
             if (*silentFrame >= minSilenceFrames) {
                if (inputLength) {
-                  switch (mActionIndex) {
+                  switch (parameters.actionIndex) {
                      case kTruncate:
-                        outLength += wt->TimeToLongSamples(mTruncLongestAllowedSilence);
+                        outLength += wt->TimeToLongSamples(parameters.truncLongestAllowedSilence);
                         break;
                      case kCompress:
-                        allowed = wt->TimeToLongSamples(mInitialAllowedSilence);
+                        allowed = wt->TimeToLongSamples(parameters.initialAllowedSilence);
                         outLength += sampleCount(
                            allowed.as_double() +
                               (*silentFrame - allowed).as_double()
-                                 * mSilenceCompressPercent / 100.0
+                                 * parameters.silenceCompressPercent / 100.0
                         );
                         break;
                      // default: // Not currently used.
@@ -17,15 +17,20 @@
 #ifndef __AUDACITY_EFFECT_TRUNC_SILENCE__
 #define __AUDACITY_EFFECT_TRUNC_SILENCE__
 
+#include <functional>
+#include <list>
+
 #include "Effect.h"
 #include "../ShuttleAutomation.h"
+#include "../WaveTrack.h"
 
 class ShuttleGui;
 class wxChoice;
 class wxTextCtrl;
 class wxCheckBox;
 
-class RegionList;
+// Declaration of RegionList
+class RegionList : public std::list < WaveTrack::Region > {};
 
 class EffectTruncSilence final : public StatefulEffect
 {
@@ -66,6 +71,34 @@ public:
                         double* inputLength = NULL,
                         double* minInputLength = NULL) const;
 
+   //! The selection and settings that analysis uses
+   struct AnalysisParameters
+   {
+      double t0, t1;
+      double thresholdDB;
+      int actionIndex;
+      double initialAllowedSilence;
+      double truncLongestAllowedSilence;
+      double silenceCompressPercent;
+      //! Whether buffers that summaries of sample blocks show to be quiet
+      //! are counted as silence without reading them
+      bool useSummaries{ true };
+   };
+   //! Given the fraction of the track done, returns true to cancel
+   using AnalysisProgress = std::function<bool(double)>;
+
+   // Analyze a single track, as above, with the given parameters
+   // progress may be empty; it is not called when previewing
+   static bool Analyze(const AnalysisParameters &parameters,
+                        const AnalysisProgress &progress,
+                        RegionList &silenceList,
+                        RegionList &trackSilences,
+                        const WaveTrack *wt,
+                        sampleCount* silentFrame,
+                        sampleCount* index,
+                        double* inputLength = NULL,
+                        double* minInputLength = NULL);
+
    bool Process(EffectInstance &instance, EffectSettings &settings) override;
    std::unique_ptr<EffectUIValidator> PopulateOrExchange(
       ShuttleGui & S, EffectInstance &instance, EffectSettingsAccess &access)
@@ -110,6 +143,7 @@ private:
    const EffectParameterMethods& Parameters() const override;
    DECLARE_EVENT_TABLE()
 
+public:
    enum kActions
    {
       kTruncate,
@@ -117,6 +151,7 @@ private:
       nActions
    };
 
+private:
    static const EnumValueSymbol kActionStrings[nActions];
 
 static constexpr EffectParameter Threshold{ &EffectTruncSilence::mThresholdDB,
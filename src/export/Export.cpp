@@ -36,6 +36,7 @@
 #include <wx/file.h>
 #include <wx/filectrl.h>
 #include <wx/filename.h>
+#include <wx/log.h>
 #include <wx/simplebook.h>
 #include <wx/sizer.h>
 #include <wx/slider.h>
@@ -65,6 +66,7 @@
 #include "../ShuttleGui.h"
 #include "../TagsEditor.h"
 #include "Theme.h"
+#include "ThreadPool.h"
 #include "../WaveTrack.h"
 #include "../widgets/AudacityMessageBox.h"
 #include "../widgets/Warning.h"
@@ -220,33 +222,290 @@ void ExportPlugin::OptionsCreate(ShuttleGui &S, int WXUNUSED(format))
    S.EndHorizontalLay();
 }
 
+namespace {
+std::unique_ptr<ExportPipeline> MakePipeline(const TrackList &tracks,
+   const ExportMixAhead::Tracks &mixed,
+   double startTime, double stopTime,
+   unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
+   double outRate, sampleFormat outFormat,
+   MixerSpec *mixerSpec, size_t depth = ExportPipeline::DefaultDepth)
+{
+   Mixer::Inputs inputs;
+   for (auto &pTrack : mixed)
+      inputs.emplace_back(pTrack, GetEffectStages(*pTrack));
+   // MB: the stop time should not be warped, this was a bug.
+   auto mixer = std::make_unique<Mixer>(move(inputs),
+                  // Throw, to stop exporting, if read fails:
+                  true,
+                  Mixer::WarpOptions{tracks},
+                  startTime, stopTime,
+                  numOutChannels, outBufferSize, outInterleaved,
+                  outRate, outFormat,
+                  true, mixerSpec);
+   // Resample and apply effects of many tracks on all cores
+   mixer->SetThreadPool(&ThreadPool::Get());
+   return std::make_unique<ExportPipeline>(
+      move(mixer), numOutChannels, outInterleaved, outFormat, depth);
+}
+}
+
 //Create a mixer by computing the time warp factor
-std::unique_ptr<Mixer> ExportPlugin::CreateMixer(const TrackList &tracks,
+std::unique_ptr<ExportPipeline> ExportPlugin::CreateMixer(const TrackList &tracks,
          bool selectionOnly,
          double startTime, double stopTime,
          unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
          double outRate, sampleFormat outFormat,
          MixerSpec *mixerSpec)
 {
-   Mixer::Inputs inputs;
+   const auto mixed = ExportMixAhead::MixedTracks(tracks,
+      [selectionOnly](const Track *pTrack){
+         return !selectionOnly || pTrack->IsSelected(); });
+   if (mpMixAhead)
+      if (auto result = mpMixAhead->Take(mixed, startTime, stopTime,
+         numOutChannels, outBufferSize, outInterleaved, outRate, outFormat,
+         mixerSpec))
+         return result;
+   return MakePipeline(tracks, mixed, startTime, stopTime,
+      numOutChannels, outBufferSize, outInterleaved, outRate, outFormat,
+      mixerSpec);
+}
 
+ExportMixAhead::Tracks ExportMixAhead::MixedTracks(const TrackList &tracks,
+   const std::function<bool(const Track *)> &pred)
+{
    bool anySolo = !(( tracks.Any<const WaveTrack>() + &WaveTrack::GetSolo ).empty());
 
    auto range = tracks.Any< const WaveTrack >()
-      + (selectionOnly ? &Track::IsSelected : &Track::Any )
+      + pred
       - ( anySolo ? &WaveTrack::GetNotSolo : &WaveTrack::GetMute);
+   Tracks result;
    for (auto pTrack: range)
-      inputs.emplace_back(
-         pTrack->SharedPointer<const SampleTrack>(), GetEffectStages(*pTrack));
-   // MB: the stop time should not be warped, this was a bug.
-   return std::make_unique<Mixer>(move(inputs),
-                  // Throw, to stop exporting, if read fails:
-                  true,
-                  Mixer::WarpOptions{tracks},
-                  startTime, stopTime,
-                  numOutChannels, outBufferSize, outInterleaved,
-                  outRate, outFormat,
-                  true, mixerSpec);
+      result.push_back(pTrack->SharedPointer<const WaveTrack>());
+   return result;
+}
+
+bool ExportMixAhead::Format::operator== (const Format &other) const
+{
+   return bufferSize == other.bufferSize &&
+      interleaved == other.interleaved &&
+      rate == other.rate &&
+      format == other.format;
+}
+
+namespace {
+//! Memory for mixed samples that one file mixing ahead may fill
+constexpr size_t MixAheadBytes = 32 * 1024 * 1024;
+}
+
+ExportMixAhead::ExportMixAhead(ExportPlugin &plugin, const TrackList &tracks,
+   std::vector<Job> jobs, size_t concurrency)
+   : mPlugin{ plugin }
+   , mTracks{ tracks }
+   , mJobs{ move(jobs) }
+   , mConcurrency{ std::max<size_t>(1, concurrency) }
+   , mPipelines(mJobs.size())
+{
+   mPlugin.SetMixAhead(this);
+}
+
+ExportMixAhead::~ExportMixAhead()
+{
+   mPlugin.SetMixAhead(nullptr);
+}
+
+std::unique_ptr<ExportPipeline> ExportMixAhead::Take(const Tracks &tracks,
+   double startTime, double stopTime,
+   unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
+   double outRate, sampleFormat outFormat, MixerSpec *mixerSpec)
+{
+   if (mixerSpec)
+      return nullptr;
+   const auto begin = mJobs.begin() + mNext;
+   const auto iter = std::find_if(begin, mJobs.end(), [&](const Job &job){
+      return job.tracks == tracks &&
+         job.t0 == startTime && job.t1 == stopTime &&
+         job.channels == numOutChannels;
+   });
+   if (iter == mJobs.end())
+      return nullptr;
+   const size_t index = iter - mJobs.begin();
+   mNext = index + 1;
+
+   // Skipped jobs won't be taken; stop their mixing
+   for (size_t ii = 0; ii < index; ++ii)
+      mPipelines[ii].reset();
+
+   const Format format{ outBufferSize, outInterleaved, outRate, outFormat };
+   if (mFormat && !(*mFormat == format))
+      // The plugin changed its mind; what was mixed ahead is unusable
+      for (auto &pPipeline : mPipelines)
+         pPipeline.reset();
+   mFormat = format;
+
+   // Start the following files
+   const auto bytesPerBlock = std::max<size_t>(1,
+      outBufferSize * SAMPLE_SIZE(outFormat) * numOutChannels);
+   const auto depth = std::max(
+      ExportPipeline::DefaultDepth, MixAheadBytes / bytesPerBlock);
+   for (size_t ii = mNext,
+      end = std::min(mJobs.size(), index + mConcurrency); ii < end; ++ii) {
+      auto &job = mJobs[ii];
+      if (!mPipelines[ii])
+         mPipelines[ii] = MakePipeline(mTracks, job.tracks, job.t0, job.t1,
+            job.channels, outBufferSize, outInterleaved, outRate, outFormat,
+            nullptr, depth);
+   }
+
+   auto result = move(mPipelines[index]);
+   if (!result)
+      result = MakePipeline(mTracks, tracks, startTime, stopTime,
+         numOutChannels, outBufferSize, outInterleaved, outRate, outFormat,
+         nullptr);
+   return result;
+}
+
+ExportPipeline::ExportPipeline(std::unique_ptr<Mixer> pMixer,
+   unsigned numOutChannels, bool outInterleaved, sampleFormat outFormat,
+   size_t depth)
+   : mpMixer{ move(pMixer) }
+   , mBufferSize{ mpMixer->BufferSize() }
+   , mNumChannels{ numOutChannels }
+   , mInterleaved{ outInterleaved }
+   , mFormat{ outFormat }
+   , mDepth{ std::max<size_t>(1, depth) }
+   , mStart{ Clock::now() }
+   , mLastReturn{ mStart }
+{
+   mThread = std::thread{ [this]{ Produce(); } };
+}
+
+ExportPipeline::~ExportPipeline()
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mStopping = true;
+   }
+   mCondition.notify_all();
+   mThread.join();
+
+   const auto seconds = [](Clock::duration duration){
+      return std::chrono::duration<double>(duration).count();
+   };
+   const auto rate = [&](Clock::duration duration){
+      return mMixedSamples / std::max(seconds(duration), 1e-6);
+   };
+   wxLogMessage(
+      "Export pipeline: %lld samples in %.3f s\n"
+      "\tmixing %.3f s (%.0f samples/s), waiting for encoder %.3f s\n"
+      "\tencoding %.3f s (%.0f samples/s), waiting for mixer %.3f s",
+      (long long) mMixedSamples, seconds(Clock::now() - mStart),
+      seconds(mMixing), rate(mMixing), seconds(mMixerWaiting),
+      seconds(mEncoding), rate(mEncoding), seconds(mEncoderWaiting));
+}
+
+void ExportPipeline::Produce()
+{
+   while (true) {
+      Block block;
+      {
+         auto start = Clock::now();
+         std::unique_lock<std::mutex> lock{ mMutex };
+         mCondition.wait(lock, [this]{
+            return mStopping || mFilled.size() < mDepth; });
+         if (mStopping)
+            return;
+         if (!mEmpty.empty()) {
+            block = std::move(mEmpty.back());
+            mEmpty.pop_back();
+         }
+         mMixerWaiting += Clock::now() - start;
+      }
+      if (block.buffers.empty())
+         for (size_t ii = 0, nBuffers = mInterleaved ? 1 : mNumChannels;
+            ii < nBuffers; ++ii)
+            block.buffers.emplace_back(
+               mBufferSize * (mInterleaved ? mNumChannels : 1), mFormat);
+
+      auto start = Clock::now();
+      try {
+         block.length = mpMixer->Process();
+         const auto bytes = block.length * SAMPLE_SIZE(mFormat) *
+            (mInterleaved ? mNumChannels : 1);
+         for (size_t ii = 0; ii < block.buffers.size(); ++ii)
+            memcpy(block.buffers[ii].ptr(), mpMixer->GetBuffer(ii), bytes);
+         block.time = mpMixer->MixGetCurrentTime();
+      }
+      catch (...) {
+         block.length = 0;
+         block.exception = std::current_exception();
+      }
+      mMixing += Clock::now() - start;
+      mMixedSamples += block.length;
+
+      const bool last = (block.length == 0);
+      {
+         std::lock_guard<std::mutex> lock{ mMutex };
+         mFilled.push_back(std::move(block));
+      }
+      mCondition.notify_all();
+      if (last)
+         return;
+   }
+}
+
+size_t ExportPipeline::Process(size_t maxSamples)
+{
+   auto start = Clock::now();
+   mEncoding += start - mLastReturn;
+   auto returning = finally([&]{ mLastReturn = Clock::now(); });
+
+   if (mDone)
+      return 0;
+
+   if (mTaken == mCurrent.length) {
+      {
+         std::unique_lock<std::mutex> lock{ mMutex };
+         if (!mCurrent.buffers.empty())
+            mEmpty.push_back(std::move(mCurrent));
+         mCondition.wait(lock, [this]{ return !mFilled.empty(); });
+         mCurrent = std::move(mFilled.front());
+         mFilled.pop_front();
+      }
+      // Make room for the mixer
+      mCondition.notify_all();
+      mTaken = 0;
+      mEncoderWaiting += Clock::now() - start;
+   }
+
+   if (mCurrent.exception) {
+      mDone = true;
+      std::rethrow_exception(mCurrent.exception);
+   }
+   if (mCurrent.length == 0) {
+      mDone = true;
+      return 0;
+   }
+
+   mLastTaken = mTaken;
+   const auto result = std::min(maxSamples, mCurrent.length - mTaken);
+   mTaken += result;
+   return result;
+}
+
+constSamplePtr ExportPipeline::GetBuffer()
+{
+   return GetBuffer(0);
+}
+
+constSamplePtr ExportPipeline::GetBuffer(int channel)
+{
+   return mCurrent.buffers[channel].ptr() +
+      mLastTaken * SAMPLE_SIZE(mFormat) * (mInterleaved ? mNumChannels : 1);
+}
+
+double ExportPipeline::MixGetCurrentTime()
+{
+   return mCurrent.time;
 }
 
 void ExportPlugin::InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
@@ -11,7 +11,15 @@
 #ifndef __AUDACITY_EXPORT__
 #define __AUDACITY_EXPORT__
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
 #include <wx/filename.h> // member variable
 #include "Identifier.h"
@@ -30,6 +38,7 @@ class wxStaticText;
 class AudacityProject;
 class WaveTrack;
 class Tags;
+class Track;
 class TrackList;
 namespace MixerOptions{ class Downmix; }
 using MixerSpec = MixerOptions::Downmix;
@@ -62,6 +71,148 @@ class AUDACITY_DLL_API FormatInfo
 //----------------------------------------------------------------------------
 // ExportPlugin
 //----------------------------------------------------------------------------
+//! Runs a Mixer in a thread of its own, some buffers ahead of the encoder
+/*!
+ It has the processing interface of Mixer, so exporters use it the same way.
+ Exceptions from mixing are thrown again from Process().  Throughput of the
+ stages is logged when it is destroyed.
+ */
+class AUDACITY_DLL_API ExportPipeline final
+{
+public:
+   //! How many mixed blocks may wait for the encoder, by default
+   static constexpr size_t DefaultDepth = 4;
+
+   ExportPipeline(std::unique_ptr<Mixer> pMixer,
+      unsigned numOutChannels, bool outInterleaved, sampleFormat outFormat,
+      size_t depth = DefaultDepth);
+   ~ExportPipeline();
+
+   ExportPipeline(const ExportPipeline&) = delete;
+   ExportPipeline &operator=(const ExportPipeline&) = delete;
+
+   size_t BufferSize() const { return mBufferSize; }
+
+   //! Take up to maxSamples of the mix, waiting for it if necessary
+   /*! @return 0 when there is nothing more */
+   size_t Process(size_t maxSamples);
+   size_t Process() { return Process(BufferSize()); }
+
+   //! The samples that the last Process() took, interleaved, or of channel 0
+   constSamplePtr GetBuffer();
+   //! The samples that the last Process() took, of one channel
+   constSamplePtr GetBuffer(int channel);
+
+   //! Time reached by the mix of the samples that the last Process() took
+   double MixGetCurrentTime();
+
+private:
+   using Clock = std::chrono::steady_clock;
+
+   //! One output of Mixer::Process()
+   struct Block {
+      std::vector<SampleBuffer> buffers;
+      size_t length{ 0 };
+      double time{ 0 };
+      std::exception_ptr exception;
+   };
+
+   void Produce();
+
+   const std::unique_ptr<Mixer> mpMixer;
+   const size_t mBufferSize;
+   const unsigned mNumChannels;
+   const bool mInterleaved;
+   const sampleFormat mFormat;
+   const size_t mDepth;
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   //! Mixed blocks, waiting for the encoder
+   std::deque<Block> mFilled;
+   //! Blocks to reuse
+   std::vector<Block> mEmpty;
+   bool mStopping{ false };
+
+   //! Consumer's current block, and position in it
+   Block mCurrent;
+   size_t mTaken{ 0 }, mLastTaken{ 0 };
+   bool mDone{ false };
+
+   // Statistics; the producer writes the first three, and the consumer
+   // reads them after joining
+   size_t mMixedSamples{ 0 };
+   Clock::duration mMixing{}, mMixerWaiting{};
+   Clock::duration mEncoding{}, mEncoderWaiting{};
+   Clock::time_point mStart, mLastReturn;
+
+   std::thread mThread;
+};
+
+class ExportPlugin;
+
+//! Lets an export of several files mix the next files while the exporter
+//! encodes the current one
+/*!
+ The files are described in order beforehand.  While it exists, the first
+ ExportPlugin::CreateMixer call for each file learns the format that the
+ plugin wants, and starts mixing the following files in that format, so that
+ up to the given number of files are mixed at once.  Calls that match no
+ file, or a different format, just make a new mixer.
+ */
+class AUDACITY_DLL_API ExportMixAhead final
+{
+public:
+   using Tracks = std::vector<std::shared_ptr<const WaveTrack>>;
+
+   //! One file to export
+   struct Job {
+      Tracks tracks;
+      double t0, t1;
+      unsigned channels;
+   };
+
+   //! The wave tracks that CreateMixer mixes, when exporting only those that
+   //! satisfy pred
+   static Tracks MixedTracks(const TrackList &tracks,
+      const std::function<bool(const Track *)> &pred);
+
+   ExportMixAhead(ExportPlugin &plugin, const TrackList &tracks,
+      std::vector<Job> jobs, size_t concurrency);
+   ~ExportMixAhead();
+
+   ExportMixAhead(const ExportMixAhead&) = delete;
+   ExportMixAhead &operator=(const ExportMixAhead&) = delete;
+
+   //! Called by ExportPlugin::CreateMixer
+   /*! @return null if the arguments match none of the jobs */
+   std::unique_ptr<ExportPipeline> Take(const Tracks &tracks,
+      double startTime, double stopTime,
+      unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
+      double outRate, sampleFormat outFormat, MixerSpec *mixerSpec);
+
+private:
+   //! What the plugin passed to CreateMixer, besides the job
+   struct Format {
+      size_t bufferSize;
+      bool interleaved;
+      double rate;
+      sampleFormat format;
+      bool operator== (const Format &other) const;
+   };
+
+   ExportPlugin &mPlugin;
+   const TrackList &mTracks;
+   const std::vector<Job> mJobs;
+   const size_t mConcurrency;
+
+   std::optional<Format> mFormat;
+   //! Pipelines mixing ahead, indexed like mJobs
+   std::vector<std::unique_ptr<ExportPipeline>> mPipelines;
+   //! Index of the first job not yet taken
+   size_t mNext{ 0 };
+};
+
 class AUDACITY_DLL_API ExportPlugin /* not final */
 {
 public:
@@ -135,8 +286,12 @@ public:
                        const Tags *metadata = NULL,
                        int subformat = 0) = 0;
 
+   //! Make CreateMixer consult the given object; pass null to stop
+   void SetMixAhead(ExportMixAhead *pMixAhead) { mpMixAhead = pMixAhead; }
+
 protected:
-   std::unique_ptr<Mixer> CreateMixer(const TrackList &tracks,
+   //! Make a mixer that runs ahead of the encoder in another thread
+   std::unique_ptr<ExportPipeline> CreateMixer(const TrackList &tracks,
          bool selectionOnly,
          double startTime, double stopTime,
          unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
@@ -151,6 +306,7 @@ protected:
 
 private:
    std::vector<FormatInfo> mFormatInfos;
+   ExportMixAhead *mpMixAhead{};
 };
 
 using ExportPluginArray = std::vector < std::unique_ptr< ExportPlugin > > ;
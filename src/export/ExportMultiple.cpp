@@ -75,6 +75,9 @@ namespace {
     * this isn't done anywhere else in Audacity, presumably for a reason?, so
     * I'm stuck with wxArrays, which are much harder, as well as non-standard.
     */
+
+   //! How many files may be mixed at once, while one of them is encoded
+   IntSetting MultipleConcurrency{ L"/Export/MultipleConcurrency", 2 };
 }
 
 /* define our dynamic array of export settings */
@@ -432,6 +435,10 @@ void ExportMultipleDialog::PopulateOrExchange(ShuttleGui& S)
       mOverwrite = S.Id(OverwriteID).TieCheckBox(XXO("Overwrite existing files"),
                                                  {wxT("/Export/OverwriteExisting"),
                                                   false});
+      S.AddSpace(10, 0);
+      S.Name(XO("Files to mix at once"))
+         .TieSpinCtrl(XXO("Files to &mix at once:"), MultipleConcurrency,
+            16, 1);
    }
    S.EndHorizontalLay();
 
@@ -873,6 +880,16 @@ ProgressResult ExportMultipleDialog::ExportMultipleByLabel(bool byName,
    ExportKit activeSetting;  // pointer to the settings in use for this export
    /* Go round again and do the exporting (so this run is slow but
     * non-interactive) */
+   // Mix the next files while the plugin encodes each
+   std::vector<ExportMixAhead::Job> jobs;
+   const auto mixed = ExportMixAhead::MixedTracks(*mTracks,
+      [](const Track *){ return true; });
+   for (const auto &setting : exportSettings)
+      if (!setting.destfile.GetName().empty())
+         jobs.push_back({ mixed, setting.t0, setting.t1, channels });
+   ExportMixAhead mixAhead{ *mPlugins[mPluginIndex], *mTracks, move(jobs),
+      static_cast<size_t>(MultipleConcurrency.Read()) };
+
    std::unique_ptr<ProgressDialog> pDialog;
    for (count = 0; count < numFiles; count++) {
       /* get the settings to use for the export from the array */
@@ -1014,6 +1031,26 @@ ProgressResult ExportMultipleDialog::ExportMultipleByTrack(bool byName,
    // loop
    int count = 0; // count the number of successful runs
    ExportKit activeSetting;  // pointer to the settings in use for this export
+
+   // Mix the next tracks while the plugin encodes each
+   std::vector<ExportMixAhead::Job> jobs;
+   {
+      int index = 0;
+      for (auto tr : mTracks->Leaders<WaveTrack>() -
+         (anySolo ? &WaveTrack::GetNotSolo : &WaveTrack::GetMute)) {
+         const auto &setting = exportSettings[index++];
+         if (setting.destfile.GetName().empty())
+            continue;
+         const auto range = TrackList::Channels(tr);
+         jobs.push_back({
+            ExportMixAhead::MixedTracks(*mTracks, [&](const Track *pTrack){
+               return range.contains(pTrack); }),
+            setting.t0, setting.t1, setting.channels });
+      }
+   }
+   ExportMixAhead mixAhead{ *mPlugins[mPluginIndex], *mTracks, move(jobs),
+      static_cast<size_t>(MultipleConcurrency.Read()) };
+
    std::unique_ptr<ProgressDialog> pDialog;
 
    for (auto tr : mTracks->Leaders<WaveTrack>() - 
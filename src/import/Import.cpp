@@ -41,6 +41,7 @@ ImportLOF.cpp, and ImportAUP.cpp.
 #include "ImportPlugin.h"
 
 #include <algorithm>
+#include <optional>
 #include <unordered_set>
 
 #include <wx/textctrl.h>
@@ -53,6 +54,7 @@ ImportLOF.cpp, and ImportAUP.cpp.
 #include "FileNames.h"
 #include "../ShuttleGui.h"
 #include "Project.h"
+#include "../SampleBlock.h"
 #include "../WaveTrack.h"
 
 #include "Prefs.h"
@@ -81,6 +83,51 @@ Importer::~Importer()
 {
 }
 
+namespace {
+Importer::Batch *sCurrentBatch = nullptr;
+}
+
+Importer::Batch::Prefetch::~Prefetch() = default;
+
+Importer::Batch::Batch(const wxArrayString &files)
+   : mFiles{ files.begin(), files.end() }
+   , mpPrevious{ sCurrentBatch }
+{
+   sCurrentBatch = this;
+}
+
+Importer::Batch::~Batch()
+{
+   sCurrentBatch = mpPrevious;
+}
+
+auto Importer::Batch::Current() -> Batch *
+{
+   return sCurrentBatch;
+}
+
+bool Importer::Batch::HasPrefetch(const FilePath &path) const
+{
+   return mPrefetched.count(path) > 0;
+}
+
+void Importer::Batch::PutPrefetch(
+   const FilePath &path, std::unique_ptr<Prefetch> pPrefetch)
+{
+   mPrefetched[path] = move(pPrefetch);
+}
+
+auto Importer::Batch::TakePrefetch(const FilePath &path)
+   -> std::unique_ptr<Prefetch>
+{
+   auto iter = mPrefetched.find(path);
+   if (iter == mPrefetched.end())
+      return nullptr;
+   auto result = move(iter->second);
+   mPrefetched.erase(iter);
+   return result;
+}
+
 ImportPluginList &Importer::sImportPluginList()
 {
    static ImportPluginList theList;
@@ -627,7 +674,14 @@ bool Importer::Import( AudacityProject &project,
          else
             inFile->SetStreamUsage(0,TRUE);
 
-         auto res = inFile->Import(trackFactory, tracks, tags);
+         auto res = [&]{
+            // Store the many new sample blocks in few transactions
+            std::optional<SampleBlockFactory::BatchScope> batch;
+            if (trackFactory)
+               if (auto &pFactory = trackFactory->GetSampleBlockFactory())
+                  batch.emplace(*pFactory);
+            return inFile->Import(trackFactory, tracks, tags);
+         }();
 
          if (res == ProgressResult::Success || res == ProgressResult::Stopped)
          {
@@ -13,6 +13,8 @@
 
 #include "ImportForwards.h"
 #include "Identifier.h"
+#include <map>
+#include <memory>
 #include <vector>
 #include <wx/tokenzr.h> // for enum wxStringTokenizerMode
 
@@ -101,6 +103,42 @@ public:
    Importer( const Importer& ) PROHIBITED;
    Importer &operator=( Importer& ) PROHIBITED;
 
+   //! Names files about to be imported one after another
+   /*!
+    While it exists, a plugin importing one of the files may start decoding
+    the following ones in other threads, and leave that work here for its
+    turn.  Work not taken is abandoned when the batch is destroyed.
+    Use only in the main thread.
+    */
+   class AUDACITY_DLL_API Batch final {
+   public:
+      //! Work that a plugin started for a file before its turn
+      struct AUDACITY_DLL_API Prefetch {
+         virtual ~Prefetch();
+      };
+
+      explicit Batch(const wxArrayString &files);
+      ~Batch();
+
+      Batch( const Batch& ) PROHIBITED;
+      Batch &operator=( const Batch& ) PROHIBITED;
+
+      //! The innermost batch that exists, or null
+      static Batch *Current();
+
+      const FilePaths &GetFiles() const { return mFiles; }
+
+      bool HasPrefetch(const FilePath &path) const;
+      void PutPrefetch(const FilePath &path, std::unique_ptr<Prefetch> pPrefetch);
+      //! @return null if there is no work left for the file
+      std::unique_ptr<Prefetch> TakePrefetch(const FilePath &path);
+
+   private:
+      const FilePaths mFiles;
+      std::map<FilePath, std::unique_ptr<Prefetch>> mPrefetched;
+      Batch *const mpPrevious;
+   };
+
    /**
     * Return instance reference
     */
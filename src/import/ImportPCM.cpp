@@ -29,6 +29,7 @@
 #include <wx/utils.h>
 #include <wx/intl.h>
 #include <wx/ffile.h>
+#include <wx/filename.h>
 #include <wx/sizer.h>
 #include <wx/checkbox.h>
 #include <wx/button.h>
@@ -47,10 +48,17 @@
 #include "../FileFormats.h"
 #include "Prefs.h"
 #include "../ShuttleGui.h"
+#include "../Sequence.h"
 #include "../WaveTrack.h"
 #include "ImportPlugin.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
 
 #ifdef USE_LIBID3TAG
    #include <id3tag.h>
@@ -116,10 +124,10 @@ TranslatableString PCMImportPlugin::GetPluginFormatDescription()
     return DESC;
 }
 
-std::unique_ptr<ImportFileHandle> PCMImportPlugin::Open(
-   const FilePath &filename, AudacityProject*)
+namespace {
+//! Open a file for reading with libsndfile, or return null
+SFFile OpenSndFile(const FilePath &filename, SF_INFO &info)
 {
-   SF_INFO info;
    wxFile f;   // will be closed when it goes out of scope
    SFFile file;
 
@@ -138,7 +146,7 @@ std::unique_ptr<ImportFileHandle> PCMImportPlugin::Open(
       // ImportPCM to not handle .mp3.  Of course, this will still fail for mp3s
       // that are mislabeled with a .wav or other extension.
       // So, in the future we may want to write a simple parser to detect mp3s here.
-      return NULL;
+      return {};
    }
 #endif
 
@@ -160,7 +168,7 @@ std::unique_ptr<ImportFileHandle> PCMImportPlugin::Open(
       //char str[1000];
       //sf_error_str((SNDFILE *)NULL, str, 1000);
 
-      return nullptr;
+      return {};
    } else if (file &&
               (info.format & SF_FORMAT_TYPEMASK) == SF_FORMAT_OGG) {
       // mchinen 15.1.2012 - disallowing libsndfile to handle
@@ -174,8 +182,257 @@ std::unique_ptr<ImportFileHandle> PCMImportPlugin::Open(
       // When the bug is fixed, we can check version to avoid only
       // the broken builds.
 
+      return {};
+   }
+
+   return file;
+}
+
+//! How many decoded chunks, each of a block per channel, may wait to be
+//! appended to tracks
+constexpr size_t DecodeDepth = 2;
+
+//! How many files of a batch may be decoding at once, counting the one
+//! being appended to tracks
+size_t DecodeConcurrency()
+{
+   return std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+}
+
+//! Reads and deinterleaves a file in a thread of its own, some chunks ahead
+//! of the appending to tracks
+/*!
+ Chunks are as long as the blocks of tracks of the chosen format, and are in
+ that format unless it is wider than the file's, so that WaveTrack::Append
+ can make blocks from them without copying them again.
+ */
+class PCMDecoder final : public Importer::Batch::Prefetch
+{
+public:
+   //! Samples of all channels, in ReadFormat()
+   struct Chunk {
+      std::vector<SampleBuffer> buffers;
+      size_t length{ 0 };
+      std::exception_ptr exception;
+   };
+
+   //! Decode from the beginning of a file that is open already
+   /*!
+    @param file must outlive this, unless it is the one in ownedFile
+    */
+   PCMDecoder(SNDFILE *file, const SF_INFO &info, sampleFormat format,
+      SFFile ownedFile = {});
+
+   //! Open a file and start decoding it, or return null
+   static std::unique_ptr<PCMDecoder> Open(const FilePath &filename);
+
+   ~PCMDecoder() override;
+
+   //! Whether this decodes a file with the given description
+   bool Matches(const SF_INFO &info, sampleFormat format) const;
+
+   sampleFormat ReadFormat() const { return mReadFormat; }
+
+   //! Wait for the next chunk, which is valid until the next call
+   /*!
+    A chunk of length 0 ends the file; don't call again after it.
+    Exceptions from decoding are thrown again here.
+    */
+   const Chunk &Next();
+
+private:
+   void Decode();
+
+   SFFile mOwnedFile;
+   SNDFILE *const mFile;
+   const SF_INFO mInfo;
+   const sampleFormat mFormat;
+   //! The format of chunks
+   const sampleFormat mReadFormat;
+   size_t mFrames;
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   //! Decoded chunks, waiting to be appended
+   std::deque<Chunk> mFilled;
+   //! Chunks to reuse
+   std::vector<Chunk> mEmpty;
+   bool mStopping{ false };
+
+   //! Consumer's current chunk
+   Chunk mCurrent;
+
+   std::thread mThread;
+};
+
+PCMDecoder::PCMDecoder(SNDFILE *file, const SF_INFO &info,
+   sampleFormat format, SFFile ownedFile)
+   : mOwnedFile{ std::move(ownedFile) }
+   , mFile{ file }
+   , mInfo{ info }
+   , mFormat{ format }
+   , mReadFormat{ format }
+{
+   // PRL:  guard against excessive memory buffer allocation in case of many channels
+   mFrames = std::max<size_t>(1, std::min(Sequence::GetMaxBlockSize(format),
+      std::numeric_limits<size_t>::max() /
+         (std::max(1, mInfo.channels) * SAMPLE_SIZE(mReadFormat))));
+   mThread = std::thread{ [this]{ Decode(); } };
+}
+
+std::unique_ptr<PCMDecoder> PCMDecoder::Open(const FilePath &filename)
+{
+   SF_INFO info;
+   auto file = OpenSndFile(filename, info);
+   if (!file || info.channels < 1)
       return nullptr;
+   const auto format = ImportFileHandle::ChooseFormat(
+      sf_subtype_to_effective_format(info.format));
+   const auto pFile = file.get();
+   return std::make_unique<PCMDecoder>(pFile, info, format, std::move(file));
+}
+
+PCMDecoder::~PCMDecoder()
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mStopping = true;
+   }
+   mCondition.notify_all();
+   mThread.join();
+}
+
+bool PCMDecoder::Matches(const SF_INFO &info, sampleFormat format) const
+{
+   return mInfo.frames == info.frames &&
+      mInfo.channels == info.channels &&
+      mInfo.samplerate == info.samplerate &&
+      mInfo.format == info.format &&
+      mFormat == format;
+}
+
+void PCMDecoder::Decode()
+{
+   const size_t nChannels = mInfo.channels;
+   SampleBuffer interleaved;
+   while (true) {
+      Chunk chunk;
+      {
+         std::unique_lock<std::mutex> lock{ mMutex };
+         mCondition.wait(lock, [this]{
+            return mStopping || mFilled.size() < DecodeDepth; });
+         if (mStopping)
+            return;
+         if (!mEmpty.empty()) {
+            chunk = std::move(mEmpty.back());
+            mEmpty.pop_back();
+         }
+      }
+
+      try {
+         if (!interleaved.ptr() &&
+             !interleaved.Allocate(mFrames * nChannels, mReadFormat).ptr())
+            throw std::bad_alloc{};
+         while (chunk.buffers.size() < nChannels)
+            if (!chunk.buffers.emplace_back(mFrames, mReadFormat).ptr())
+               throw std::bad_alloc{};
+
+         long block;
+         if (mReadFormat == int16Sample)
+            block = SFCall<sf_count_t>(sf_readf_short, mFile, (short *)interleaved.ptr(), mFrames);
+         // libsndfile puts 24 bit samples in the high bits of int
+         else if (mReadFormat == int24Sample)
+            block = SFCall<sf_count_t>(sf_readf_int, mFile, (int *)interleaved.ptr(), mFrames);
+         else
+            block = SFCall<sf_count_t>(sf_readf_float, mFile, (float *)interleaved.ptr(), mFrames);
+
+         if(block < 0 || block > (long)mFrames) {
+            wxASSERT(false);
+            block = mFrames;
+         }
+
+         for (size_t c = 0; c < nChannels; ++c) {
+            if (mReadFormat == int16Sample) {
+               const auto src = (const short *)interleaved.ptr() + c;
+               const auto dest = (short *)chunk.buffers[c].ptr();
+               for (long j = 0; j < block; j++)
+                  dest[j] = src[nChannels * j];
+            }
+            else if (mReadFormat == int24Sample) {
+               const auto src = (const int *)interleaved.ptr() + c;
+               const auto dest = (int *)chunk.buffers[c].ptr();
+               for (long j = 0; j < block; j++)
+                  dest[j] = src[nChannels * j] >> 8;
+            }
+            else {
+               const auto src = (const float *)interleaved.ptr() + c;
+               const auto dest = (float *)chunk.buffers[c].ptr();
+               for (long j = 0; j < block; j++)
+                  dest[j] = src[nChannels * j];
+            }
+         }
+         chunk.length = block;
+      }
+      catch (...) {
+         chunk.length = 0;
+         chunk.exception = std::current_exception();
+      }
+
+      const bool last = (chunk.length == 0);
+      {
+         std::lock_guard<std::mutex> lock{ mMutex };
+         mFilled.push_back(std::move(chunk));
+      }
+      mCondition.notify_all();
+      if (last)
+         return;
    }
+}
+
+auto PCMDecoder::Next() -> const Chunk &
+{
+   {
+      std::unique_lock<std::mutex> lock{ mMutex };
+      if (!mCurrent.buffers.empty())
+         mEmpty.push_back(std::move(mCurrent));
+      mCondition.wait(lock, [this]{ return !mFilled.empty(); });
+      mCurrent = std::move(mFilled.front());
+      mFilled.pop_front();
+   }
+   // Make room for the decoder
+   mCondition.notify_all();
+   if (mCurrent.exception)
+      std::rethrow_exception(mCurrent.exception);
+   return mCurrent;
+}
+
+//! Start decoding the files that follow the given one in the batch
+void PrefetchFollowing(Importer::Batch &batch, const FilePath &filename)
+{
+   static const auto extensions = sf_get_all_extensions();
+   const auto &files = batch.GetFiles();
+   auto iter = std::find(files.begin(), files.end(), filename);
+   if (iter == files.end())
+      return;
+   const auto end = (iter + 1) + std::min<size_t>(
+      files.end() - (iter + 1), DecodeConcurrency() - 1);
+   for (++iter; iter != end; ++iter) {
+      if (batch.HasPrefetch(*iter) ||
+          extensions.Index(wxFileName{ *iter }.GetExt(), false) == wxNOT_FOUND)
+         continue;
+      if (auto pDecoder = PCMDecoder::Open(*iter))
+         batch.PutPrefetch(*iter, std::move(pDecoder));
+   }
+}
+}
+
+std::unique_ptr<ImportFileHandle> PCMImportPlugin::Open(
+   const FilePath &filename, AudacityProject*)
+{
+   SF_INFO info;
+   auto file = OpenSndFile(filename, info);
+   if (!file)
+      return nullptr;
 
    // Success, so now transfer the duty to close the file from "file".
    return std::make_unique<PCMImportFileHandle>(filename, std::move(file), info);
@@ -306,7 +563,6 @@ ProgressResult PCMImportFileHandle::Import(WaveTrackFactory *trackFactory,
 
    auto fileTotalFrames =
       (sampleCount)mInfo.frames; // convert from sf_count_t
-   auto maxBlockSize = channels.begin()->get()->GetMaxBlockSize();
    auto updateResult = ProgressResult::Cancelled;
 
    {
@@ -314,71 +570,47 @@ ProgressResult PCMImportFileHandle::Import(WaveTrackFactory *trackFactory,
       // samples from the file and store our own local copy of the
       // samples in the tracks.
 
-      // PRL:  guard against excessive memory buffer allocation in case of many channels
-      using type = decltype(maxBlockSize);
       if (mInfo.channels < 1)
          return ProgressResult::Failed;
-      auto maxBlock = std::min(maxBlockSize,
-         std::numeric_limits<type>::max() /
-            (mInfo.channels * SAMPLE_SIZE(mFormat))
-      );
-      if (maxBlock < 1)
-         return ProgressResult::Failed;
 
-      SampleBuffer srcbuffer, buffer;
-      wxASSERT(mInfo.channels >= 0);
-      while (NULL == srcbuffer.Allocate(maxBlock * mInfo.channels, mFormat).ptr() ||
-             NULL == buffer.Allocate(maxBlock, mFormat).ptr())
-      {
-         maxBlock /= 2;
-         if (maxBlock < 1)
-            return ProgressResult::Failed;
+      // Decode in another thread, while this thread appends to the tracks.
+      // Decoding may have started already, when this file followed another
+      // of a batch.
+      std::unique_ptr<PCMDecoder> pDecoder;
+      const auto pBatch = Importer::Batch::Current();
+      if (pBatch) {
+         auto pPrefetch = pBatch->TakePrefetch(mFilename);
+         if (auto p = dynamic_cast<PCMDecoder*>(pPrefetch.get());
+             p && p->Matches(mInfo, mFormat)) {
+            pPrefetch.release();
+            pDecoder.reset(p);
+         }
       }
+      if (!pDecoder)
+         pDecoder = std::make_unique<PCMDecoder>(mFile.get(), mInfo, mFormat);
+      if (pBatch)
+         PrefetchFollowing(*pBatch, mFilename);
 
       decltype(fileTotalFrames) framescompleted = 0;
 
-      long block;
-      do {
-         block = maxBlock;
-
-         if (mFormat == int16Sample)
-            block = SFCall<sf_count_t>(sf_readf_short, mFile.get(), (short *)srcbuffer.ptr(), block);
-         //import 24 bit int as float and have the append function convert it.  This is how PCMAliasBlockFile worked too.
-         else
-            block = SFCall<sf_count_t>(sf_readf_float, mFile.get(), (float *)srcbuffer.ptr(), block);
-
-         if(block < 0 || block > (long)maxBlock) {
-            wxASSERT(false);
-            block = maxBlock;
-         }
+      while (true) {
+         const auto &chunk = pDecoder->Next();
 
-         if (block) {
+         if (chunk.length) {
             auto iter = channels.begin();
-            for(int c=0; c<mInfo.channels; ++iter, ++c) {
-               if (mFormat==int16Sample) {
-                  for(int j=0; j<block; j++)
-                     ((short *)buffer.ptr())[j] =
-                        ((short *)srcbuffer.ptr())[mInfo.channels*j+c];
-               }
-               else {
-                  for(int j=0; j<block; j++)
-                     ((float *)buffer.ptr())[j] =
-                        ((float *)srcbuffer.ptr())[mInfo.channels*j+c];
-               }
-
-               iter->get()->Append(buffer.ptr(), (mFormat == int16Sample)?int16Sample:floatSample, block);
-            }
-            framescompleted += block;
+            for(int c=0; c<mInfo.channels; ++iter, ++c)
+               iter->get()->Append(chunk.buffers[c].ptr(),
+                  pDecoder->ReadFormat(), chunk.length);
+            framescompleted += chunk.length;
          }
 
          updateResult = mProgress->Update(
             framescompleted.as_long_long(),
             fileTotalFrames.as_long_long()
          );
-         if (updateResult != ProgressResult::Success)
+         if (updateResult != ProgressResult::Success || chunk.length == 0)
             break;
-
-      } while (block > 0);
+      }
    }
 
    if (updateResult == ProgressResult::Failed || updateResult == ProgressResult::Cancelled) {
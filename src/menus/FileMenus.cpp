@@ -146,6 +146,9 @@ void DoImport(const CommandContext &context, bool isRaw)
       window.HandleResize(); // Adjust scrollers for NEW track sizes.
    } );
 
+   // Let importers decode the next files while earlier ones are imported
+   Importer::Batch batch{ selectedFiles };
+
    for (size_t ff = 0; ff < selectedFiles.size(); ff++) {
       wxString fileName = selectedFiles[ff];
 
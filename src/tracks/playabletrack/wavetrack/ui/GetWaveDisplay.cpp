@@ -12,7 +12,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <float.h>
+#include <vector>
 #include <wx/debug.h>
 #include "SampleBlock.h"
 #include "SampleCount.h"
@@ -59,6 +61,128 @@ struct MinMaxSumsq
    float sumsq;
 };
 
+//! Statistics of parts of blocks, from their 64k summaries, remembering the
+//! summaries of the last block, which is often shared by adjacent columns
+class PartialBlockSummaries
+{
+public:
+   //! Statistics of block-relative samples from up to but excluding to
+   MinMaxSumSq Get(SampleBlock &block, size_t b, size_t from, size_t to)
+   {
+      constexpr size_t frameSize = 65536;
+      if (b != mBlock) {
+         mBlock = b;
+         mLength = block.GetSampleCount();
+         const auto frames = (mLength + frameSize - 1) / frameSize;
+         mTriples.resize(3 * frames);
+         // This function fills with zeroes if read fails
+         block.GetSummary64k(mTriples.data(), 0, frames);
+      }
+
+      to = std::min(to, mLength);
+      MinMaxSumSq result;
+      for (auto frame = from / frameSize; frame * frameSize < to; ++frame) {
+         const float *const triple = &mTriples[3 * frame];
+         // Weight the rms by the samples of the frame in the range
+         const auto overlap = std::min(to, (frame + 1) * frameSize) -
+            std::max(from, frame * frameSize);
+         result = Combine(result, {
+            triple[0], triple[1], double(triple[2]) * triple[2] * overlap });
+      }
+      return result;
+   }
+
+private:
+   std::vector<float> mTriples;
+   size_t mBlock{ SIZE_MAX };
+   size_t mLength{ 0 };
+};
+
+//! GetWaveDisplay for columns that each span at least the maximum block size
+/*!
+ Whole blocks within a column are combined from the summary pyramid of the
+ sequence, and only the blocks partly covered at the ends of columns need their
+ own summaries, so the cost is proportional to the number of columns and does
+ not grow with the duration.
+ */
+void GetZoomedOutWaveDisplay(const Sequence &sequence,
+   float *min, float *max, float *rms, int* bl,
+   size_t len, const sampleCount *where, sampleCount s0, sampleCount s1)
+{
+   const auto &blocks = sequence.GetBlockArray();
+   const auto blockEnd = [&](size_t b){
+      return blocks[b].start + blocks[b].sb->GetSampleCount();
+   };
+
+   PartialBlockSummaries partial;
+   const auto partialStatistics = [&](size_t b, sampleCount s, sampleCount e){
+      const auto start = blocks[b].start;
+      return partial.Get(*blocks[b].sb, b,
+         (s - start).as_size_t(), (e - start).as_size_t());
+   };
+
+   for (size_t pixel = 0; pixel < len; ++pixel) {
+      // The same defenses as below to be sure each column gets at least
+      // one sample
+      const auto s = std::clamp(where[pixel], s0, s1 - 1);
+      const auto e = std::clamp(where[pixel + 1], s + 1, s1);
+      const int firstBlock = sequence.FindBlock(s);
+      size_t b0 = firstBlock;
+      size_t b1 = sequence.FindBlock(e - 1) + 1;
+
+      MinMaxSumSq values;
+      if (b1 == b0 + 1)
+         values = partialStatistics(b0, s, e);
+      else {
+         // Partly covered blocks at the ends
+         if (s > blocks[b0].start) {
+            values = partialStatistics(b0, s, blockEnd(b0));
+            ++b0;
+         }
+         if (e < blockEnd(b1 - 1)) {
+            --b1;
+            values = Combine(values,
+               partialStatistics(b1, blocks[b1].start, e));
+         }
+         // Whole blocks between
+         if (b1 > b0)
+            values = Combine(values, sequence.GetBlocksSummary(b0, b1));
+      }
+
+      min[pixel] = values.min;
+      max[pixel] = values.max;
+      rms[pixel] = sqrt(values.sumsq / (e - s).as_double());
+      bl[pixel] = firstBlock;
+   }
+}
+
+}
+
+void GetBlockWaveDisplay(const Sequence &sequence,
+   float *min, float *max, float *rms, int* bl,
+   size_t len, const sampleCount *where)
+{
+   const auto numSamples = sequence.GetNumSamples();
+   const auto &blocks = sequence.GetBlockArray();
+   for (size_t pixel = 0; pixel < len; ++pixel) {
+      if (numSamples == 0) {
+         min[pixel] = max[pixel] = rms[pixel] = 0;
+         bl[pixel] = 0;
+         continue;
+      }
+      const auto s = std::clamp(where[pixel], sampleCount(0), numSamples - 1);
+      const auto e = std::clamp(where[pixel + 1], s + 1, numSamples);
+      const int b0 = sequence.FindBlock(s);
+      const int b1 = sequence.FindBlock(e - 1) + 1;
+      const auto values = sequence.GetBlocksSummary(b0, b1);
+      const auto &lastBlock = blocks[b1 - 1];
+      const auto count = lastBlock.start + lastBlock.sb->GetSampleCount()
+         - blocks[b0].start;
+      min[pixel] = values.min;
+      max[pixel] = values.max;
+      rms[pixel] = sqrt(values.sumsq / count.as_double());
+      bl[pixel] = b0;
+   }
 }
 
 bool GetWaveDisplay(const Sequence &sequence,
@@ -77,6 +201,12 @@ bool GetWaveDisplay(const Sequence &sequence,
    // ... unless the mNumSamples ceiling applies, and then there are other defenses
    const auto s1 = std::clamp(where[len], 1 + where[len - 1], numSamples);
    const auto maxSamples = sequence.GetMaxBlockSize();
+
+   if ((s1 - s0).as_double() / len >= maxSamples) {
+      GetZoomedOutWaveDisplay(sequence, min, max, rms, bl, len, where, s0, s1);
+      return true;
+   }
+
    Floats temp{ maxSamples };
 
    decltype(len) pixel = 0;
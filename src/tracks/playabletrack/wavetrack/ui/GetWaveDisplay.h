@@ -26,4 +26,10 @@ bool GetWaveDisplay(const Sequence &sequence,
    float *min, float *max, float *rms, int* bl,
    size_t len, const sampleCount *where);
 
+// Like GetWaveDisplay, but quickly, and only roughly:  each column gets the
+// statistics of the whole blocks that it overlaps, which are kept in memory.
+void GetBlockWaveDisplay(const Sequence &sequence,
+   float *min, float *max, float *rms, int* bl,
+   size_t len, const sampleCount *where);
+
 #endif
@@ -10,11 +10,16 @@
 
 #include "SpectrumCache.h"
 
+#include <algorithm>
 #include <cmath>
+#include <map>
 #include "RealFFTf.h"
+#include "SampleBlock.h"
 #include "SampleTrackCache.h"
+#include "Sequence.h"
 #include "../../../../prefs/SpectrogramSettings.h"
 #include "Spectrum.h"
+#include "ThreadPool.h"
 #include "WaveClipUtilities.h"
 #include "WaveTrack.h"
 
@@ -101,7 +106,8 @@ bool SpecCache::CalculateOneSpectrum
     double offset, double rate, double pixelsPerSecond,
     int lowerBoundX, int upperBoundX,
     const std::vector<float> &gainFactors,
-    float* __restrict scratch, float* __restrict out) const
+    float* __restrict scratch, float* __restrict out,
+    Contributions *pContributions) const
 {
    bool result = false;
    const bool reassignment =
@@ -283,13 +289,13 @@ bool SpecCache::CalculateOneSpectrum
 
                   // This is non-negative, because bin and correctedX are
                   auto ind = (int)nBins * correctedX + bin;
-#ifdef _OPENMP
-                  // This assignment can race if index reaches into another thread's bins.
-                  // The probability of a race very low, so this carries little overhead,
-                  // about 5% slower vs allowing it to race.
-                  #pragma omp atomic update
-#endif
-                  out[ind] += power;
+                  // Columns of other chunks may be computed by other
+                  // threads, so additions there are deferred
+                  if (pContributions && (correctedX < pContributions->beginX
+                        || correctedX >= pContributions->endX))
+                     pContributions->deferred.emplace_back(ind, power);
+                  else
+                     out[ind] += power;
                }
             }
          }
@@ -345,7 +351,8 @@ void SpecCache::Populate
    (const SpectrogramSettings &settings, SampleTrackCache &waveTrackCache,
     int copyBegin, int copyEnd, size_t numPixels,
     sampleCount numSamples,
-    double offset, double rate, double pixelsPerSecond)
+    double offset, double rate, double pixelsPerSecond,
+    ThreadPool &pool)
 {
    const int &frequencyGainSetting = settings.frequencyGain;
    const size_t windowSizeSetting = settings.WindowSize();
@@ -374,41 +381,43 @@ void SpecCache::Populate
       const int lowerBoundX = jj == 0 ? 0 : copyEnd;
       const int upperBoundX = jj == 0 ? copyBegin : numPixels;
 
-#ifdef _OPENMP
-      // Storage for mutable per-thread data.
-      // private clause ensures one copy per thread
-      struct ThreadLocalStorage {
-         ThreadLocalStorage()  { }
-         ~ThreadLocalStorage() { }
-
-         void init(SampleTrackCache &waveTrackCache, size_t scratchSize) {
-            if (!cache) {
-               cache = std::make_unique<SampleTrackCache>(waveTrackCache.GetTrack());
-               scratch.resize(scratchSize);
-            }
+      // Divide the columns into contiguous chunks of a fixed size, not
+      // depending on the number of threads
+      constexpr int ChunkColumns = 32;
+      const int nColumns = std::max(0, upperBoundX - lowerBoundX);
+      const size_t nChunks = (nColumns + ChunkColumns - 1) / ChunkColumns;
+      const auto chunkBegin = [&](size_t chunk) {
+         return std::min(upperBoundX, lowerBoundX + int(chunk) * ChunkColumns);
+      };
+
+      // Reassigned powers within the columns of a chunk are added at once.
+      // Those that cross into other chunks are added afterwards, in order of
+      // chunks, making the same sums whatever the number of threads.
+      std::vector<Contributions> contributions(reassignment ? nChunks : 0);
+
+      pool.ParallelFor(nChunks, [&](size_t chunk) {
+         // Mutable state for this chunk only; SampleTrackCache reads the
+         // samples for consecutive columns efficiently
+         SampleTrackCache cache{ waveTrackCache.GetTrack() };
+         std::vector<float> buffer(scratchSize);
+         const auto begin = chunkBegin(chunk), end = chunkBegin(chunk + 1);
+         Contributions *pContributions = nullptr;
+         if (reassignment) {
+            pContributions = &contributions[chunk];
+            pContributions->beginX = begin;
+            pContributions->endX = end;
          }
-         std::unique_ptr<SampleTrackCache> cache;
-         std::vector<float> scratch;
-      } tls;
-
-      #pragma omp parallel for private(tls)
-#endif
-      for (auto xx = lowerBoundX; xx < upperBoundX; ++xx)
-      {
-#ifdef _OPENMP
-         tls.init(waveTrackCache, scratchSize);
-         SampleTrackCache& cache = *tls.cache;
-         float* buffer = &tls.scratch[0];
-#else
-         SampleTrackCache& cache = waveTrackCache;
-         float* buffer = &scratch[0];
-#endif
-         CalculateOneSpectrum(
-            settings, cache, xx, numSamples,
-            offset, rate, pixelsPerSecond,
-            lowerBoundX, upperBoundX,
-            gainFactors, buffer, &freq[0]);
-      }
+         for (auto xx = begin; xx < end; ++xx)
+            CalculateOneSpectrum(
+               settings, cache, xx, numSamples,
+               offset, rate, pixelsPerSecond,
+               lowerBoundX, upperBoundX,
+               gainFactors, buffer.data(), &freq[0], pContributions);
+      });
+
+      for (const auto &chunkContributions : contributions)
+         for (const auto &[ind, power] : chunkContributions.deferred)
+            freq[ind] += power;
 
       if (reassignment) {
          // Need to look beyond the edges of the range to accumulate more
@@ -444,9 +453,6 @@ void SpecCache::Populate
 
          // Now Convert to dB terms.  Do this only after accumulating
          // power values, which may cross columns with the time correction.
-#ifdef _OPENMP
-         #pragma omp parallel for
-#endif
          for (xx = lowerBoundX; xx < upperBoundX; ++xx) {
             float *const results = &freq[nBins * xx];
             for (size_t ii = 0; ii < nBins; ++ii) {
@@ -576,10 +582,22 @@ bool WaveClipSpectrumCache::GetSpectrogram(const WaveClip &clip,
    fillWhere(mSpecCache->where, numPixels, 0.5, correction,
       t0, rate, samplesPerPixel);
 
-   mSpecCache->Populate
-      (settings, waveTrackCache, copyBegin, copyEnd, numPixels,
-       clip.GetSequenceSamplesCount(),
-       clip.GetSequenceStartTime(), rate, pixelsPerSecond);
+   // Zoomed out far enough, take columns from tiles that outlive this cache.
+   // Reassignment moves power between columns, so can't use them.
+   const auto hop = SpectrumTileCache::Hop(settings, samplesPerPixel);
+   const auto pTracks = track->GetOwner();
+   const auto pProject = pTracks ? pTracks->GetOwner() : nullptr;
+   if (hop > 0 && pProject &&
+       settings.algorithm != SpectrogramSettings::algReassignment)
+      PopulateFromTiles(clip, waveTrackCache,
+         SpectrumTileCache::Get(*pProject), settings, hop,
+         copyBegin, copyEnd, numPixels, pixelsPerSecond);
+   else
+      mSpecCache->Populate
+         (settings, waveTrackCache, copyBegin, copyEnd, numPixels,
+          clip.GetSequenceSamplesCount(),
+          clip.GetSequenceStartTime(), rate, pixelsPerSecond,
+          ThreadPool::Get());
 
    mSpecCache->dirty = mDirty;
    spectrogram = &mSpecCache->freq[0];
@@ -588,6 +606,149 @@ bool WaveClipSpectrumCache::GetSpectrogram(const WaveClip &clip,
    return true;
 }
 
+void WaveClipSpectrumCache::PopulateFromTiles(const WaveClip &clip,
+   SampleTrackCache &waveTrackCache, SpectrumTileCache &tiles,
+   const SpectrogramSettings &settings, size_t hop,
+   int copyBegin, int copyEnd, size_t numPixels, double pixelsPerSecond)
+{
+   auto &cache = *mSpecCache;
+   const auto &blocks = clip.GetSequence()->GetBlockArray();
+   const auto numSamples = clip.GetSequenceSamplesCount();
+   const auto rate = clip.GetRate();
+   const auto nBins = settings.NBins();
+   const auto windowSize = settings.WindowSize();
+   const auto prefix = SpectrumTileCache::KeyPrefix(settings, hop, rate);
+
+   // Columns are read from the track, which gives zeroes or other clips
+   // outside of the play region.  So a tile depends only on its blocks if
+   // the windows of all its columns lie within the play region.
+   const auto playStart = clip.ToSequenceSamples(clip.GetPlayStartSample());
+   const auto playEnd = playStart + clip.GetPlaySamplesCount();
+
+   mTiles.resize(blocks.size());
+
+   // Columns of missing tiles, and columns that no tile can give, are
+   // computed together
+   std::vector<sampleCount> positions;
+
+   struct TileColumns {
+      SpectrumTileCache::TilePtr pTile;
+      size_t nColumns{ 0 };
+      //! Index in positions of the first column, if the tile is missing
+      size_t first{ 0 };
+      bool usable{ false };
+   };
+   std::map<size_t, TileColumns> blockTiles;
+   std::vector<size_t> missing;
+
+   const auto getTile = [&](size_t iBlock) -> const TileColumns & {
+      auto [iter, inserted] = blockTiles.try_emplace(iBlock);
+      auto &tile = iter->second;
+      if (!inserted)
+         return tile;
+
+      const auto &block = blocks[iBlock];
+      const auto start = block.start;
+      tile.nColumns = (block.sb->GetSampleCount() + hop - 1) / hop;
+      // Range of the samples read by the windows of the columns
+      const auto from = start - windowSize / 2;
+      const auto to = from + sampleCount((tile.nColumns - 1) * hop + windowSize);
+      // Blocks not yet committed have no id
+      if (block.sb->GetBlockID() == 0 || from < playStart || to > playEnd)
+         return tile;
+      tile.usable = true;
+
+      auto first = iBlock, last = iBlock;
+      while (first > 0 && blocks[first].start > from)
+         --first;
+      while (last + 1 < blocks.size() && blocks[last + 1].start < to)
+         ++last;
+      auto key = prefix;
+      for (auto ii = first; ii <= last; ++ii) {
+         if (ii > first)
+            key += ',';
+         key += SpectrumTileCache::BlockKey(*blocks[ii].sb);
+      }
+
+      const auto size = tile.nColumns * nBins;
+      auto &[oldKey, pOldTile] = mTiles[iBlock];
+      if (pOldTile && oldKey == key)
+         tile.pTile = pOldTile;
+      else {
+         tile.pTile = tiles.Find(key, size);
+         mTiles[iBlock] = { std::move(key), tile.pTile };
+      }
+
+      if (!tile.pTile) {
+         tile.first = positions.size();
+         for (size_t ii = 0; ii < tile.nColumns; ++ii)
+            positions.push_back(start + sampleCount(ii * hop));
+         missing.push_back(iBlock);
+      }
+      return tile;
+   };
+
+   // For each dirty column, either a tile and its nearest column, or null
+   // and an index in positions
+   std::vector<std::pair<const TileColumns *, size_t>> sources(numPixels);
+   for (int jj = 0; jj < 2; ++jj) {
+      const int lowerBoundX = jj == 0 ? 0 : copyEnd;
+      const int upperBoundX = jj == 0 ? copyBegin : numPixels;
+      for (auto xx = lowerBoundX; xx < upperBoundX; ++xx) {
+         const auto position = cache.where[xx];
+         auto &source = sources[xx];
+         if (position >= 0 && position < numSamples) {
+            const auto iBlock = blocks.FindBlock(position);
+            const auto &tile = getTile(iBlock);
+            if (tile.usable) {
+               const auto column = std::llround(
+                  (position - blocks[iBlock].start).as_double() / hop);
+               source = { &tile, std::min<size_t>(column, tile.nColumns - 1) };
+               continue;
+            }
+         }
+         source = { nullptr, positions.size() };
+         positions.push_back(position);
+      }
+   }
+
+   SpecCache computed;
+   if (!positions.empty()) {
+      const auto nPositions = positions.size();
+      computed.Grow(nPositions, settings, pixelsPerSecond, 0);
+      std::copy(positions.begin(), positions.end(), computed.where.begin());
+      computed.where[nPositions] = positions.back();
+      computed.Populate(settings, waveTrackCache, 0, 0, nPositions,
+         numSamples, clip.GetSequenceStartTime(), rate, pixelsPerSecond,
+         ThreadPool::Get());
+
+      std::vector<std::pair<std::string, SpectrumTileCache::TilePtr>>
+         newTiles;
+      for (auto iBlock : missing) {
+         auto &tile = blockTiles[iBlock];
+         const auto begin = computed.freq.begin() + tile.first * nBins;
+         tile.pTile = std::make_shared<SpectrumTileCache::Tile>(
+            begin, begin + tile.nColumns * nBins);
+         auto &[key, pTile] = mTiles[iBlock];
+         pTile = tile.pTile;
+         newTiles.emplace_back(key, pTile);
+      }
+      tiles.Store(newTiles);
+   }
+
+   for (int jj = 0; jj < 2; ++jj) {
+      const int lowerBoundX = jj == 0 ? 0 : copyEnd;
+      const int upperBoundX = jj == 0 ? copyBegin : numPixels;
+      for (auto xx = lowerBoundX; xx < upperBoundX; ++xx) {
+         const auto [pTile, column] = sources[xx];
+         const auto results = pTile
+            ? pTile->pTile->data() + nBins * column
+            : &computed.freq[nBins * column];
+         std::copy(results, results + nBins, &cache.freq[nBins * xx]);
+      }
+   }
+}
+
 WaveClipSpectrumCache::WaveClipSpectrumCache()
 : mSpecCache{ std::make_unique<SpecCache>() }
 , mSpecPxCache{ std::make_unique<SpecPxCache>(1) }
@@ -611,10 +772,13 @@ WaveClipSpectrumCache &WaveClipSpectrumCache::Get( const WaveClip &clip )
 void WaveClipSpectrumCache::MarkChanged()
 {
    ++mDirty;
+   // Tiles stay in the project, but those of changed blocks have new keys
+   mTiles.clear();
 }
 
 void WaveClipSpectrumCache::Invalidate()
 {
    // Invalidate the spectrum display cache
    mSpecCache = std::make_unique<SpecCache>();
+   mTiles.clear();
 }
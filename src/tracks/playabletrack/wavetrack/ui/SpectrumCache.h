@@ -14,9 +14,12 @@
 class sampleCount;
 class SpectrogramSettings;
 class SampleTrackCache;
+class ThreadPool;
 
+#include <utility>
 #include <vector>
 #include "MemoryX.h"
+#include "SpectrumTileCache.h"
 #include "WaveClip.h" // to inherit WaveClipListener
 
 using Floats = ArrayOf<float>;
@@ -42,7 +45,17 @@ public:
    bool Matches(int dirty_, double pixelsPerSecond,
       const SpectrogramSettings &settings, double rate) const;
 
+   //! Reassigned powers computed for one chunk of columns
+   struct Contributions {
+      //! The columns of the chunk, where powers are added directly
+      int beginX, endX;
+      //! Indices into freq in other columns, and powers to add there later
+      std::vector<std::pair<size_t, double>> deferred;
+   };
+
    // Calculate one column of the spectrum
+   // If pContributions is not null, reassigned powers for columns outside
+   // its range are appended to it instead of being added into out
    bool CalculateOneSpectrum
       (const SpectrogramSettings &settings,
        SampleTrackCache &waveTrackCache,
@@ -51,18 +64,23 @@ public:
        int lowerBoundX, int upperBoundX,
        const std::vector<float> &gainFactors,
        float* __restrict scratch,
-       float* __restrict out) const;
+       float* __restrict out,
+       Contributions *pContributions = nullptr) const;
 
    // Grow the cache while preserving the (possibly now invalid!) contents
    void Grow(size_t len_, const SpectrogramSettings& settings,
                double pixelsPerSecond, double start_);
 
    // Calculate the dirty columns at the begin and end of the cache
+   // Columns are divided into chunks of a fixed size, computed by the
+   // threads of the pool, each with its own scratch space and
+   // SampleTrackCache; results don't depend on the number of threads
    void Populate
       (const SpectrogramSettings &settings, SampleTrackCache &waveTrackCache,
        int copyBegin, int copyEnd, size_t numPixels,
        sampleCount numSamples,
-       double offset, double rate, double pixelsPerSecond);
+       double offset, double rate, double pixelsPerSecond,
+       ThreadPool &pool);
 
    size_t       len { 0 }; // counts pixels, not samples
    int          algorithm;
@@ -124,6 +142,18 @@ struct WaveClipSpectrumCache final : WaveClipListener
                        const sampleCount *& where,
                        size_t numPixels,
                        double t0, double pixelsPerSecond);
+
+private:
+   //! Fill the dirty columns of mSpecCache from tiles, computing and storing
+   //! the missing tiles
+   void PopulateFromTiles(const WaveClip &clip, SampleTrackCache &cache,
+      SpectrumTileCache &tiles, const SpectrogramSettings &settings,
+      size_t hop, int copyBegin, int copyEnd, size_t numPixels,
+      double pixelsPerSecond);
+
+   //! Keys and tiles of the last drawing, by block index; cleared when the
+   //! blocks of the clip change
+   std::vector<std::pair<std::string, SpectrumTileCache::TilePtr>> mTiles;
 };
 
 #endif
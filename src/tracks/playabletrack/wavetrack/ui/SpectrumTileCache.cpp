@@ -0,0 +1,429 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SpectrumTileCache.cpp
+  @brief Spectrogram columns of whole sample blocks, kept between zooms
+
+**********************************************************************/
+
+#include "SpectrumTileCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sqlite3.h>
+#include <wx/filefn.h>
+#include <wx/log.h>
+
+#include "MemoryX.h"
+#include "Project.h"
+#include "../../../../ProjectFileIO.h"
+#include "SampleBlock.h"
+#include "UndoManager.h"
+#include "WaveTrack.h"
+#include "../../../../prefs/SpectrogramSettings.h"
+
+namespace {
+// CREATE SQL spectrumtiles
+// key identifies settings and blocks, see SpectrumTileCache.
+// used orders tiles from least to most recently used.
+// columns is an array of float, column-major as in SpecCache.
+// Tiles can be computed again, so the file is not synced, but it keeps a
+// rollback journal, so that a crash does not damage it.
+const char *TileSchema =
+   "PRAGMA synchronous = OFF;"
+   "CREATE TABLE IF NOT EXISTS spectrumtiles"
+   "("
+   "  key                  TEXT PRIMARY KEY,"
+   "  used                 INTEGER,"
+   "  columns              BLOB"
+   ");"
+   "CREATE INDEX IF NOT EXISTS spectrumtiles_used ON spectrumtiles (used);";
+
+//! Bound on the memory used by the most recently used tiles
+constexpr size_t MemoryLimit = 128 * 1024 * 1024;
+
+//! Bound on the size of the tiles in the database
+constexpr size_t DiskLimit = 1024 * 1024 * 1024;
+
+const AudacityProject::AttachedObjects::RegisteredFactory key{
+   [](AudacityProject &project) {
+      return std::make_unique<SpectrumTileCache>(project);
+   }
+};
+
+//! Rewinds a statement, when leaving scope
+struct StatementReset {
+   ~StatementReset()
+   {
+      // Clear statement bindings and rewind statement
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+   }
+   sqlite3_stmt *const stmt;
+};
+}
+
+SpectrumTileCache &SpectrumTileCache::Get( const AudacityProject &project )
+{
+   return const_cast< AudacityProject & >( project )
+      .AttachedObjects::Get< SpectrumTileCache >( key );
+}
+
+SpectrumTileCache::SpectrumTileCache( AudacityProject &project )
+   : mProject{ project }
+{
+   mUndoSubscription = UndoManager::Get(project)
+      .Subscribe([this](UndoRedoMessage message){
+         // Purging undo states is when blocks go away
+         if (message.type == UndoRedoMessage::Purge)
+            PruneDeadBlocks();
+      });
+}
+
+SpectrumTileCache::~SpectrumTileCache()
+{
+   Close();
+}
+
+size_t SpectrumTileCache::Hop(
+   const SpectrogramSettings &settings, double samplesPerPixel )
+{
+   // Powers of two times the window size, so that zooming in or out by
+   // factors of two reuses the same tiles.  There may be up to two columns
+   // of the tiles in each pixel.  Columns closer than the window size would
+   // make too many to store.
+   size_t hop = settings.WindowSize();
+   if (hop == 0 || samplesPerPixel < hop)
+      return 0;
+   while (2 * hop <= samplesPerPixel)
+      hop *= 2;
+   return hop;
+}
+
+std::string SpectrumTileCache::KeyPrefix(
+   const SpectrogramSettings &settings, size_t hop, double rate )
+{
+   // Everything besides the samples that changes the computed columns
+   return std::to_string(settings.algorithm) + ',' +
+      std::to_string(settings.windowType) + ',' +
+      std::to_string(settings.WindowSize()) + ',' +
+      std::to_string(settings.ZeroPaddingFactor()) + ',' +
+      std::to_string(settings.frequencyGain) + ',' +
+      std::to_string(hop) + ',' +
+      std::to_string(rate) + ':';
+}
+
+std::string SpectrumTileCache::BlockKey( const SampleBlock &block )
+{
+   // Nine significant digits write any float exactly
+   const auto stats = block.GetMinMaxRMS(false);
+   char buffer[100];
+   snprintf(buffer, sizeof(buffer), "%lld/%.9g/%.9g/%.9g",
+      static_cast<long long>(block.GetBlockID()),
+      stats.min, stats.max, stats.RMS);
+   return buffer;
+}
+
+std::string SpectrumTileCache::FileName( const std::string &projectFileName )
+{
+   return projectFileName + "-spectrogram";
+}
+
+auto SpectrumTileCache::Find( const std::string &key, size_t size ) -> TilePtr
+{
+   if (auto iter = mIndex.find(key); iter != mIndex.end()) {
+      mRecent.splice(mRecent.begin(), mRecent, iter->second);
+      const auto &pTile = iter->second->second;
+      return pTile->size() == size ? pTile : nullptr;
+   }
+
+   if (!DB())
+      return nullptr;
+
+   // BIND SQL spectrumtiles
+   const auto stmt = Prepare(mFindStatement,
+      "SELECT columns FROM spectrumtiles WHERE key = ?1;");
+   if (!stmt)
+      return nullptr;
+
+   TilePtr pTile;
+   {
+      StatementReset reset{ stmt };
+      if (sqlite3_bind_text(stmt, 1, key.c_str(), key.size(), SQLITE_STATIC)
+          != SQLITE_OK ||
+          sqlite3_step(stmt) != SQLITE_ROW)
+         return nullptr;
+
+      const auto blob = sqlite3_column_blob(stmt, 0);
+      const auto bytes = size_t(sqlite3_column_bytes(stmt, 0));
+      if (!blob || bytes != size * sizeof(float))
+         return nullptr;
+      auto pNewTile = std::make_shared<Tile>(size);
+      memcpy(pNewTile->data(), blob, bytes);
+      pTile = std::move(pNewTile);
+   }
+
+   // BIND SQL spectrumtiles
+   if (const auto touch = Prepare(mTouchStatement,
+         "UPDATE spectrumtiles SET used = ?2 WHERE key = ?1;")) {
+      StatementReset reset{ touch };
+      if (sqlite3_bind_text(touch, 1, key.c_str(), key.size(), SQLITE_STATIC)
+             == SQLITE_OK &&
+          sqlite3_bind_int64(touch, 2, ++mUseCount) == SQLITE_OK)
+         sqlite3_step(touch);
+   }
+
+   Remember(key, pTile);
+   return pTile;
+}
+
+void SpectrumTileCache::Store(
+   const std::vector<std::pair<std::string, TilePtr>> &tiles )
+{
+   if (tiles.empty())
+      return;
+
+   for (const auto &[key, pTile] : tiles)
+      Remember(key, pTile);
+
+   const auto db = DB();
+   if (!db)
+      return;
+
+   // BIND SQL spectrumtiles
+   const auto stmt = Prepare(mStoreStatement,
+      "INSERT OR REPLACE INTO spectrumtiles (key, used, columns)"
+      " VALUES(?1, ?2, ?3);");
+   if (!stmt)
+      return;
+
+   // All tiles of one drawing in one transaction
+   sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+   for (const auto &[key, pTile] : tiles) {
+      StatementReset reset{ stmt };
+      const auto bytes = pTile->size() * sizeof(float);
+      if (sqlite3_bind_text(stmt, 1, key.c_str(), key.size(), SQLITE_STATIC)
+          != SQLITE_OK ||
+          sqlite3_bind_int64(stmt, 2, ++mUseCount) != SQLITE_OK ||
+          sqlite3_bind_blob(stmt, 3, pTile->data(), bytes, SQLITE_STATIC)
+          != SQLITE_OK ||
+          sqlite3_step(stmt) != SQLITE_DONE) {
+         wxLogMessage("Failed to store spectrogram tile\n"
+                      "\tError: %s",
+                      sqlite3_errmsg(db));
+         break;
+      }
+      // A replaced tile is counted twice until the next eviction
+      mDiskBytes += bytes;
+   }
+   sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+
+   if (mDiskBytes > DiskLimit)
+      Evict();
+}
+
+sqlite3 *SpectrumTileCache::DB()
+{
+   auto &projectFileIO = ProjectFileIO::Get(mProject);
+   const std::string projectFileName{ projectFileIO.GetFileName().ToUTF8() };
+   if (projectFileName != mProjectFileName) {
+      // The project was saved under another name, or has no file yet
+      Close();
+      mProjectFileName = projectFileName;
+      mTemporary = projectFileIO.IsTemporary();
+      mOpenFailed = projectFileName.empty();
+   }
+
+   if (!mDB && !mOpenFailed) {
+      const auto fileName = FileName(mProjectFileName);
+      const auto open = [&]{
+         if (sqlite3_open(fileName.c_str(), &mDB) == SQLITE_OK &&
+             sqlite3_exec(mDB, TileSchema, nullptr, nullptr, nullptr)
+                == SQLITE_OK)
+            return true;
+         wxLogMessage("Failed to open database of spectrogram tiles\n"
+                      "\tPath: %s\n"
+                      "\tError: %s",
+                      fileName, sqlite3_errmsg(mDB));
+         sqlite3_close(mDB);
+         mDB = nullptr;
+         return false;
+      };
+      // Tiles can be computed again, so make the file again if it is damaged
+      if (!open() &&
+          !(wxRemoveFile(wxString::FromUTF8(fileName.c_str())) && open()))
+         mOpenFailed = true;
+      else {
+         // Continue the order of use of the tiles found, and bound them
+         sqlite3_exec(mDB, "SELECT max(used) FROM spectrumtiles;",
+            [](void *pUseCount, int, char **vals, char **) {
+               if (vals[0])
+                  *static_cast<long long*>(pUseCount) =
+                     std::strtoll(vals[0], nullptr, 10);
+               return 0;
+            }, &mUseCount, nullptr);
+         mDiskBytes = DiskBytes();
+         // Tiles may remain of blocks that were not saved
+         PruneDeadBlocks();
+         if (mDiskBytes > DiskLimit)
+            Evict();
+      }
+   }
+   return mDB;
+}
+
+void SpectrumTileCache::Close()
+{
+   for (auto &stmt : { &mFindStatement, &mTouchStatement,
+        &mStoreStatement, &mDeleteStatement }) {
+      sqlite3_finalize(*stmt);
+      *stmt = nullptr;
+   }
+   if (!mDB)
+      return;
+   sqlite3_close(mDB);
+   mDB = nullptr;
+   mUseCount = 0;
+   mDiskBytes = 0;
+
+   // A temporary project is deleted when it closes, or moves when saved
+   if (mTemporary)
+      wxRemoveFile(wxString::FromUTF8(FileName(mProjectFileName).c_str()));
+}
+
+sqlite3_stmt *SpectrumTileCache::Prepare(
+   sqlite3_stmt *&stmt, const char *sql )
+{
+   if (!stmt && mDB &&
+       sqlite3_prepare_v3(mDB, sql, -1, SQLITE_PREPARE_PERSISTENT,
+          &stmt, nullptr) != SQLITE_OK) {
+      wxLogMessage("Failed to prepare statement for spectrogram tiles\n"
+                   "\tError: %s",
+                   sqlite3_errmsg(mDB));
+      sqlite3_finalize(stmt);
+      stmt = nullptr;
+   }
+   return stmt;
+}
+
+void SpectrumTileCache::Evict()
+{
+   // Find the use below which tiles are deleted, freeing a quarter of the
+   // limit, so that eviction isn't needed again for a while
+   struct Search {
+      size_t excess;
+      long long used;
+   } search{ mDiskBytes - DiskLimit * 3 / 4, 0 };
+   sqlite3_exec(mDB,
+      "SELECT used, length(columns) FROM spectrumtiles ORDER BY used;",
+      [](void *pSearch, int, char **vals, char **) {
+         auto &search = *static_cast<Search*>(pSearch);
+         search.used = std::strtoll(vals[0], nullptr, 10);
+         const size_t bytes = std::strtoull(vals[1], nullptr, 10);
+         if (bytes >= search.excess)
+            // Stop here
+            return 1;
+         search.excess -= bytes;
+         return 0;
+      }, &search, nullptr);
+
+   const auto sql = "DELETE FROM spectrumtiles WHERE used <= " +
+      std::to_string(search.used) + ";";
+   sqlite3_exec(mDB, sql.c_str(), nullptr, nullptr, nullptr);
+   mDiskBytes = DiskBytes();
+}
+
+void SpectrumTileCache::PruneDeadBlocks()
+{
+   const auto active = WaveTrackFactory::Get(mProject)
+      .GetSampleBlockFactory()->GetActiveBlockIDs();
+   // Keys of blocks follow the prefix of the key, separated by commas, and
+   // each begins with the block id
+   const auto isDead = [&](const char *key) {
+      auto pos = strchr(key, ':');
+      while (pos) {
+         const auto id = std::strtoll(pos + 1, nullptr, 10);
+         if (id > 0 && active.count(id) == 0)
+            return true;
+         pos = strchr(pos + 1, ',');
+      }
+      return false;
+   };
+
+   for (auto iter = mRecent.begin(); iter != mRecent.end();) {
+      const auto &[key, pTile] = *iter;
+      if (isDead(key.c_str())) {
+         mBytes -= pTile->size() * sizeof(float);
+         mIndex.erase(key);
+         iter = mRecent.erase(iter);
+      }
+      else
+         ++iter;
+   }
+
+   if (!mDB)
+      return;
+
+   std::vector<std::string> dead;
+   auto pair = std::make_pair(&isDead, &dead);
+   sqlite3_exec(mDB, "SELECT key FROM spectrumtiles;",
+      [](void *pPair, int, char **vals, char **) {
+         auto &[pIsDead, pDead] = *static_cast<decltype(pair)*>(pPair);
+         if ((*pIsDead)(vals[0]))
+            pDead->emplace_back(vals[0]);
+         return 0;
+      }, &pair, nullptr);
+   if (dead.empty())
+      return;
+
+   // BIND SQL spectrumtiles
+   const auto stmt = Prepare(mDeleteStatement,
+      "DELETE FROM spectrumtiles WHERE key = ?1;");
+   if (!stmt)
+      return;
+   sqlite3_exec(mDB, "BEGIN;", nullptr, nullptr, nullptr);
+   for (const auto &key : dead) {
+      StatementReset reset{ stmt };
+      if (sqlite3_bind_text(stmt, 1, key.c_str(), key.size(), SQLITE_STATIC)
+          == SQLITE_OK)
+         sqlite3_step(stmt);
+   }
+   sqlite3_exec(mDB, "COMMIT;", nullptr, nullptr, nullptr);
+   mDiskBytes = DiskBytes();
+}
+
+size_t SpectrumTileCache::DiskBytes()
+{
+   size_t bytes = 0;
+   sqlite3_exec(mDB, "SELECT total(length(columns)) FROM spectrumtiles;",
+      [](void *pBytes, int, char **vals, char **) {
+         if (vals[0])
+            *static_cast<size_t*>(pBytes) =
+               static_cast<size_t>(std::strtod(vals[0], nullptr));
+         return 0;
+      }, &bytes, nullptr);
+   return bytes;
+}
+
+void SpectrumTileCache::Remember( const std::string &key, const TilePtr &pTile )
+{
+   if (auto iter = mIndex.find(key); iter != mIndex.end()) {
+      mBytes -= iter->second->second->size() * sizeof(float);
+      mRecent.erase(iter->second);
+      mIndex.erase(iter);
+   }
+   mRecent.emplace_front(key, pTile);
+   mIndex.emplace(key, mRecent.begin());
+   mBytes += pTile->size() * sizeof(float);
+
+   // Forget the least recently used, but not the newest.  Clips may still
+   // hold tiles that are forgotten here.
+   while (mBytes > MemoryLimit && mRecent.size() > 1) {
+      const auto &[oldKey, pOldTile] = mRecent.back();
+      mBytes -= pOldTile->size() * sizeof(float);
+      mIndex.erase(oldKey);
+      mRecent.pop_back();
+   }
+}
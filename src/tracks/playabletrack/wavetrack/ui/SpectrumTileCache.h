@@ -0,0 +1,127 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  @file SpectrumTileCache.h
+  @brief Spectrogram columns of whole sample blocks, kept between zooms
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SPECTRUM_TILE_CACHE__
+#define __AUDACITY_SPECTRUM_TILE_CACHE__
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ClientData.h" // to inherit
+#include "Observer.h"
+
+class AudacityProject;
+class SampleBlock;
+class SpectrogramSettings;
+struct sqlite3;
+struct sqlite3_stmt;
+
+//! Tiles of spectrogram columns, in memory and in a database beside the project
+/*!
+ A tile holds the columns computed for one sample block, at multiples of a
+ hop (in samples) from the start of the block.  So tiles don't depend on the
+ position of the block in its sequence, or on the exact zoom.
+
+ A tile is identified by a key made from the settings, the hop, and the ids
+ and extremes of all blocks that the windows of its columns read.  Any edit of
+ those samples makes new blocks, and so a different key.  The extremes guard
+ against ids used again after compaction of the project.
+
+ Tiles are written to a database in a file beside the project file, so that
+ they are found again when the project is opened again, without growing the
+ project file.  Its size is bounded by deleting the least recently used tiles,
+ and tiles of blocks that no undo state uses any more are deleted when undo
+ history is purged, and when the file is opened.  The file of a temporary
+ project is deleted with it; when the project is saved under another name,
+ tiles go to a file beside that.
+ */
+class AUDACITY_DLL_API SpectrumTileCache final : public ClientData::Base
+{
+public:
+   using Tile = std::vector<float>;
+   using TilePtr = std::shared_ptr<const Tile>;
+
+   //! The cache is mutable data, even for a const project
+   static SpectrumTileCache &Get( const AudacityProject &project );
+
+   explicit SpectrumTileCache( AudacityProject &project );
+   ~SpectrumTileCache() override;
+
+   //! Interval in samples between columns of tiles, for a zoom level
+   /*! @return 0 if columns are too close together for tiles to be used */
+   static size_t Hop(
+      const SpectrogramSettings &settings, double samplesPerPixel );
+
+   //! Start of the keys of tiles for the settings, hop, and sample rate
+   static std::string KeyPrefix(
+      const SpectrogramSettings &settings, size_t hop, double rate );
+
+   //! Part of the key for one of the blocks a tile reads
+   /*! The keys of a tile's blocks follow the prefix, separated by commas */
+   static std::string BlockKey( const SampleBlock &block );
+
+   //! Name of the file of tiles for a project file
+   static std::string FileName( const std::string &projectFileName );
+
+   //! Find a tile in memory or in the database
+   /*! @return null if there is no tile of the given size for the key */
+   TilePtr Find( const std::string &key, size_t size );
+
+   //! Remember computed tiles, and write them to the database
+   void Store( const std::vector<std::pair<std::string, TilePtr>> &tiles );
+
+private:
+   //! Open the database for the project file, and make its table, the first
+   //! time or when the project file changes
+   //! @return null if that fails
+   sqlite3 *DB();
+   //! Close the database, and delete its file if it belonged to a temporary
+   //! project
+   void Close();
+   //! Prepare the statement, the first time
+   //! @return null if that fails
+   sqlite3_stmt *Prepare( sqlite3_stmt *&stmt, const char *sql );
+   void Remember( const std::string &key, const TilePtr &pTile );
+   //! Delete least recently used tiles from the database, until it is well
+   //! within its bound
+   void Evict();
+   //! Forget tiles of blocks that are no longer in the project
+   void PruneDeadBlocks();
+   //! Total size of the tiles in the database
+   size_t DiskBytes();
+
+   AudacityProject &mProject;
+   Observer::Subscription mUndoSubscription;
+
+   sqlite3 *mDB{};
+   //! Project file for which the database was opened, or failed to open
+   std::string mProjectFileName;
+   bool mOpenFailed{ false };
+   bool mTemporary{ false };
+   sqlite3_stmt *mFindStatement{};
+   sqlite3_stmt *mTouchStatement{};
+   sqlite3_stmt *mStoreStatement{};
+   sqlite3_stmt *mDeleteStatement{};
+   //! Increases with each use of a tile in the database, ordering them for
+   //! eviction
+   long long mUseCount{ 0 };
+   size_t mDiskBytes{ 0 };
+
+   //! Most recently used first
+   using Entries = std::list<std::pair<std::string, TilePtr>>;
+   Entries mRecent;
+   std::unordered_map<std::string, Entries::iterator> mIndex;
+   size_t mBytes{ 0 };
+};
+
+#endif
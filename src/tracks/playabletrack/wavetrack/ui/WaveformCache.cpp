@@ -10,11 +10,50 @@
 
 #include "WaveformCache.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include "AudacityException.h"
+#include "BasicUI.h"
 #include "Sequence.h"
 #include "GetWaveDisplay.h"
+#include "ThreadPool.h"
 #include "WaveClipUtilities.h"
 
+namespace {
+//! Time for reading samples in one call of GetWaveDisplay, before the rest are
+//! estimated and read in the background
+constexpr std::chrono::milliseconds FetchBudget{ 4 };
+
+//! Columns read between checks of the time
+constexpr size_t FetchChunk = 64;
+
+//! Value in WaveCache::pending for an estimated column not yet requested
+constexpr int Provisional = -1;
+
+//! Don't report failures to read for drawing
+void IgnoreException(AudacityException *) {}
+}
+
+//! Columns read in the background for a WaveClipWaveformCache
+struct WaveFetch
+{
+   //! Null when the cache is destroyed; used only in the main thread
+   WaveClipWaveformCache *pCache{};
+   std::function<void()> onUpdate;
+   int id{ 0 };
+   int dirty{ 0 };
+
+   //! A copy of the clip's sequence sharing its blocks; made and destroyed
+   //! in the main thread
+   std::unique_ptr<Sequence> pSnapshot;
+
+   std::vector<sampleCount> where;
+   std::vector<float> min, max, rms;
+   std::vector<int> bl;
+   bool ok{ false };
+};
+
 class WaveCache {
 public:
    WaveCache()
@@ -41,6 +80,7 @@ public:
       , max(len)
       , rms(len)
       , bl(len)
+      , pending(len)
    {
    }
 
@@ -58,6 +98,9 @@ public:
    std::vector<float> max;
    std::vector<float> rms;
    std::vector<int> bl;
+   //! For each column, zero if read, Provisional if estimated, or else the
+   //! id of the WaveFetch that reads it
+   std::vector<int> pending;
 };
 
 //
@@ -67,7 +110,7 @@ public:
 
 bool WaveClipWaveformCache::GetWaveDisplay(
    const WaveClip &clip, WaveDisplay &display, double t0,
-   double pixelsPerSecond )
+   double pixelsPerSecond, std::function<void()> onUpdate )
 {
    t0 += clip.GetTrimLeft();
 
@@ -119,6 +162,8 @@ bool WaveClipWaveformCache::GetWaveDisplay(
          display.rms = &mWaveCache->rms[0];
          display.bl = &mWaveCache->bl[0];
          display.where = &mWaveCache->where[0];
+         if (onUpdate)
+            RequestFetch(clip, std::move(onUpdate));
          return true;
       }
 
@@ -170,6 +215,8 @@ bool WaveClipWaveformCache::GetWaveDisplay(
          memcpy(&max[copyBegin], &oldCache->max[srcIdx], sizeFloats);
          memcpy(&rms[copyBegin], &oldCache->rms[srcIdx], sizeFloats);
          memcpy(&bl[copyBegin], &oldCache->bl[srcIdx], length * sizeof(int));
+         memcpy(&mWaveCache->pending[copyBegin], &oldCache->pending[srcIdx],
+            length * sizeof(int));
       }
    }
 
@@ -252,7 +299,7 @@ bool WaveClipWaveformCache::GetWaveDisplay(
 
       // Done with append buffer, now fetch the rest of the cache miss
       // from the sequence
-      if (p1 > p0) {
+      if (p1 > p0 && (allocated || !onUpdate)) {
          if (!::GetWaveDisplay(*sequence, &min[p0],
                                         &max[p0],
                                         &rms[p0],
@@ -263,8 +310,43 @@ bool WaveClipWaveformCache::GetWaveDisplay(
             return false;
          }
       }
+      else if (p1 > p0) {
+         // Read some columns at a time until the budget is spent
+         using Clock = std::chrono::steady_clock;
+         const auto deadline = Clock::now() + FetchBudget;
+         auto pp = p0;
+         while (pp < p1 && Clock::now() < deadline) {
+            const auto count = std::min(FetchChunk, p1 - pp);
+            if (!::GetWaveDisplay(*sequence, &min[pp], &max[pp], &rms[pp],
+                  &bl[pp], count, &where[pp])) {
+               if (pp == p0)
+                  return false;
+               // The remaining columns are past the end of the sequence.
+               // Repeat the last column, as one read of all columns would.
+               for (; pp < p1; ++pp) {
+                  min[pp] = min[pp - 1];
+                  max[pp] = max[pp - 1];
+                  rms[pp] = rms[pp - 1];
+                  bl[pp] = bl[pp - 1];
+               }
+               break;
+            }
+            pp += count;
+         }
+
+         if (pp < p1) {
+            // Draw the rest roughly for now
+            ::GetBlockWaveDisplay(*sequence, &min[pp], &max[pp], &rms[pp],
+               &bl[pp], p1 - pp, &where[pp]);
+            auto &pending = mWaveCache->pending;
+            std::fill(pending.begin() + pp, pending.begin() + p1, Provisional);
+         }
+      }
    }
 
+   if (!allocated && onUpdate)
+      RequestFetch(clip, std::move(onUpdate));
+
    if (!allocated) {
       // Now report the results
       display.min = min;
@@ -284,6 +366,111 @@ WaveClipWaveformCache::WaveClipWaveformCache()
 
 WaveClipWaveformCache::~WaveClipWaveformCache()
 {
+   // Don't wait for workers still reading the copies of the sequence.  Each
+   // job shares its fetch, and hands it back to the main thread to destroy
+   // the copy there, because that may delete sample blocks.
+   for (auto &pFetch : mFetches)
+      pFetch->pCache = nullptr;
+}
+
+void WaveClipWaveformCache::RequestFetch(
+   const WaveClip &clip, std::function<void()> onUpdate)
+{
+   auto &pending = mWaveCache->pending;
+   const auto first = std::find(pending.begin(), pending.end(), Provisional);
+   if (first == pending.end())
+      return;
+   const size_t p0 = first - pending.begin();
+   const size_t p1 = pending.rend() -
+      std::find(pending.rbegin(), pending.rend(), Provisional);
+   const auto len = p1 - p0;
+
+   auto pFetch = std::make_shared<WaveFetch>();
+   auto &fetch = *pFetch;
+
+   // Let the clip change while the worker reads
+   const auto &sequence = *clip.GetSequence();
+   GuardedCall( [&]{
+      fetch.pSnapshot =
+         std::make_unique<Sequence>(sequence, sequence.GetFactory());
+   }, MakeSimpleGuard(), IgnoreException );
+   if (!fetch.pSnapshot)
+      return;
+
+   fetch.pCache = this;
+   fetch.onUpdate = std::move(onUpdate);
+   fetch.id = ++mLastFetchId;
+   fetch.dirty = mDirty;
+   const auto &where = mWaveCache->where;
+   fetch.where.assign(where.begin() + p0, where.begin() + p1 + 1);
+   fetch.min.resize(len);
+   fetch.max.resize(len);
+   fetch.rms.resize(len);
+   fetch.bl.resize(len);
+
+   std::replace(pending.begin() + p0, pending.begin() + p1,
+      Provisional, fetch.id);
+   mFetches.push_back(pFetch);
+
+   // The job owns its share of the fetch, so the cache need not wait for it
+   ThreadPool::Get().Submit([pFetch]() mutable {
+      auto &fetch = *pFetch;
+      fetch.ok = GuardedCall<bool>( [&]{
+         return ::GetWaveDisplay(*fetch.pSnapshot,
+            fetch.min.data(), fetch.max.data(), fetch.rms.data(),
+            fetch.bl.data(), fetch.min.size(), fetch.where.data());
+      }, MakeSimpleGuard(false), IgnoreException );
+
+      // Give up this thread's reference, so the copy of the sequence is
+      // destroyed in the main thread
+      BasicUI::CallAfter([pFetch = std::move(pFetch)]{
+         if (pFetch->pCache)
+            pFetch->pCache->Receive(*pFetch);
+         pFetch->pSnapshot.reset();
+      });
+   });
+}
+
+void WaveClipWaveformCache::Receive(WaveFetch &fetch)
+{
+   mFetches.erase(std::remove_if(mFetches.begin(), mFetches.end(),
+      [&](const auto &pFetch){ return pFetch.get() == &fetch; }),
+      mFetches.end());
+
+   auto &cache = *mWaveCache;
+   const bool valid = fetch.ok &&
+      fetch.dirty == mDirty && cache.dirty == mDirty;
+   const auto len = fetch.min.size();
+   bool updated = false;
+
+   // The cache may have scrolled since the request; match columns by their
+   // sample positions
+   size_t jj = 0;
+   for (size_t xx = 0; xx < cache.len; ++xx) {
+      auto &flag = cache.pending[xx];
+      if (flag == 0)
+         continue;
+      if (valid) {
+         while (jj < len && fetch.where[jj] < cache.where[xx])
+            ++jj;
+         if (jj < len && fetch.where[jj] == cache.where[xx] &&
+             fetch.where[jj + 1] == cache.where[xx + 1]) {
+            cache.min[xx] = fetch.min[jj];
+            cache.max[xx] = fetch.max[jj];
+            cache.rms[xx] = fetch.rms[jj];
+            cache.bl[xx] = fetch.bl[jj];
+            flag = 0;
+            updated = true;
+            continue;
+         }
+      }
+      // Request again at the next drawing
+      if (flag == fetch.id)
+         flag = Provisional;
+   }
+
+   if (updated && fetch.onUpdate)
+      fetch.onUpdate();
 }
 
 static WaveClip::Caches::RegisteredFactory sKeyW{ []( WaveClip& ){
@@ -11,13 +11,16 @@
 #ifndef __AUDACITY_WAVEFORM_CACHE__
 #define __AUDACITY_WAVEFORM_CACHE__
 
+#include <functional>
 #include "WaveClip.h"
 
 class WaveCache;
+struct WaveFetch;
 
 struct WaveClipWaveformCache final : WaveClipListener
 {
    WaveClipWaveformCache();
+   //! Detaches background fetches, which finish without it
    ~WaveClipWaveformCache() override;
 
    // Cache of values for drawing the waveform
@@ -33,8 +36,24 @@ struct WaveClipWaveformCache final : WaveClipListener
    void Clear();
 
    /** Getting high-level data for screen display */
+   /*!
+    If onUpdate is not empty, then reading of the samples stops after a time
+    budget, and the remaining columns are estimated from whole blocks.  They
+    are read in the background, and onUpdate is called in the main thread when
+    they are cached.
+    */
    bool GetWaveDisplay(const WaveClip &clip, WaveDisplay &display,
-                       double t0, double pixelsPerSecond);
+                       double t0, double pixelsPerSecond,
+                       std::function<void()> onUpdate = {});
+
+private:
+   //! Start reading the estimated columns of mWaveCache in the background
+   void RequestFetch(const WaveClip &clip, std::function<void()> onUpdate);
+   //! Copy the results of a fetch into mWaveCache, if still valid
+   void Receive(WaveFetch &fetch);
+
+   std::vector<std::shared_ptr<WaveFetch>> mFetches;
+   int mLastFetchId{ 0 };
 };
 
 #endif
@@ -27,6 +27,7 @@ Paul Licameli split from WaveTrackView.cpp
 #include "../../../../SyncLock.h"
 #include "../../../../TrackArt.h"
 #include "../../../../TrackArtist.h"
+#include "../../../../TrackPanel.h"
 #include "../../../../TrackPanelDrawingContext.h"
 #include "../../../../TrackPanelMouseEvent.h"
 #include "ViewInfo.h"
@@ -38,6 +39,7 @@ Paul Licameli split from WaveTrackView.cpp
 
 #include <wx/graphics.h>
 #include <wx/dc.h>
+#include <wx/weakref.h>
 
 static WaveTrackSubView::Type sType{
    WaveTrackViewConstants::Waveform,
@@ -802,8 +804,19 @@ void DrawClipWaveform(TrackPanelDrawingContext &context,
          // fisheye moves over the background, there is then less to do when
          // redrawing.
 
+         // Columns not read within the time budget are drawn roughly at first,
+         // and the panel is refreshed when they have been read
+         std::function<void()> onUpdate;
+         if (artist->parent)
+            onUpdate = [pPanel = wxWeakRef<TrackPanel>{ artist->parent }]{
+               if (pPanel)
+                  pPanel->Refresh(false);
+            };
+
+         auto dataStopwatch = FrameStatistics::CreateStopwatch(
+            FrameStatistics::SectionID::WaveDataCache);
          if (!clipCache.GetWaveDisplay( *clip, display,
-            t0, pps))
+            t0, pps, std::move(onUpdate)))
             return;
       }
    }